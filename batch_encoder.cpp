@@ -0,0 +1,102 @@
+/*
+ * Batch Encoder Implementation
+ */
+
+#include "batch_encoder.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "thread_pool.h"
+
+namespace fhe_cpp {
+
+static NTT make_plain_ntt(int N, ModInt t) {
+    if (!BatchEncoder::supports(N, t)) {
+        throw std::invalid_argument("Batching requires a prime t = 1 (mod 2N)");
+    }
+    return NTT(N, t);
+}
+
+bool BatchEncoder::supports(int N, ModInt t) {
+    if (N <= 0 || (N & (N - 1)) != 0 || t < 2 || (t - 1) % (2 * (ModInt)N) != 0) {
+        return false;
+    }
+    for (ModInt d = 2; d * d <= t; d++) {
+        if (t % d == 0) return false;
+    }
+    return true;
+}
+
+BatchEncoder::BatchEncoder(int N, ModInt t)
+    : N(N), t(t), ntt_t(make_plain_ntt(N, t)), slot_to_index(N) {
+    
+    uint64_t two_n = 2 * (uint64_t)N;
+    int row = N / 2;
+    
+    // NTT index j holds the evaluation at psi^(2j+1)
+    uint64_t pos = 1;
+    for (int i = 0; i < row; i++) {
+        uint64_t neg = two_n - pos;
+        slot_to_index[i] = (int)((pos - 1) / 2);
+        slot_to_index[row + i] = (int)((neg - 1) / 2);
+        pos = (pos * 3) % two_n;
+    }
+}
+
+std::vector<ModInt> BatchEncoder::encode(const std::vector<ModInt>& values) const {
+    FHE_TIME_OP(Encode);
+    FHE_TRACE_SPAN("encode", "io");
+    if (values.size() > (size_t)N) {
+        throw std::invalid_argument("Too many values for the slot count");
+    }
+    
+    std::vector<ModInt> evals(N, 0);
+    for (size_t s = 0; s < values.size(); s++) {
+        ModInt v = values[s] % t;
+        evals[slot_to_index[s]] = v < 0 ? v + t : v;
+    }
+    ntt_t.inverse(evals);
+    return evals;
+}
+
+std::vector<ModInt> BatchEncoder::decode(const std::vector<ModInt>& poly) const {
+    FHE_TIME_OP(Decode);
+    FHE_TRACE_SPAN("decode", "io");
+    if (poly.size() != (size_t)N) {
+        throw std::invalid_argument("Input size must equal N");
+    }
+    
+    std::vector<ModInt> evals(N);
+    for (int i = 0; i < N; i++) {
+        ModInt v = poly[i] % t;
+        evals[i] = v < 0 ? v + t : v;
+    }
+    ntt_t.forward(evals);
+    
+    std::vector<ModInt> values(N);
+    for (int s = 0; s < N; s++) {
+        values[s] = evals[slot_to_index[s]];
+    }
+    return values;
+}
+
+std::vector<std::vector<ModInt>> BatchEncoder::encode_batch(
+    const std::vector<std::vector<ModInt>>& values) const {
+    
+    std::vector<std::vector<ModInt>> polys(values.size());
+    ThreadPool::global()->parallel_for(values.size(), [&](size_t i) {
+        polys[i] = encode(values[i]);
+    });
+    return polys;
+}
+
+std::vector<std::vector<ModInt>> BatchEncoder::decode_batch(
+    const std::vector<std::vector<ModInt>>& polys) const {
+    
+    std::vector<std::vector<ModInt>> values(polys.size());
+    ThreadPool::global()->parallel_for(polys.size(), [&](size_t i) {
+        values[i] = decode(polys[i]);
+    });
+    return values;
+}
+
+} // namespace fhe_cpp
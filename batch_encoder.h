@@ -0,0 +1,53 @@
+/*
+ * Batch (CRT) encoding of plaintext slots
+ * An NTT modulo the plaintext prime t maps N slot values to a polynomial,
+ * so slot-wise products of plaintexts become polynomial products
+ */
+
+#ifndef FHE_BATCH_ENCODER_H
+#define FHE_BATCH_ENCODER_H
+
+#include "ntt.h"
+#include <vector>
+
+namespace fhe_cpp {
+
+class BatchEncoder {
+private:
+    int N;              // Polynomial degree (number of slots)
+    ModInt t;           // Plaintext modulus (prime, t = 1 mod 2N)
+    NTT ntt_t;          // Negacyclic NTT modulo t
+    
+    // Slot s -> NTT index. Row 0 slot i is the evaluation at psi^(3^i),
+    // row 1 slot i at psi^(-3^i), so X -> X^(3^k) rotates both rows
+    // left by k and X -> X^(2N-1) swaps them
+    std::vector<int> slot_to_index;
+
+public:
+    BatchEncoder(int N, ModInt t);
+    ~BatchEncoder() = default;
+    
+    // Whether t admits batching for degree N (prime and t = 1 mod 2N)
+    static bool supports(int N, ModInt t);
+    
+    // Up to N slot values (row 0 first, missing slots are 0) -> polynomial
+    // with coefficients in [0, t)
+    std::vector<ModInt> encode(const std::vector<ModInt>& values) const;
+    
+    // Polynomial (coefficients taken mod t) -> N slot values in [0, t)
+    std::vector<ModInt> decode(const std::vector<ModInt>& poly) const;
+    
+    std::vector<std::vector<ModInt>> encode_batch(
+        const std::vector<std::vector<ModInt>>& values) const;
+    
+    std::vector<std::vector<ModInt>> decode_batch(
+        const std::vector<std::vector<ModInt>>& polys) const;
+    
+    int slot_count() const { return N; }
+    int row_size() const { return N / 2; }
+    ModInt get_t() const { return t; }
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_BATCH_ENCODER_H
@@ -0,0 +1,364 @@
+/*
+ * Native benchmark suite (fhe_bench)
+ * Times the NTT, pointwise and BFV kernels, encryption/decryption, an
+ * exact-match scan (both parties) without any Python in the loop, over a
+ * grid of ring sizes, modulus sizes and thread counts. Every repetition is kept
+ * so results can be compared statistically (see bench_regression.py)
+ *
+ * Usage: fhe_bench [--N 1024,4096] [--bits 30,50] [--threads 1,4]
+ *                  [--reps 20] [--warmup 3] [--rows 64] [--filter name]
+ *                  [--json out.json] [--smoke]
+ */
+
+#include "ntt.h"
+#include "bfv_mult.h"
+#include "encryptor.h"
+#include "decryptor.h"
+#include "table_scan.h"
+#include "thread_pool.h"
+#include "expr_graph.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fhe_cpp;
+
+namespace {
+
+struct Options {
+    std::vector<int> ring_sizes = {1024, 4096};
+    std::vector<int> modulus_bits = {30, 50};
+    std::vector<int> threads = {1};
+    int reps = 20;
+    int warmup = 3;
+    size_t rows = 64;
+    std::string filter;
+    std::string json_path;
+};
+
+struct Result {
+    std::string name;
+    int N;
+    int modulus_bits;
+    int threads;
+    int batch;                      // Operations per sample
+    std::vector<double> samples_ns;
+};
+
+std::vector<int> parse_list(const std::string& arg) {
+    std::vector<int> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+Options parse_args(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+            return argv[++i];
+        };
+        if (arg == "--N") opt.ring_sizes = parse_list(value());
+        else if (arg == "--bits") opt.modulus_bits = parse_list(value());
+        else if (arg == "--threads") opt.threads = parse_list(value());
+        else if (arg == "--reps") opt.reps = std::stoi(value());
+        else if (arg == "--warmup") opt.warmup = std::stoi(value());
+        else if (arg == "--rows") opt.rows = (size_t)std::stoul(value());
+        else if (arg == "--filter") opt.filter = value();
+        else if (arg == "--json") opt.json_path = value();
+        else if (arg == "--smoke") {
+            opt.ring_sizes = {1024};
+            opt.modulus_bits = {40};
+            opt.threads = {1, 2};
+            opt.reps = 2;
+            opt.warmup = 0;
+            opt.rows = 4;
+        } else {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+    return opt;
+}
+
+double percentile(std::vector<double> v, double p) {
+    std::sort(v.begin(), v.end());
+    double pos = p * (v.size() - 1);
+    size_t lo = (size_t)pos;
+    size_t hi = std::min(lo + 1, v.size() - 1);
+    return v[lo] + (v[hi] - v[lo]) * (pos - lo);
+}
+
+double mean(const std::vector<double>& v) {
+    double sum = 0;
+    for (double x : v) sum += x;
+    return sum / v.size();
+}
+
+double stddev(const std::vector<double>& v) {
+    if (v.size() < 2) return 0.0;
+    double m = mean(v);
+    double sum = 0;
+    for (double x : v) sum += (x - m) * (x - m);
+    return std::sqrt(sum / (v.size() - 1));
+}
+
+std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(colon + 2);
+        }
+    }
+    return "unknown";
+}
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+// Times `batch` calls of op(worker) per sample, spread over the pool's
+// workers when there is more than one thread
+std::vector<double> measure(const Options& opt, ThreadPool* pool, int batch,
+                            const std::function<void(size_t)>& op) {
+    auto run = [&]() {
+        if (pool != nullptr) {
+            pool->parallel_for((size_t)batch, op);
+        } else {
+            for (int i = 0; i < batch; i++) op((size_t)i);
+        }
+    };
+    
+    for (int i = 0; i < opt.warmup; i++) run();
+    
+    std::vector<double> samples;
+    samples.reserve(opt.reps);
+    for (int i = 0; i < opt.reps; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        samples.push_back((double)std::chrono::duration_cast<
+            std::chrono::nanoseconds>(elapsed).count());
+    }
+    return samples;
+}
+
+// Runs every benchmark for one (N, modulus bits, threads) point
+void run_point(const Options& opt, int N, int bits, int threads, std::vector<Result>& results) {
+    const ModInt t = 65537;
+    ModInt q = find_ntt_prime(N, bits);
+    BFVMultiplier mult(N, q, t);
+    const NTT& ntt = mult.get_ntt();
+    
+    KeyGenerator keygen(ntt, 3.2, 1);
+    auto pk = keygen.public_key();
+    auto rk = keygen.relin_key();
+    Decryptor decryptor(ntt, t, keygen.secret_key());
+    
+    // Per-worker state: kernels run on private buffers, encryptors own RNGs
+    std::vector<std::unique_ptr<Encryptor>> encryptors;
+    std::vector<std::vector<ModInt>> buffers;
+    for (int w = 0; w < threads; w++) {
+        encryptors.push_back(std::make_unique<Encryptor>(ntt, t, pk, 3.2, 100 + w));
+        buffers.push_back(PolySampler(N, q, 3.2, 200 + w).uniform());
+    }
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1) pool = std::make_unique<ThreadPool>(threads);
+    
+    std::vector<ModInt> plain(N);
+    for (int i = 0; i < N; i++) plain[i] = i % t;
+    auto ct_a = encryptors[0]->encrypt(plain);
+    auto ct_b = encryptors[0]->encrypt(plain);
+    auto ct_a_ntt = ct_a;
+    auto ct_b_ntt = ct_b;
+    for (auto& c : ct_a_ntt) ntt.forward(c);
+    for (auto& c : ct_b_ntt) ntt.forward(c);
+    auto ct3 = mult.multiply_ciphertexts(ct_a[0], ct_a[1], ct_b[0], ct_b[1]);
+    
+    auto add = [&](const std::string& name, const std::function<void(size_t)>& op) {
+        if (!opt.filter.empty() && name.find(opt.filter) == std::string::npos) return;
+        Result r{name, N, bits, threads, threads, {}};
+        r.samples_ns = measure(opt, pool.get(), threads, op);
+        results.push_back(r);
+        
+        double med = percentile(r.samples_ns, 0.5);
+        std::printf("%-26s N=%-6d bits=%-3d threads=%-3d median %12.1f us  (%.1f ops/s)\n",
+                    name.c_str(), N, bits, threads, med / 1000.0, threads * 1e9 / med);
+    };
+    
+    add("ntt_forward", [&](size_t w) { ntt.forward(buffers[w % threads]); });
+    add("ntt_inverse", [&](size_t w) { ntt.inverse(buffers[w % threads]); });
+    for (int v = (int)NttVariant::Reference; v < (int)NttVariant::Count; v++) {
+        auto variant = std::make_shared<NTT>(N, q, (NttVariant)v);
+        add(std::string("ntt_forward_") + ntt_variant_name((NttVariant)v),
+            [&, variant](size_t w) { variant->forward(buffers[w % threads]); });
+    }
+    add("pointwise_multiply", [&](size_t) { ntt.pointwise_multiply(ct_a_ntt[0], ct_b_ntt[0]); });
+    add("multiply_ciphertexts", [&](size_t) {
+        mult.multiply_ciphertexts(ct_a[0], ct_a[1], ct_b[0], ct_b[1]);
+    });
+    add("multiply_ciphertexts_ntt", [&](size_t) {
+        mult.multiply_ciphertexts_ntt(ct_a, ct_a_ntt, ct_b, ct_b_ntt);
+    });
+    add("relinearize", [&](size_t) { mult.relinearize(ct3[0], ct3[1], ct3[2], rk); });
+    add("encrypt", [&](size_t w) { encryptors[w % threads]->encrypt(plain); });
+    add("decrypt", [&](size_t) { decryptor.decrypt(ct_a); });
+    
+    // The same small query, op by op and through the lazy planner:
+    // (relin(a*b) + relin(a*a) + 1) * plain
+    add("query_eager", [&](size_t) {
+        auto ab = mult.multiply_ciphertexts(ct_a[0], ct_a[1], ct_b[0], ct_b[1]);
+        auto aa = mult.multiply_ciphertexts(ct_a[0], ct_a[1], ct_a[0], ct_a[1]);
+        auto sum = mult.add_ciphertexts(mult.relinearize(ab[0], ab[1], ab[2], rk),
+                                        mult.relinearize(aa[0], aa[1], aa[2], rk));
+        mult.multiply_plain(mult.add_scalar(sum, 1), plain);
+    });
+    auto lazy_query = [&]() {
+        ExprGraph graph(mult);
+        graph.set_relin_key(rk);
+        size_t a = graph.input(ct_a);
+        size_t b = graph.input(ct_b);
+        size_t sum = graph.add(graph.relinearize(graph.multiply(a, b)),
+                               graph.relinearize(graph.multiply(a, a)));
+        graph.evaluate(graph.multiply_plain(graph.add_scalar(sum, 1), plain));
+        return graph.stats();
+    };
+    add("query_lazy", [&](size_t) { lazy_query(); });
+    
+    // Both paths do the same arithmetic except for what the plan saves, so
+    // the gap is the merged relinearization plus the shared transforms
+    if (opt.filter.empty() || std::string("query_lazy").find(opt.filter) != std::string::npos) {
+        ExprStats stats = lazy_query();
+        std::printf("  query_lazy plan: %zu of %zu relinearizations run, %zu forward / "
+                    "%zu inverse NTTs, %zu kernels for %zu nodes\n",
+                    stats.relinearizations, stats.relinearizations + stats.relinearizations_saved,
+                    stats.forward_ntts, stats.inverse_ntts, stats.steps, stats.nodes);
+    }
+    
+    // Exact-match queries over opt.rows encrypted rows (key = payload =
+    // row mod t); exactly one row matches the target
+    std::string scan = "exact_match_scan";
+    if (!opt.filter.empty() && scan.find(opt.filter) == std::string::npos) return;
+    
+    TableScanner scanner(mult, threads);
+    for (size_t row = 0; row < opt.rows; row++) {
+        std::vector<ModInt> key(N, 0);
+        key[0] = (ModInt)(row % t);
+        auto ct = encryptors[0]->encrypt(key);
+        scanner.add_row(ct, ct);
+    }
+    std::vector<ModInt> target(N, 0);
+    target[0] = (ModInt)(opt.rows / 2);
+    
+    auto report = [&](const std::string& name, const std::function<void(size_t)>& op) {
+        Result r{name, N, bits, threads, 1, {}};
+        r.samples_ns = measure(opt, nullptr, 1, op);
+        results.push_back(r);
+        
+        double med = percentile(r.samples_ns, 0.5);
+        std::printf("%-26s N=%-6d bits=%-3d threads=%-3d median %12.1f us  (%.1f rows/s)\n",
+                    name.c_str(), N, bits, threads, med / 1000.0, opt.rows * 1e9 / med);
+    };
+    
+    // Encrypt the target, subtract it from every key and decrypt every
+    // difference (the client's side of the plain protocol)
+    report(scan, [&](size_t) {
+        auto query = encryptors[0]->encrypt(target);
+        size_t matches = 0;
+        scanner.exact_match_batch({query}, [&](size_t, auto& diffs) {
+            if (decryptor.decrypt(diffs[0])[0] == 0) matches++;
+        });
+        if (matches == 0) std::fprintf(stderr, "warning: exact match found no row\n");
+    });
+}
+
+void write_json(const Options& opt, const std::vector<Result>& results, const std::string& path) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot open " + path);
+    
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"cpu_model\": \"" << json_escape(cpu_model()) << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"compiler\": \"" << json_escape(__VERSION__) << "\",\n"
+        << "    \"instrumentation\": " << (Instrumentation::compiled_in() ? "true" : "false") << ",\n"
+        << "    \"reps\": " << opt.reps << ",\n"
+        << "    \"warmup\": " << opt.warmup << ",\n"
+        << "    \"rows\": " << opt.rows << "\n"
+        << "  },\n  \"benchmarks\": [\n";
+    
+    out.precision(1);
+    out << std::fixed;
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        double med = percentile(r.samples_ns, 0.5);
+        out << "    {\"name\": \"" << r.name << "\", \"N\": " << r.N
+            << ", \"modulus_bits\": " << r.modulus_bits << ", \"threads\": " << r.threads
+            << ", \"batch\": " << r.batch
+            << ", \"median_ns\": " << med
+            << ", \"mean_ns\": " << mean(r.samples_ns)
+            << ", \"min_ns\": " << *std::min_element(r.samples_ns.begin(), r.samples_ns.end())
+            << ", \"max_ns\": " << *std::max_element(r.samples_ns.begin(), r.samples_ns.end())
+            << ", \"stddev_ns\": " << stddev(r.samples_ns)
+            << ", \"samples_ns\": [";
+        for (size_t s = 0; s < r.samples_ns.size(); s++) {
+            out << (s ? ", " : "") << r.samples_ns[s];
+        }
+        out << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options opt = parse_args(argc, argv);
+        if (opt.reps < 1) throw std::invalid_argument("--reps must be at least 1");
+        
+        std::vector<Result> results;
+        for (int N : opt.ring_sizes) {
+            for (int bits : opt.modulus_bits) {
+                for (int threads : opt.threads) {
+                    run_point(opt, N, bits, std::max(1, threads), results);
+                }
+            }
+        }
+        
+        if (!opt.json_path.empty()) {
+            write_json(opt, results, opt.json_path);
+            std::printf("Wrote %zu results to %s\n", results.size(), opt.json_path.c_str());
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "fhe_bench: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
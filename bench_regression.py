@@ -0,0 +1,302 @@
+"""
+Benchmark regression harness
+Runs the native fhe_bench suite, stores results keyed by git revision and
+CPU model, and compares a run against a stored baseline using medians and
+bootstrap confidence intervals over the per-repetition samples
+
+Usage:
+    python bench_regression.py run [--bench PATH] [-- fhe_bench args...]
+    python bench_regression.py compare --baseline REV [--candidate REV]
+                                       [--markdown report.md] [--json report.json]
+    python bench_regression.py list
+
+Everything is local: results live under .bench_results/<cpu>/<rev>.json
+"""
+
+import argparse
+import json
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_STORE = os.path.join(ROOT, '.bench_results')
+DEFAULT_BENCH_PATHS = [
+    os.path.join(ROOT, '_gate_build', 'fhe_bench'),
+    os.path.join(ROOT, 'build', 'fhe_bench'),
+]
+
+
+def git_revision():
+    """Short hash of HEAD, with a -dirty suffix for uncommitted changes"""
+    try:
+        rev = subprocess.check_output(['git', 'rev-parse', '--short', 'HEAD'],
+                                      cwd=ROOT, text=True).strip()
+        dirty = subprocess.call(['git', 'diff', '--quiet', 'HEAD'], cwd=ROOT) != 0
+        return rev + ('-dirty' if dirty else '')
+    except (OSError, subprocess.CalledProcessError):
+        return 'unknown'
+
+
+def resolve_revision(rev):
+    """Short hash for a ref name (HEAD~1, a tag, ...); stored names pass through"""
+    try:
+        return subprocess.check_output(['git', 'rev-parse', '--short', rev], cwd=ROOT,
+                                       text=True, stderr=subprocess.DEVNULL).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return rev
+
+
+def cpu_slug(cpu_model):
+    """Filesystem-safe directory name for a CPU model string"""
+    return re.sub(r'[^A-Za-z0-9]+', '_', cpu_model).strip('_') or 'unknown'
+
+
+def result_path(store, cpu_model, rev):
+    return os.path.join(store, cpu_slug(cpu_model), rev + '.json')
+
+
+def find_bench(path=None):
+    candidates = [path] if path else DEFAULT_BENCH_PATHS
+    for candidate in candidates:
+        if candidate and os.path.exists(candidate):
+            return candidate
+    raise FileNotFoundError(
+        "fhe_bench not found; build it with cmake (see BUILD_INSTRUCTIONS.md) "
+        "or pass --bench")
+
+
+def run_suite(bench, bench_args):
+    """Run fhe_bench and return its parsed JSON output"""
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, 'bench.json')
+        subprocess.check_call([bench] + list(bench_args) + ['--json', out])
+        with open(out) as f:
+            return json.load(f)
+
+
+def load_result(store, rev, cpu_model=None):
+    """Stored result for rev; any CPU directory when cpu_model is None"""
+    if cpu_model is not None:
+        path = result_path(store, cpu_model, rev)
+        if os.path.exists(path):
+            with open(path) as f:
+                return json.load(f)
+    elif os.path.isdir(store):
+        for cpu_dir in sorted(os.listdir(store)):
+            path = os.path.join(store, cpu_dir, rev + '.json')
+            if os.path.exists(path):
+                with open(path) as f:
+                    return json.load(f)
+    raise FileNotFoundError(f"No stored results for revision {rev}")
+
+
+def median(values):
+    s = sorted(values)
+    n = len(s)
+    mid = n // 2
+    return s[mid] if n % 2 else (s[mid - 1] + s[mid]) / 2
+
+
+def bootstrap_ratio_ci(base, cand, iterations=2000, confidence=0.95, seed=0):
+    """
+    Bootstrap CI of median(cand) / median(base) - 1
+
+    Both sample sets are resampled with replacement; the interval is the
+    percentile interval of the resampled relative change
+    """
+    rng = random.Random(seed)
+    changes = []
+    for _ in range(iterations):
+        b = median([rng.choice(base) for _ in base])
+        c = median([rng.choice(cand) for _ in cand])
+        if b > 0:
+            changes.append(c / b - 1.0)
+    changes.sort()
+    alpha = (1.0 - confidence) / 2
+    lo = changes[int(alpha * (len(changes) - 1))]
+    hi = changes[int((1 - alpha) * (len(changes) - 1))]
+    return lo, hi
+
+
+def bench_key(b):
+    return (b['name'], b['N'], b['modulus_bits'], b['threads'])
+
+
+def compare(baseline, candidate, threshold=0.05, confidence=0.95, iterations=2000):
+    """
+    Per-benchmark comparison of two fhe_bench results
+
+    A benchmark is a regression (improvement) when the whole confidence
+    interval of the relative change in median time lies above (below) zero
+    and the median change exceeds the threshold; otherwise it is unchanged
+    """
+    base_by_key = {bench_key(b): b for b in baseline['benchmarks']}
+    rows = []
+    for cand in candidate['benchmarks']:
+        base = base_by_key.get(bench_key(cand))
+        if base is None:
+            continue
+        base_med = median(base['samples_ns'])
+        cand_med = median(cand['samples_ns'])
+        change = cand_med / base_med - 1.0 if base_med > 0 else 0.0
+        lo, hi = bootstrap_ratio_ci(base['samples_ns'], cand['samples_ns'],
+                                    iterations, confidence)
+        if lo > 0 and change > threshold:
+            verdict = 'regression'
+        elif hi < 0 and change < -threshold:
+            verdict = 'improvement'
+        else:
+            verdict = 'unchanged'
+        rows.append({
+            'name': cand['name'],
+            'N': cand['N'],
+            'modulus_bits': cand['modulus_bits'],
+            'threads': cand['threads'],
+            'baseline_median_ns': base_med,
+            'candidate_median_ns': cand_med,
+            'change': change,
+            'ci_low': lo,
+            'ci_high': hi,
+            'baseline_reps': len(base['samples_ns']),
+            'candidate_reps': len(cand['samples_ns']),
+            'verdict': verdict,
+        })
+    return {
+        'baseline': baseline.get('revision'),
+        'candidate': candidate.get('revision'),
+        'baseline_cpu': baseline['context'].get('cpu_model'),
+        'candidate_cpu': candidate['context'].get('cpu_model'),
+        'threshold': threshold,
+        'confidence': confidence,
+        'results': rows,
+    }
+
+
+def markdown_report(report):
+    """Render a comparison as a markdown table"""
+    lines = [
+        f"## Benchmark comparison: {report['candidate']} vs {report['baseline']}",
+        "",
+        f"CPU: {report['candidate_cpu']}",
+    ]
+    if report['baseline_cpu'] != report['candidate_cpu']:
+        lines.append(f"**Warning:** baseline was recorded on {report['baseline_cpu']}")
+    lines += [
+        "",
+        f"Change in median time with {report['confidence']:.0%} bootstrap CI; "
+        f"threshold {report['threshold']:.0%}.",
+        "",
+        "| Benchmark | N | bits | threads | baseline (us) | candidate (us) | change | CI | verdict |",
+        "|---|---:|---:|---:|---:|---:|---:|---|---|",
+    ]
+    marks = {'regression': 'REGRESSION', 'improvement': 'improved', 'unchanged': ''}
+    for r in report['results']:
+        lines.append(
+            f"| {r['name']} | {r['N']} | {r['modulus_bits']} | {r['threads']} "
+            f"| {r['baseline_median_ns'] / 1e3:.1f} | {r['candidate_median_ns'] / 1e3:.1f} "
+            f"| {r['change']:+.1%} | [{r['ci_low']:+.1%}, {r['ci_high']:+.1%}] "
+            f"| {marks[r['verdict']]} |")
+    counts = {v: sum(1 for r in report['results'] if r['verdict'] == v) for v in marks}
+    lines += ["", f"{counts['regression']} regressions, {counts['improvement']} improvements, "
+                  f"{counts['unchanged']} unchanged"]
+    return "\n".join(lines) + "\n"
+
+
+def cmd_run(args):
+    bench = find_bench(args.bench)
+    result = run_suite(bench, args.bench_args)
+    rev = args.revision or git_revision()
+    result['revision'] = rev
+    result['bench_args'] = args.bench_args
+
+    path = result_path(args.store, result['context']['cpu_model'], rev)
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, 'w') as f:
+        json.dump(result, f, indent=1)
+    print(f"Stored {len(result['benchmarks'])} results for {rev} at {path}")
+    return 0
+
+
+def cmd_compare(args):
+    if args.candidate:
+        candidate = load_result(args.store, resolve_revision(args.candidate))
+    else:
+        candidate = run_suite(find_bench(args.bench), args.bench_args)
+        candidate['revision'] = git_revision()
+
+    # Prefer a baseline recorded on the same CPU model
+    baseline_rev = resolve_revision(args.baseline)
+    try:
+        baseline = load_result(args.store, baseline_rev, candidate['context']['cpu_model'])
+    except FileNotFoundError:
+        baseline = load_result(args.store, baseline_rev)
+
+    report = compare(baseline, candidate, args.threshold, args.confidence, args.iterations)
+    text = markdown_report(report)
+    print(text)
+    if args.markdown:
+        with open(args.markdown, 'w') as f:
+            f.write(text)
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(report, f, indent=1)
+
+    regressions = sum(1 for r in report['results'] if r['verdict'] == 'regression')
+    return 1 if (args.fail_on_regression and regressions) else 0
+
+
+def cmd_list(args):
+    if not os.path.isdir(args.store):
+        print("No stored results")
+        return 0
+    for cpu_dir in sorted(os.listdir(args.store)):
+        print(cpu_dir)
+        for name in sorted(os.listdir(os.path.join(args.store, cpu_dir))):
+            if name.endswith('.json'):
+                print(f"  {name[:-5]}")
+    return 0
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="fhe_bench regression harness")
+    parser.add_argument('--store', default=DEFAULT_STORE, help="Results directory")
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    run = sub.add_parser('run', help="Run the suite and store the result")
+    run.add_argument('--bench', help="Path to fhe_bench")
+    run.add_argument('--revision', help="Store under this name instead of the git revision")
+    run.add_argument('bench_args', nargs=argparse.REMAINDER,
+                     help="Arguments passed to fhe_bench (after --)")
+    run.set_defaults(func=cmd_run)
+
+    cmp = sub.add_parser('compare', help="Compare against a stored baseline")
+    cmp.add_argument('--baseline', required=True, help="Baseline revision")
+    cmp.add_argument('--candidate', help="Stored candidate revision (default: run now)")
+    cmp.add_argument('--bench', help="Path to fhe_bench")
+    cmp.add_argument('--threshold', type=float, default=0.05,
+                     help="Minimum relative change to report (default 0.05)")
+    cmp.add_argument('--confidence', type=float, default=0.95)
+    cmp.add_argument('--iterations', type=int, default=2000, help="Bootstrap resamples")
+    cmp.add_argument('--markdown', help="Write the markdown report here")
+    cmp.add_argument('--json', help="Write the JSON report here")
+    cmp.add_argument('--fail-on-regression', action='store_true',
+                     help="Exit with status 1 if any benchmark regressed")
+    cmp.add_argument('bench_args', nargs=argparse.REMAINDER,
+                     help="Arguments passed to fhe_bench (after --)")
+    cmp.set_defaults(func=cmd_compare)
+
+    lst = sub.add_parser('list', help="List stored results")
+    lst.set_defaults(func=cmd_list)
+
+    args = parser.parse_args(argv)
+    if getattr(args, 'bench_args', None) and args.bench_args[0] == '--':
+        args.bench_args = args.bench_args[1:]
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -3,9 +3,13 @@ Enhanced BFV Scheme with C++ Accelerated Multiplication
 Integrates NTT-based multiplication from C++ backend
 """
 
+import asyncio
+import contextlib
+import struct
 import numpy as np
 from custom_fhe.bfv_scheme import BFVScheme as BaseBFVScheme
-from custom_fhe.ciphertext import Ciphertext
+from custom_fhe.ciphertext import Ciphertext, Plaintext
+from custom_fhe.keys import RelinearizationKey
 
 try:
     import fhe_fast_mult
@@ -22,26 +26,55 @@ class BFVSchemeAccelerated(BaseBFVScheme):
     Falls back to Python implementation if C++ not available
     """
     
-    def __init__(self, N=8192, t=65537, q_bits=60, sigma=3.2, use_cpp=True):
+    def __init__(self, N=8192, t=65537, q_bits=60, sigma=3.2, use_cpp=True, ntt_bits=None,
+                 decomp_bits=16):
         """
         Initialize with option to use C++ acceleration
         
         Args:
             use_cpp: Use C++ backend if available (default: True)
+            ntt_bits: Size of the NTT prime (default: the smallest prime
+                      q = 1 mod 2N)
+            decomp_bits: Key-switching digit size in bits (0: no decomposition)
         """
         super().__init__(N, t, q_bits, sigma)
         
         self.use_cpp = use_cpp and CPP_AVAILABLE
+        self.decomp_bits = decomp_bits
         
         if self.use_cpp:
             # Find NTT-friendly prime
-            self.q_ntt = fhe_fast_mult.find_ntt_prime(N)
+            self.q_ntt = fhe_fast_mult.find_ntt_prime(N, ntt_bits or 0)
             
             # Initialize C++ multiplier
             try:
-                self.cpp_mult = fhe_fast_mult.BFVMultiplier(N, self.q_ntt, t)
+                self.cpp_mult = fhe_fast_mult.BFVMultiplier(N, self.q_ntt, t, decomp_bits)
                 self.cpp_ntt = fhe_fast_mult.NTT(N, self.q_ntt)
                 
+                # Interpolated lookup tables, keyed by table contents
+                self._lookup_cache = {}
+                
+                # String matchers, keyed by (string_len, char_range)
+                self._string_matchers = {}
+                
+                # Slot rotations
+                self.cpp_galois = fhe_fast_mult.GaloisTool(N, self.q_ntt)
+                self.cpp_galois_keys = None
+                
+                # SIMD slot encoding when t is a batching prime
+                if fhe_fast_mult.BatchEncoder.supports(N, t):
+                    self.cpp_encoder = fhe_fast_mult.BatchEncoder(N, t)
+                    self.n_slots = N
+                else:
+                    self.cpp_encoder = None
+                
+                # Native decryption per modulus, built for the current secret key
+                self._decryptors = {}
+                self._decryptor_key = None
+                
+                # Analytical noise tracking, with the key-switching base in use
+                self.cpp_noise = fhe_fast_mult.NoiseModel(N, self.q_ntt, t, sigma, decomp_bits)
+                
                 # Update q to NTT-friendly value
                 self.q = self.q_ntt
                 self.poly_ring.q = self.q_ntt
@@ -55,6 +88,304 @@ class BFVSchemeAccelerated(BaseBFVScheme):
                 print(f"  Falling back to Python implementation")
                 self.use_cpp = False
     
+    def encode(self, values):
+        """
+        Encode integers into SIMD slots (batch encoding modulo t)
+        A single integer is encoded as a constant, i.e. into every slot
+        
+        Args:
+            values: Integer or array of up to N integers (row 0 first)
+        
+        Returns:
+            Plaintext object
+        """
+        if not self.use_cpp or self.cpp_encoder is None \
+                or isinstance(values, (int, np.integer)):
+            return super().encode(values)
+        
+        values = np.array(values, dtype=np.int64)
+        if len(values) > self.n_slots:
+            raise ValueError(f"Too many values ({len(values)}) for slots ({self.n_slots})")
+        
+        poly = self.cpp_encoder.encode(values % self.t)
+        return Plaintext(poly, params={'N': self.N, 't': self.t, 'q': self.q})
+    
+    def decode(self, plaintext, num_values=1):
+        """
+        Decode SIMD slots (centered around 0)
+        
+        Args:
+            plaintext: Plaintext object
+            num_values: Number of slots to decode
+        
+        Returns:
+            Integer or array of integers
+        """
+        if not self.use_cpp or self.cpp_encoder is None:
+            return super().decode(plaintext, num_values)
+        
+        slots = self.cpp_encoder.decode(np.array(plaintext.get_poly(), dtype=np.int64))
+        slots = self.poly_ring.mod_center(slots % self.t)
+        
+        if num_values == 1:
+            return int(slots[0])
+        return slots[:num_values]
+    
+    def encode_coeff(self, values):
+        """Coefficient encoding (values in the first coefficients)"""
+        return super().encode(values)
+    
+    def decode_coeff(self, plaintext, num_values=1):
+        """Read coefficients instead of slots (e.g. inner_product_coeff results)"""
+        return super().decode(plaintext, num_values)
+    
+    def encode_batch(self, value_lists):
+        """Slot-encode many vectors in one native call"""
+        if not self.use_cpp or self.cpp_encoder is None:
+            return [self.encode(v) for v in value_lists]
+        
+        polys = self.cpp_encoder.encode_batch(
+            [np.array(v, dtype=np.int64) % self.t for v in value_lists])
+        params = {'N': self.N, 't': self.t, 'q': self.q}
+        return [Plaintext(p, params=params) for p in polys]
+    
+    def decode_batch(self, plaintexts, num_values=None):
+        """Decode many plaintexts in one native call; all slots by default"""
+        if not self.use_cpp or self.cpp_encoder is None:
+            return [self.decode(pt, num_values or self.n_slots) for pt in plaintexts]
+        
+        slots = self.cpp_encoder.decode_batch(
+            [np.array(pt.get_poly(), dtype=np.int64) for pt in plaintexts])
+        return [self.poly_ring.mod_center(s % self.t)[:num_values or self.N] for s in slots]
+    
+    @classmethod
+    def from_plan(cls, plan, sigma=3.2):
+        """
+        Scheme for a ParameterPlan (see plan_parameters)
+        
+        Only single-prime plans can run here: the backend has no RNS
+        arithmetic, so plans above 60 bits of modulus are rejected. The
+        plan's decomposition base is used for relinearization and Galois
+        keys, which the planned noise budget assumes
+        """
+        if len(plan.moduli) != 1:
+            raise ValueError(f"Plan needs {len(plan.moduli)} RNS primes; "
+                             f"only single-prime moduli are supported")
+        return cls(plan.N, plan.t, plan.modulus_bits, sigma,
+                   use_cpp=True, ntt_bits=plan.modulus_bits, decomp_bits=plan.decomp_bits)
+    
+    def _native_decryptor(self, q=None):
+        """Decryptor for the current secret key at modulus q (rebuilt after keygen)"""
+        if self.secret_key is None:
+            raise ValueError("Must generate keys first")
+        if self._decryptor_key is not self.secret_key:
+            self._decryptors = {}
+            self._decryptor_key = self.secret_key
+        
+        q = q or self.q
+        if q not in self._decryptors:
+            ntt = self.cpp_ntt if q == self.q else fhe_fast_mult.NTT(self.N, q)
+            s = self.poly_ring.mod_center(
+                np.array(self.secret_key.get_polynomial(), dtype=np.int64) % self.q) % q
+            self._decryptors[q] = fhe_fast_mult.Decryptor(ntt, self.t, s)
+        return self._decryptors[q]
+    
+    def _modulus_of(self, ct):
+        """Modulus a ciphertext currently lives at (after mod_switch_to)"""
+        if ct.params and 'q' in ct.params:
+            return ct.params['q']
+        return self.q
+    
+    def decrypt(self, ciphertext):
+        """
+        Decrypt with the NTT-form secret key and exact integer rounding
+        
+        Args:
+            ciphertext: Ciphertext object (size-2 or size-3)
+        
+        Returns:
+            Plaintext object
+        """
+        if not self.use_cpp:
+            return super().decrypt(ciphertext)
+        
+        q = self._modulus_of(ciphertext)
+        ct = tuple(np.array(c, dtype=np.int64) % q for c in ciphertext.get_components())
+        m = self._native_decryptor(q).decrypt(ct)
+        return Plaintext(m, params={'N': self.N, 't': self.t, 'q': self.q})
+    
+    def decrypt_batch(self, ciphertexts):
+        """Decrypt many ciphertexts in one native call"""
+        if not self.use_cpp:
+            return [super(BFVSchemeAccelerated, self).decrypt(ct) for ct in ciphertexts]
+        
+        # One native call per modulus present in the batch
+        by_modulus = {}
+        for i, ct in enumerate(ciphertexts):
+            by_modulus.setdefault(self._modulus_of(ct), []).append(i)
+        
+        params = {'N': self.N, 't': self.t, 'q': self.q}
+        results = [None] * len(ciphertexts)
+        for q, indices in by_modulus.items():
+            cts = [tuple(np.array(c, dtype=np.int64) % q for c in ciphertexts[i].get_components())
+                   for i in indices]
+            for i, m in zip(indices, self._native_decryptor(q).decrypt_batch(cts)):
+                results[i] = Plaintext(m, params=params)
+        return results
+    
+    def _tracked(self, *cts):
+        """Noise estimates of the inputs, or None if any is untracked"""
+        if not self.use_cpp:
+            return None
+        noises = [ct.noise for ct in cts]
+        return None if any(v is None for v in noises) else noises
+    
+    def _polynomial_noise(self, v, degree):
+        """Noise after evaluating a degree-d polynomial (depth ceil(log2 d))"""
+        nm = self.cpp_noise
+        for _ in range(max(1, int(np.ceil(np.log2(max(degree, 2)))))):
+            v = nm.relinearize(nm.multiply(v, v))
+        return (degree + 1) * nm.multiply_scalar(v, self.t / 2)
+    
+    def noise_budget(self, ct):
+        """Exact bits of noise budget left (needs the secret key)"""
+        if not self.use_cpp:
+            raise RuntimeError("Noise budgets require the C++ backend")
+        
+        q = self._modulus_of(ct)
+        comps = tuple(np.array(c, dtype=np.int64) % q for c in ct.get_components())
+        return self._native_decryptor(q).invariant_noise_budget(comps)
+    
+    def mod_switch_to(self, ct, bits=None, min_budget=1.0):
+        """
+        Switch a ciphertext to a smaller NTT prime, e.g. before returning it
+        
+        Args:
+            ct: Ciphertext object
+            bits: Size of the target prime; by default the smallest that
+                  keeps min_budget bits according to the tracked noise
+            min_budget: Budget to keep when choosing bits
+        
+        Returns:
+            Ciphertext at the new modulus (params['q'] updated); decrypt
+            and serialize_ciphertext handle it, evaluator ops do not
+        """
+        if not self.use_cpp:
+            raise RuntimeError("Modulus switching requires the C++ backend")
+        if bits is None:
+            if ct.noise is None:
+                raise ValueError("Untracked noise: pass bits explicitly")
+            bits = self.cpp_noise.min_modulus_bits(ct.noise, min_budget)
+        
+        q_from = self._modulus_of(ct)
+        q_to = fhe_fast_mult.find_ntt_prime(self.N, bits)
+        if q_to >= q_from:
+            return ct
+        
+        comps = fhe_fast_mult.mod_switch(
+            tuple(np.array(c, dtype=np.int64) for c in ct.get_components()), q_from, q_to)
+        params = dict(ct.params or {'N': self.N, 't': self.t})
+        params['q'] = q_to
+        noise = self.cpp_noise.mod_switch(ct.noise, q_to) if ct.noise is not None else None
+        return Ciphertext(list(comps), params=params, noise=noise)
+    
+    def serialize_ciphertext(self, ct):
+        """Pack a ciphertext at ceil(log2 q) bits per coefficient"""
+        q = self._modulus_of(ct)
+        comps = tuple(np.array(c, dtype=np.int64) for c in ct.get_components())
+        header = struct.pack('<QB', q, len(comps))
+        return header + fhe_fast_mult.pack_ciphertext(comps, q)
+    
+    def deserialize_ciphertext(self, data):
+        """Inverse of serialize_ciphertext"""
+        q, size = struct.unpack_from('<QB', data)
+        comps = fhe_fast_mult.unpack_ciphertext(data[struct.calcsize('<QB'):], self.N, size, q)
+        return Ciphertext(list(comps), params={'N': self.N, 't': self.t, 'q': q})
+    
+    def estimated_noise_budget(self, ct):
+        """Bits of budget left according to the tracked estimate (None if untracked)"""
+        if not self.use_cpp or ct.noise is None:
+            return None
+        return self.cpp_noise.budget(ct.noise)
+    
+    def encrypt(self, plaintext):
+        ct = super().encrypt(plaintext)
+        if self.use_cpp:
+            ct.noise = self.cpp_noise.fresh()
+        return ct
+    
+    def add(self, ct1, ct2):
+        result = super().add(ct1, ct2)
+        noises = self._tracked(ct1, ct2)
+        if noises:
+            result.noise = self.cpp_noise.add(*noises)
+        return result
+    
+    def sub(self, ct1, ct2):
+        result = super().sub(ct1, ct2)
+        noises = self._tracked(ct1, ct2)
+        if noises:
+            result.noise = self.cpp_noise.add(*noises)
+        return result
+    
+    def negate(self, ciphertext):
+        result = super().negate(ciphertext)
+        result.noise = ciphertext.noise
+        return result
+    
+    def multiply_plain(self, ciphertext, plaintext):
+        if not self.use_cpp:
+            return super().multiply_plain(ciphertext, plaintext)
+        
+        # Native product: the int64 convolution of the Python ring overflows
+        # for moduli above ~31 bits, and centering halves the noise growth
+        comps = self.cpp_mult.multiply_plain(
+            tuple(np.array(c, dtype=np.int64) for c in ciphertext.get_components()),
+            np.array(plaintext.get_poly(), dtype=np.int64))
+        
+        noises = self._tracked(ciphertext)
+        noise = self.cpp_noise.multiply_plain(noises[0]) if noises else None
+        return Ciphertext(list(comps), params=ciphertext.params, noise=noise)
+    
+    def generate_relin_key(self):
+        """
+        Generate the relinearization key, one (b_j, a_j) pair per digit of
+        the key-switching decomposition, b_j = -(a_j*s + e_j) + w^j * s^2
+        """
+        if not self.use_cpp:
+            return super().generate_relin_key()
+        if self.secret_key is None:
+            raise ValueError("Must generate keys first")
+        
+        comps = self._native_keygen().relin_key(self.decomp_bits)
+        self.relin_key = RelinearizationKey(
+            [(comps[j], comps[j + 1]) for j in range(0, len(comps), 2)])
+        return self.relin_key
+    
+    def _native_keygen(self):
+        """Native key generator for the current secret key"""
+        s = np.array(self.secret_key.get_polynomial(), dtype=np.int64) % self.q
+        return fhe_fast_mult.KeyGenerator(self.cpp_ntt, s, self.sigma)
+    
+    def _relin_key_native(self):
+        """Relinearization key flattened to [b_0, a_0, b_1, a_1, ...] mod q"""
+        if self.relin_key is None:
+            raise ValueError("Must generate relinearization key first")
+        return [np.array(c, dtype=np.int64) % self.q
+                for pair in self.relin_key.get_components() for c in pair]
+    
+    def relinearize(self, ciphertext):
+        if not self.use_cpp or ciphertext.size != 3:
+            return super().relinearize(ciphertext)
+        
+        d0, d1, d2 = (np.array(c, dtype=np.int64) for c in ciphertext.get_components())
+        r0, r1 = self.cpp_mult.relinearize(d0, d1, d2, self._relin_key_native())
+        result = Ciphertext([r0, r1], params=ciphertext.params)
+        noises = self._tracked(ciphertext)
+        if noises:
+            result.noise = self.cpp_noise.relinearize(noises[0])
+        return result
+    
     def multiply(self, ct1, ct2):
         """
         Homomorphic multiplication with C++ acceleration
@@ -96,7 +427,467 @@ class BFVSchemeAccelerated(BaseBFVScheme):
         d1 = d1_np.tolist() if hasattr(d1_np, 'tolist') else list(d1_np)
         d2 = d2_np.tolist() if hasattr(d2_np, 'tolist') else list(d2_np)
         
-        return Ciphertext([d0, d1, d2], params=ct1.params)
+        noises = self._tracked(ct1, ct2)
+        noise = self.cpp_noise.multiply(*noises) if noises else None
+        return Ciphertext([d0, d1, d2], params=ct1.params, noise=noise)
+    
+    def evaluate_polynomial(self, ct, coeffs):
+        """
+        Homomorphically evaluate p(m) = sum(coeffs[i] * m^i) mod t
+        
+        Uses baby-step/giant-step Paterson-Stockmeyer in C++, so a
+        degree-d polynomial costs O(sqrt(d)) ciphertext multiplications
+        
+        Args:
+            ct: Ciphertext object (size-2)
+            coeffs: Polynomial coefficients over Z_t, lowest degree first
+        
+        Returns:
+            Ciphertext object (size-2)
+        """
+        if not self.use_cpp:
+            raise RuntimeError("Polynomial evaluation requires the C++ backend")
+        if self.relin_key is None:
+            raise ValueError("Must generate relinearization key first")
+        if not ct.is_fresh():
+            raise ValueError("Can only evaluate on fresh ciphertexts (size 2)")
+        
+        c0, c1 = ct.get_components()
+        relin_key = self._relin_key_native()
+        
+        r0, r1 = self.cpp_mult.evaluate_polynomial(
+            np.array(c0, dtype=np.int64),
+            np.array(c1, dtype=np.int64),
+            np.array(coeffs, dtype=np.int64) % self.t,
+            relin_key
+        )
+        
+        noises = self._tracked(ct)
+        noise = self._polynomial_noise(noises[0], len(coeffs) - 1) if noises else None
+        return Ciphertext([r0, r1], params=ct.params, noise=noise)
+    
+    def lookup(self, ct, table):
+        """
+        Homomorphically map each encrypted value m to table[m]
+        
+        The table is interpolated over Z_t once and cached, so repeated
+        lookups through the same table only pay for the evaluation.
+        Applies slot-wise when the ciphertext is batch encoded.
+        
+        Args:
+            ct: Ciphertext object (size-2) with values in [0, len(table))
+            table: Sequence of outputs, table[i] = f(i) mod t
+        
+        Returns:
+            Ciphertext object (size-2)
+        """
+        if not self.use_cpp:
+            raise RuntimeError("Lookup tables require the C++ backend")
+        if self.relin_key is None:
+            raise ValueError("Must generate relinearization key first")
+        
+        key = tuple(int(v) % self.t for v in table)
+        lut = self._lookup_cache.get(key)
+        if lut is None:
+            lut = fhe_fast_mult.LookupTable(np.array(key, dtype=np.int64), self.t)
+            self._lookup_cache[key] = lut
+        
+        c0, c1 = ct.get_components()
+        relin_key = self._relin_key_native()
+        
+        r0, r1 = self.cpp_mult.lookup(
+            np.array(c0, dtype=np.int64),
+            np.array(c1, dtype=np.int64),
+            lut,
+            relin_key
+        )
+        
+        noises = self._tracked(ct)
+        noise = self._polynomial_noise(noises[0], lut.size() - 1) if noises else None
+        return Ciphertext([r0, r1], params=ct.params, noise=noise)
+    
+    def generate_galois_keys(self, galois_elts=None):
+        """
+        Generate Galois (rotation) keys for the automorphisms X -> X^g
+        
+        Args:
+            galois_elts: Galois elements to generate keys for
+                         If None, generates the keys needed by sum_slots
+        """
+        if not self.use_cpp:
+            raise RuntimeError("Galois keys require the C++ backend")
+        if self.secret_key is None:
+            raise ValueError("Must generate keys first")
+        
+        if galois_elts is None:
+            galois_elts = self.cpp_galois.sum_slots_elts()
+        
+        # One (b_j, a_j) per digit with b_j = -(a_j*s + e_j) + w^j * s(X^g)
+        keys = self._native_keygen().galois_keys([int(g) for g in galois_elts],
+                                                 self.decomp_bits)
+        self.cpp_galois_keys = fhe_fast_mult.GaloisKeys(self.cpp_ntt, keys)
+        return self.cpp_galois_keys
+    
+    def sum_slots(self, ct):
+        """
+        Homomorphic SUM over all slots (every slot receives the total)
+        
+        Args:
+            ct: Ciphertext object (size-2)
+        
+        Returns:
+            Ciphertext object (size-2)
+        """
+        if self.cpp_galois_keys is None:
+            raise ValueError("Must generate Galois keys first")
+        
+        c0, c1 = ct.get_components()
+        r0, r1 = self.cpp_mult.sum_slots(
+            np.array(c0, dtype=np.int64),
+            np.array(c1, dtype=np.int64),
+            self.cpp_galois_keys
+        )
+        
+        noises = self._tracked(ct)
+        noise = self._sum_slots_noise(noises[0]) if noises else None
+        return Ciphertext([r0, r1], params=ct.params, noise=noise)
+    
+    def _sum_slots_noise(self, v):
+        """Rotate-and-add over log2(N/2) row steps plus the column swap"""
+        for _ in range(len(self.cpp_galois.sum_slots_elts())):
+            v = self.cpp_noise.add(v, self.cpp_noise.rotate(v))
+        return v
+    
+    def masked_sum(self, ct_values, ct_mask):
+        """
+        Homomorphic SUM of values over the slots where the 0/1 mask is 1
+        (COUNT when ct_values encrypts all ones)
+        
+        Args:
+            ct_values: Ciphertext object (size-2)
+            ct_mask: Ciphertext object (size-2) encrypting 0/1 per slot
+        
+        Returns:
+            Ciphertext object (size-2)
+        """
+        if self.cpp_galois_keys is None:
+            raise ValueError("Must generate Galois keys first")
+        if self.relin_key is None:
+            raise ValueError("Must generate relinearization key first")
+        
+        relin_key = self._relin_key_native()
+        r0, r1 = self.cpp_mult.masked_sum(
+            tuple(np.array(c, dtype=np.int64) for c in ct_values.get_components()),
+            tuple(np.array(c, dtype=np.int64) for c in ct_mask.get_components()),
+            relin_key,
+            self.cpp_galois_keys
+        )
+        
+        noises = self._tracked(ct_values, ct_mask)
+        noise = None
+        if noises:
+            noise = self._sum_slots_noise(
+                self.cpp_noise.relinearize(self.cpp_noise.multiply(*noises)))
+        return Ciphertext([r0, r1], params=ct_values.params, noise=noise)
+    
+    def multiply_scalar(self, ct, scalar):
+        """Multiply the encrypted message by a constant in Z_t"""
+        if not self.use_cpp:
+            raise RuntimeError("Scalar multiplication requires the C++ backend")
+        s = int(scalar) % self.t
+        r0, r1 = self.cpp_mult.multiply_scalar(
+            tuple(np.array(c, dtype=np.int64) for c in ct.get_components()), s)
+        
+        noises = self._tracked(ct)
+        noise = self.cpp_noise.multiply_scalar(noises[0], float(min(s, self.t - s))) \
+            if noises else None
+        return Ciphertext([r0, r1], params=ct.params, noise=noise)
+    
+    def create_table_scanner(self, enc_rows, key='date', payload='email',
+                             num_threads=0, block_rows=8):
+        """
+        Load encrypted rows into a native scanner (payload NTTs computed once)
+        
+        Args:
+            enc_rows: List of dicts holding key and payload Ciphertexts
+            key: Name of the key column compared against query targets
+            payload: Name of the payload column returned on a match
+            num_threads: Private scan workers (0 = share the global pool,
+                         see configure_threads)
+            block_rows: Rows per work-stealing block
+        
+        Returns:
+            fhe_fast_mult.TableScanner
+        """
+        if not self.use_cpp:
+            raise RuntimeError("Table scans require the C++ backend")
+        
+        scanner = fhe_fast_mult.TableScanner(self.cpp_mult, num_threads, block_rows)
+        for row in enc_rows:
+            scanner.add_row(
+                tuple(np.array(c, dtype=np.int64) for c in row[key].get_components()),
+                tuple(np.array(c, dtype=np.int64) for c in row[payload].get_components()),
+                row.get('bucket', -1)
+            )
+        return scanner
+    
+    def exact_match_batch(self, scanner, enc_targets, sink=None):
+        """
+        Evaluate many exact-match targets in one pass over the table
+        
+        Args:
+            scanner: fhe_fast_mult.TableScanner from create_table_scanner
+            enc_targets: List of target Ciphertexts
+            sink: Called as sink(row, diffs) with diffs[query] the Ciphertext
+                  difference (zero on a match), in block completion order,
+                  so results can be sent on without holding the whole table
+        
+        Returns:
+            None with a sink, otherwise the collected List [query][row]
+        """
+        targets = [tuple(np.array(c, dtype=np.int64) for c in ct.get_components())
+                   for ct in enc_targets]
+        params = enc_targets[0].params if enc_targets else None
+        
+        collected = None
+        if sink is None:
+            collected = [[None] * scanner.num_rows() for _ in enc_targets]
+            
+            def sink(row, diffs):
+                for qi, diff in enumerate(diffs):
+                    collected[qi][row] = diff
+        
+        def on_row(row, diffs):
+            sink(row, [Ciphertext(list(ct), params=params) for ct in diffs])
+        
+        scanner.exact_match_batch(targets, on_row)
+        return collected
+    
+    def exact_match_indexed(self, scanner, enc_targets, buckets):
+        """
+        Exact match over the rows of each target's index bucket only
+        
+        Returns:
+            List [query] of (row, Ciphertext difference) pairs
+        """
+        targets = [tuple(np.array(c, dtype=np.int64) for c in ct.get_components())
+                   for ct in enc_targets]
+        diffs = scanner.exact_match_indexed(targets, [int(b) for b in buckets])
+        
+        params = enc_targets[0].params if enc_targets else None
+        return [[(row, Ciphertext(list(ct), params=params)) for row, ct in query]
+                for query in diffs]
+    
+    def sum_batch(self, scanner, masks):
+        """
+        SUM aggregate per query over the scanner's payload column
+        
+        Args:
+            scanner: fhe_fast_mult.TableScanner from create_table_scanner
+            masks: List [query][row] of 0/1 mask Ciphertexts
+        
+        Returns:
+            List of Ciphertext objects, one per query
+        """
+        if self.relin_key is None:
+            raise ValueError("Must generate relinearization key first")
+        
+        relin_key = self._relin_key_native()
+        sums = scanner.sum_batch(
+            [[tuple(np.array(c, dtype=np.int64) for c in ct.get_components())
+              for ct in query] for query in masks],
+            relin_key
+        )
+        
+        params = masks[0][0].params if masks and masks[0] else None
+        return [Ciphertext(list(ct), params=params) for ct in sums]
+    
+    def string_matcher(self, string_len, char_range=256):
+        """
+        Get the native matcher for strings of string_len characters
+        Galois keys for matcher.required_galois_elts() must be generated
+        """
+        if not self.use_cpp:
+            raise RuntimeError("String matching requires the C++ backend")
+        
+        key = (string_len, char_range)
+        if key not in self._string_matchers:
+            self._string_matchers[key] = fhe_fast_mult.StringMatcher(
+                self.cpp_mult, string_len, char_range)
+        return self._string_matchers[key]
+    
+    def string_equal(self, ct_a, ct_b, string_len=12, position_mask=None, prefix_len=None,
+                     char_range=256):
+        """
+        Encrypted string equality over strings packed one character per
+        slot at the matcher's stride; slot k*stride of the result is 1
+        where string k of ct_a equals string k of ct_b
+        
+        Args:
+            ct_a, ct_b: Ciphertext objects (size-2)
+            string_len: Characters per string
+            position_mask: Optional Plaintext with 1 at the positions to
+                           compare (e.g. the first p characters: prefix match)
+            prefix_len: Compare only the first prefix_len characters
+                        (mask built with the batch encoder)
+            char_range: Characters lie in [0, char_range); the zero test
+                        has degree 2 * char_range - 2, so small alphabets
+                        are far cheaper (the native matcher rejects ranges
+                        the modulus cannot hold)
+        
+        Returns:
+            Ciphertext object (size-2)
+        """
+        if self.cpp_galois_keys is None:
+            raise ValueError("Must generate Galois keys first")
+        if self.relin_key is None:
+            raise ValueError("Must generate relinearization key first")
+        
+        matcher = self.string_matcher(string_len, char_range)
+        relin_key = self._relin_key_native()
+        a = tuple(np.array(c, dtype=np.int64) for c in ct_a.get_components())
+        b = tuple(np.array(c, dtype=np.int64) for c in ct_b.get_components())
+        
+        if prefix_len is not None:
+            if self.cpp_encoder is None:
+                raise RuntimeError("prefix_len requires a batching plaintext modulus")
+            mask = matcher.prefix_mask(self.cpp_encoder, prefix_len)
+            r0, r1 = matcher.prefix_match(
+                a, b, mask,
+                relin_key,
+                self.cpp_galois_keys)
+        elif position_mask is None:
+            r0, r1 = matcher.equal(
+                a, b, relin_key,
+                self.cpp_galois_keys)
+        else:
+            r0, r1 = matcher.prefix_match(
+                a, b, np.array(position_mask.get_poly(), dtype=np.int64),
+                relin_key,
+                self.cpp_galois_keys)
+        
+        noises = self._tracked(ct_a, ct_b)
+        noise = None
+        if noises:
+            # Zero test on the difference (2R - 1 table entries, R = char_range),
+            # then one rotate-and-multiply per halving of the stride
+            nm = self.cpp_noise
+            v = self._polynomial_noise(nm.add(*noises), 2 * char_range - 2)
+            if prefix_len is not None or position_mask is not None:
+                v = nm.multiply_plain(v)
+            steps = int(np.log2(matcher.get_stride()))
+            for _ in range(steps):
+                v = nm.relinearize(nm.multiply(v, nm.rotate(v)))
+            noise = v
+        return Ciphertext([r0, r1], params=ct_a.params, noise=noise)
+    
+    def inner_product_coeff(self, ct, pt_vector):
+        """
+        Encrypted inner product with a plaintext vector, with no rotations
+        or key switching: one ring multiply by the reversed encoding
+        
+        Args:
+            ct: Ciphertext of a coefficient-encoded vector (see encode_coeff)
+            pt_vector: Plaintext vector of integers
+        
+        Returns:
+            Ciphertext whose coefficient 0 holds the inner product mod t
+            (read with decode_coeff)
+        """
+        if not self.use_cpp:
+            raise RuntimeError("Inner products require the C++ backend")
+        
+        c0, c1 = ct.get_components()
+        r0, r1 = self.cpp_mult.inner_product_coeff(
+            np.array(c0, dtype=np.int64),
+            np.array(c1, dtype=np.int64),
+            np.array(pt_vector, dtype=np.int64) % self.t
+        )
+        noises = self._tracked(ct)
+        noise = self.cpp_noise.multiply_plain(noises[0]) if noises else None
+        return Ciphertext([r0, r1], params=ct.params, noise=noise)
+    
+    def inner_product_plan(self, pt_vectors):
+        """Pre-encode plaintext vectors (NTT form) for inner_product_batch"""
+        if not self.use_cpp:
+            raise RuntimeError("Inner products require the C++ backend")
+        return fhe_fast_mult.CoeffInnerProduct(
+            self.cpp_mult,
+            [np.array(v, dtype=np.int64) % self.t for v in pt_vectors]
+        )
+    
+    def inner_product_batch(self, ct, plan):
+        """
+        Inner products of one encrypted vector with every vector in plan
+        
+        Returns:
+            List of Ciphertexts, coefficient 0 of each holding one product
+        """
+        c0, c1 = ct.get_components()
+        results = plan.inner_product_batch(
+            np.array(c0, dtype=np.int64),
+            np.array(c1, dtype=np.int64)
+        )
+        noises = self._tracked(ct)
+        noise = self.cpp_noise.multiply_plain(noises[0]) if noises else None
+        return [Ciphertext(list(r), params=ct.params, noise=noise) for r in results]
+    
+    def matrix_plan(self, matrix, encode_slots=None):
+        """
+        Pre-encode an n x n plaintext matrix for matvec (diagonal method)
+        
+        Args:
+            matrix: n x n integers, n a power of two dividing N/2
+            encode_slots: callable mapping N slot values to a plaintext
+                          polynomial (default: the native batch encoder)
+        
+        Returns:
+            DiagonalMatrix plan; generate_galois_keys(plan.required_galois_elts())
+            must include its rotations
+        """
+        if not self.use_cpp:
+            raise RuntimeError("Matrix-vector products require the C++ backend")
+        rows = [np.array(row, dtype=np.int64) % self.t for row in matrix]
+        if encode_slots is None:
+            if self.cpp_encoder is None:
+                raise RuntimeError("No batch encoder for this plaintext modulus")
+            return fhe_fast_mult.DiagonalMatrix(self.cpp_mult, rows, self.cpp_encoder)
+        return fhe_fast_mult.DiagonalMatrix(
+            self.cpp_mult,
+            rows,
+            lambda slots: np.array(encode_slots(slots), dtype=np.int64)
+        )
+    
+    def matvec(self, ct, plan):
+        """
+        Homomorphic matrix-vector product M v
+        
+        Args:
+            ct: Ciphertext whose slot s holds v[s mod n]
+            plan: DiagonalMatrix from matrix_plan
+        
+        Returns:
+            Ciphertext whose slot s holds (M v)[s mod n]
+        """
+        if self.cpp_galois_keys is None:
+            raise ValueError("Must generate Galois keys first")
+        
+        c0, c1 = ct.get_components()
+        r0, r1 = plan.multiply(
+            np.array(c0, dtype=np.int64),
+            np.array(c1, dtype=np.int64),
+            self.cpp_galois_keys
+        )
+        
+        noises = self._tracked(ct)
+        noise = None
+        if noises:
+            # n1 rotated copies times a diagonal each, then a giant-step
+            # rotation per group of n1 diagonals
+            nm = self.cpp_noise
+            inner = plan.get_baby_steps() * nm.multiply_plain(nm.rotate(noises[0]))
+            noise = plan.get_giant_steps() * nm.rotate(inner)
+        return Ciphertext([r0, r1], params=ct.params, noise=noise)
     
     def poly_multiply(self, a, b):
         """
@@ -111,6 +902,202 @@ class BFVSchemeAccelerated(BaseBFVScheme):
         else:
             return self.poly_ring.mul(a, b)
     
+    def enable_instrumentation(self, enabled=True):
+        """Switch native counters and latency histograms on or off"""
+        if not self.use_cpp:
+            return False
+        fhe_fast_mult.set_instrumentation(enabled)
+        return fhe_fast_mult.instrumentation_compiled_in()
+    
+    def instrumentation_snapshot(self, reset=False):
+        """
+        Native operation counters and latency percentiles
+        
+        Returns:
+            {'counters': {name: count}, 'ops': {name: {count, mean_ns, p50_ns, ...}}}
+            or None without the C++ backend
+        """
+        if not self.use_cpp:
+            return None
+        snap = fhe_fast_mult.instrumentation_snapshot()
+        if reset:
+            fhe_fast_mult.reset_instrumentation()
+        return snap
+    
+    def enable_perf_counters(self, enabled=True):
+        """
+        Switch hardware counters (cycles, instructions, cache and branch
+        misses) around the NTT, pointwise and key-switching kernels on or off
+        
+        Returns:
+            True if at least one counter could be opened (Linux only; may be
+            blocked by perf_event_paranoid or inside containers)
+        """
+        if not (self.use_cpp and fhe_fast_mult.perf_counters_supported()):
+            return False
+        return fhe_fast_mult.set_perf_counters(enabled)
+    
+    def perf_counter_report(self, reset=False):
+        """
+        Per-kernel hardware counter totals
+        
+        Returns:
+            {kernel: {'calls', 'coefficients', 'events', 'ipc', 'per_coefficient'}}
+            or None without the C++ backend
+        """
+        if not self.use_cpp:
+            return None
+        report = fhe_fast_mult.perf_counter_snapshot()
+        if reset:
+            fhe_fast_mult.reset_perf_counters()
+        return report
+    
+    # Async variants: single operations run as one native pool task and
+    # the returned coroutine resolves on the caller's event loop, so an
+    # asyncio service can keep many queries in flight without blocking the
+    # loop; batched calls run on an executor thread instead, because their
+    # own parallel loop would run inline inside a pool task
+    
+    async def multiply_async(self, ct1, ct2):
+        """Awaitable multiply (size-3 result, needs relinearization)"""
+        if not ct1.is_fresh() or not ct2.is_fresh():
+            raise ValueError("Can only multiply fresh ciphertexts (size 2)")
+        if not self.use_cpp:
+            return await asyncio.get_running_loop().run_in_executor(
+                None, self.multiply, ct1, ct2)
+        
+        c1_0, c1_1 = ct1.get_components()
+        c2_0, c2_1 = ct2.get_components()
+        d0, d1, d2 = await self.cpp_mult.multiply_ciphertexts_async(
+            np.array(c1_0, dtype=np.int64), np.array(c1_1, dtype=np.int64),
+            np.array(c2_0, dtype=np.int64), np.array(c2_1, dtype=np.int64))
+        
+        noises = self._tracked(ct1, ct2)
+        noise = self.cpp_noise.multiply(*noises) if noises else None
+        return Ciphertext([d0.tolist(), d1.tolist(), d2.tolist()], params=ct1.params, noise=noise)
+    
+    async def relinearize_async(self, ciphertext):
+        """Awaitable relinearization of a size-3 ciphertext"""
+        if not self.use_cpp:
+            return await asyncio.get_running_loop().run_in_executor(
+                None, self.relinearize, ciphertext)
+        if self.relin_key is None:
+            raise ValueError("Must generate relinearization key first")
+        if ciphertext.size != 3:
+            raise ValueError("Can only relinearize size-3 ciphertexts")
+        
+        d0, d1, d2 = ciphertext.get_components()
+        relin_key = self._relin_key_native()
+        c0, c1 = await self.cpp_mult.relinearize_async(
+            np.array(d0, dtype=np.int64), np.array(d1, dtype=np.int64),
+            np.array(d2, dtype=np.int64), relin_key)
+        
+        noises = self._tracked(ciphertext)
+        noise = self.cpp_noise.relinearize(noises[0]) if noises else None
+        return Ciphertext([c0.tolist(), c1.tolist()], params=ciphertext.params, noise=noise)
+    
+    async def decrypt_async(self, ciphertext):
+        """Awaitable decrypt"""
+        if not self.use_cpp:
+            return await asyncio.get_running_loop().run_in_executor(
+                None, self.decrypt, ciphertext)
+        
+        q = self._modulus_of(ciphertext)
+        ct = tuple(np.array(c, dtype=np.int64) % q for c in ciphertext.get_components())
+        m = await self._native_decryptor(q).decrypt_async(ct)
+        return Plaintext(m, params={'N': self.N, 't': self.t, 'q': self.q})
+    
+    async def decrypt_batch_async(self, ciphertexts):
+        """
+        Awaitable decrypt_batch, on an executor thread like
+        exact_match_batch_async so the batch spreads over the pool
+        """
+        return await asyncio.get_running_loop().run_in_executor(
+            None, self.decrypt_batch, ciphertexts)
+    
+    async def exact_match_batch_async(self, scanner, enc_targets):
+        """
+        Awaitable exact_match_batch, collected into [query][row]
+        The scan runs on an executor thread rather than as a single pool
+        task, so its row blocks still spread over the pool's workers
+        """
+        return await asyncio.get_running_loop().run_in_executor(
+            None, self.exact_match_batch, scanner, enc_targets)
+    
+    def lazy(self):
+        """
+        Start a lazy evaluation: operations on the returned LazyEvaluator
+        build a graph, and nothing is computed until a result is evaluated
+        
+        Returns:
+            LazyEvaluator
+        """
+        if not self.use_cpp:
+            raise RuntimeError("Lazy evaluation requires the C++ backend")
+        return LazyEvaluator(self)
+    
+    def configure_threads(self, num_threads=0, pin_threads=True):
+        """
+        Resize the process-wide native thread pool; table scans, batch
+        encode/decode/decrypt and batched NTTs all share it, so size it
+        together with the web server's own worker count
+        """
+        if not self.use_cpp:
+            return False
+        fhe_fast_mult.configure_thread_pool(num_threads, pin_threads)
+        return True
+    
+    def thread_pool_stats(self, reset=False):
+        """
+        Global pool size and scheduling counters
+        
+        Returns:
+            {'workers', 'numa_nodes', 'parallel_for_calls', 'inline_calls',
+             'tasks_executed', 'tasks_stolen', 'remote_steals'}
+            or None without the C++ backend
+        """
+        if not self.use_cpp:
+            return None
+        stats = fhe_fast_mult.thread_pool_stats()
+        if reset:
+            fhe_fast_mult.reset_thread_pool_stats()
+        return stats
+    
+    def start_trace(self, max_events_per_thread=1 << 16):
+        """Start recording native trace spans (NTTs, key switching, I/O, ...)"""
+        if not self.use_cpp:
+            return False
+        fhe_fast_mult.clear_trace()
+        fhe_fast_mult.start_tracing(max_events_per_thread)
+        return fhe_fast_mult.instrumentation_compiled_in()
+    
+    def stop_trace(self, path=None):
+        """
+        Stop recording and optionally write a Chrome trace JSON file
+        (load it in chrome://tracing or ui.perfetto.dev)
+        
+        Returns:
+            {'recorded': n, 'dropped': n}, or None without the C++ backend
+        """
+        if not self.use_cpp:
+            return None
+        fhe_fast_mult.stop_tracing()
+        if path is not None:
+            fhe_fast_mult.write_chrome_trace(path)
+        return fhe_fast_mult.trace_stats()
+    
+    @contextlib.contextmanager
+    def trace_span(self, name, category='python'):
+        """Record a block of Python code as a span on the native trace"""
+        if not (self.use_cpp and fhe_fast_mult.tracing_enabled()):
+            yield
+            return
+        start = fhe_fast_mult.trace_now_ns()
+        try:
+            yield
+        finally:
+            fhe_fast_mult.trace_record(name, category, start, fhe_fast_mult.trace_now_ns())
+    
     def get_backend_info(self):
         """Get information about which backend is being used"""
         if self.use_cpp:
@@ -129,6 +1116,142 @@ class BFVSchemeAccelerated(BaseBFVScheme):
             }
 
 
+class LazyCiphertext:
+    """A ciphertext not computed yet: a node of a LazyEvaluator graph"""
+    
+    def __init__(self, evaluator, node, params, noise):
+        self.evaluator = evaluator
+        self.node = node
+        self.params = params
+        self.noise = noise
+    
+    @property
+    def size(self):
+        return self.evaluator.graph.size_of(self.node)
+    
+    def __add__(self, other):
+        return self.evaluator.add(self, other)
+    
+    def __sub__(self, other):
+        return self.evaluator.sub(self, other)
+    
+    def __mul__(self, other):
+        if isinstance(other, int):
+            return self.evaluator.multiply_scalar(self, other)
+        return self.evaluator.multiply(self, other)
+    
+    def relinearize(self):
+        return self.evaluator.relinearize(self)
+    
+    def evaluate(self):
+        """Compute this ciphertext (and whatever it depends on)"""
+        return self.evaluator.evaluate(self)[0]
+    
+    def __repr__(self):
+        return f"LazyCiphertext(node={self.node}, size={self.size})"
+
+
+class LazyEvaluator:
+    """
+    Records evaluator calls in a native expression graph
+    
+    evaluate() plans all requested results together: element-wise chains
+    are fused, values stay in NTT form between NTT consumers, sums of
+    relinearized products are relinearized once, and independent nodes
+    run in parallel. Results match the eager calls exactly.
+    """
+    
+    def __init__(self, scheme):
+        self.scheme = scheme
+        self.graph = fhe_fast_mult.ExprGraph(scheme.cpp_mult)
+        self._inputs = {}
+        if scheme.relin_key is not None:
+            self.graph.set_relin_key(scheme._relin_key_native())
+        if scheme.cpp_galois_keys is not None:
+            self.graph.set_galois_keys(scheme.cpp_galois_keys)
+    
+    def input(self, ct):
+        """Graph leaf for a Ciphertext (each Ciphertext object is added once)"""
+        if isinstance(ct, LazyCiphertext):
+            return ct
+        cached = self._inputs.get(id(ct))
+        if cached is not None and cached[0] is ct:
+            return cached[1]
+        node = self.graph.input(tuple(np.array(c, dtype=np.int64) % self.scheme.q
+                                      for c in ct.get_components()))
+        lazy = LazyCiphertext(self, node, ct.params, ct.noise)
+        self._inputs[id(ct)] = (ct, lazy)
+        return lazy
+    
+    def _noise(self, fn, *cts):
+        noises = [ct.noise for ct in cts]
+        if any(v is None for v in noises):
+            return None
+        return fn(*noises)
+    
+    def add(self, a, b):
+        a, b = self.input(a), self.input(b)
+        return LazyCiphertext(self, self.graph.add(a.node, b.node), a.params,
+                              self._noise(self.scheme.cpp_noise.add, a, b))
+    
+    def sub(self, a, b):
+        a, b = self.input(a), self.input(b)
+        return LazyCiphertext(self, self.graph.subtract(a.node, b.node), a.params,
+                              self._noise(self.scheme.cpp_noise.add, a, b))
+    
+    def multiply(self, a, b):
+        a, b = self.input(a), self.input(b)
+        return LazyCiphertext(self, self.graph.multiply(a.node, b.node), a.params,
+                              self._noise(self.scheme.cpp_noise.multiply, a, b))
+    
+    def relinearize(self, a):
+        a = self.input(a)
+        return LazyCiphertext(self, self.graph.relinearize(a.node), a.params,
+                              self._noise(self.scheme.cpp_noise.relinearize, a))
+    
+    def multiply_plain(self, a, plaintext):
+        a = self.input(a)
+        poly = plaintext.get_poly() if isinstance(plaintext, Plaintext) else plaintext
+        node = self.graph.multiply_plain(a.node, np.array(poly, dtype=np.int64))
+        t = float(self.scheme.t)
+        return LazyCiphertext(self, node, a.params,
+                              self._noise(lambda v: self.scheme.cpp_noise.multiply_plain(v, t), a))
+    
+    def multiply_scalar(self, a, scalar):
+        a = self.input(a)
+        t = self.scheme.t
+        s = int(scalar) % t
+        norm = float(min(s, t - s))
+        return LazyCiphertext(self, self.graph.multiply_scalar(a.node, s), a.params,
+                              self._noise(lambda v: self.scheme.cpp_noise.multiply_scalar(v, norm), a))
+    
+    def add_scalar(self, a, scalar):
+        a = self.input(a)
+        return LazyCiphertext(self, self.graph.add_scalar(a.node, int(scalar) % self.scheme.t),
+                              a.params, self._noise(self.scheme.cpp_noise.add_plain, a))
+    
+    def rotate(self, a, galois_elt):
+        """X -> X^g with key switching (needs scheme.generate_galois_keys)"""
+        a = self.input(a)
+        return LazyCiphertext(self, self.graph.rotate(a.node, int(galois_elt)), a.params,
+                              self._noise(self.scheme.cpp_noise.rotate, a))
+    
+    def evaluate(self, *lazy_cts):
+        """
+        Compute the given LazyCiphertexts in one plan
+        
+        Returns:
+            List of Ciphertext objects
+        """
+        results = self.graph.evaluate([ct.node for ct in lazy_cts])
+        return [Ciphertext([c.tolist() for c in comps], params=ct.params, noise=ct.noise)
+                for ct, comps in zip(lazy_cts, results)]
+    
+    def stats(self):
+        """Plan statistics of the last evaluate() (fusion, transforms, levels)"""
+        return self.graph.stats()
+
+
 # Convenience function to create accelerated scheme
 def create_fast_bfv(N=8192, t=65537, q_bits=60, sigma=3.2):
     """
@@ -140,5 +1263,25 @@ def create_fast_bfv(N=8192, t=65537, q_bits=60, sigma=3.2):
     return BFVSchemeAccelerated(N, t, q_bits, sigma, use_cpp=True)
 
 
+def plan_parameters(depth, t=65537, rotations=0, security=128, batching=True):
+    """
+    Cheapest parameters for a circuit profile, using the noise model
+    
+    Args:
+        depth: Multiplicative depth
+        t: Plaintext modulus
+        rotations: Rotations (key switches) on the critical path
+        security: 128, 192 or 256 bits
+        batching: Require t = 1 (mod 2N) for slot encoding
+    
+    Returns:
+        ParameterPlan with N, moduli, decomposition base and estimated
+        per-operation costs (microseconds)
+    """
+    if not CPP_AVAILABLE:
+        raise RuntimeError("Parameter planning requires the C++ backend")
+    return fhe_fast_mult.ParameterPlanner().plan(depth, t, rotations, security, batching)
+
+
 # For backwards compatibility
 BFVSchemeFast = BFVSchemeAccelerated
@@ -4,78 +4,150 @@
  */
 
 #include "bfv_mult.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <string>
 
 namespace fhe_cpp {
 
-BFVMultiplier::BFVMultiplier(int N, ModInt q, ModInt t) 
-    : ntt(N, q), N(N), q(q), t(t) {
+BFVMultiplier::BFVMultiplier(int N, ModInt q, ModInt t, int decomp_bits) 
+    : ntt(N, q), galois(N, q), q(q), t(t), N(N), gadget(N, q, decomp_bits) {
     
     delta = q / t;
     
     if (!ntt.is_valid()) {
         throw std::runtime_error("NTT initialization failed");
     }
-}
-
-std::vector<ModInt> BFVMultiplier::gadget_decompose(const std::vector<ModInt>& vec) {
-    // BitDecomp equivalent - decompose into log(q) components
-    int log_q = std::ceil(std::log2(q));
-    std::vector<ModInt> result;
-    result.reserve(vec.size() * log_q);
     
-    for (const auto& val : vec) {
-        ModInt temp = val;
-        for (int i = 0; i < log_q; i++) {
-            result.push_back(temp & 1);
-            temp >>= 1;
+    // The rescaled product X = round(t * d / q) has |X| <= t*N*q/2 + 1
+    // (|d| <= N*q^2/2 for centered inputs); two 61-bit primes hold it
+    for (ModInt p : find_ntt_primes(N, 61, 3)) {
+        if (p != q && aux_ntt.size() < 2) {
+            aux_ntt.emplace_back(N, p);
         }
     }
+    double bound_bits = std::log2((double)t) + std::log2((double)N) + std::log2((double)q) + 1;
+    double aux_bits = std::log2((double)aux_ntt[0].get_q()) + std::log2((double)aux_ntt[1].get_q());
+    if (bound_bits + 1 >= aux_bits) {
+        throw std::invalid_argument("t * N * q is too large for the exact tensor product");
+    }
     
-    return result;
+    auto inverse_mod = [](ModInt a, ModInt p) {
+        // a^(p-2) mod p
+        ModInt result = 1, base = a % p, e = p - 2;
+        while (e > 0) {
+            if (e & 1) result = (ModInt)((__int128)result * base % p);
+            base = (ModInt)((__int128)base * base % p);
+            e >>= 1;
+        }
+        return result;
+    };
+    for (const auto& aux : aux_ntt) {
+        aux_q_inv.push_back(inverse_mod(q % aux.get_q(), aux.get_q()));
+    }
+    aux_crt = inverse_mod(aux_ntt[0].get_q() % aux_ntt[1].get_q(), aux_ntt[1].get_q());
 }
 
-std::vector<ModInt> BFVMultiplier::gadget_compose(const std::vector<ModInt>& vec) {
-    // PowerOf2 equivalent - multiply by powers of 2
-    int log_q = std::ceil(std::log2(q));
-    int n = vec.size() / log_q;
+ModInt BFVMultiplier::rescale(ModInt d_q, ModInt d_p0, ModInt d_p1) const {
+    // t*d = q*X + r with r = t*d mod q centered, so X = (t*d - r) / q is
+    // the rounded quotient; X mod p_i follows from the residues of d
+    ModInt r = (ModInt)((__int128)t * d_q % q);
+    if (r > q / 2) r -= q;
     
-    std::vector<ModInt> result(n, 0);
-    
-    for (int i = 0; i < n; i++) {
-        ModInt power = 1;
-        for (int j = 0; j < log_q; j++) {
-            ModInt contrib = (vec[i * log_q + j] * power) % q;
-            result[i] = (result[i] + contrib) % q;
-            power = (power * 2) % q;
-        }
+    ModInt x[2];
+    ModInt d_p[2] = {d_p0, d_p1};
+    for (int i = 0; i < 2; i++) {
+        ModInt p = aux_ntt[i].get_q();
+        ModInt v = (ModInt)(((__int128)t * d_p[i] - r) % p);
+        if (v < 0) v += p;
+        x[i] = (ModInt)((__int128)v * aux_q_inv[i] % p);
     }
     
-    return result;
+    // CRT into [0, p0*p1), then center and reduce mod q
+    ModInt p0 = aux_ntt[0].get_q();
+    ModInt p1 = aux_ntt[1].get_q();
+    ModInt k = (ModInt)(((__int128)(x[1] - x[0]) % p1 + p1) % p1);
+    k = (ModInt)((__int128)k * aux_crt % p1);
+    __int128 P = (__int128)p0 * p1;
+    __int128 X = x[0] + (__int128)p0 * k;
+    if (X > P / 2) X -= P;
+    
+    ModInt result = (ModInt)(X % q);
+    return result < 0 ? result + q : result;
 }
 
-std::vector<ModInt> BFVMultiplier::scale_down(const std::vector<ModInt>& poly) {
-    // BFV scaling: multiply by t/q and round
-    // This is the critical operation that requires exact arithmetic
+std::vector<std::vector<ModInt>> BFVMultiplier::multiply_ciphertexts_ntt(
+    const std::vector<std::vector<ModInt>>& ct1,
+    const std::vector<std::vector<ModInt>>& ct1_ntt,
+    const std::vector<std::vector<ModInt>>& ct2,
+    const std::vector<std::vector<ModInt>>& ct2_ntt) const {
+    FHE_TIME_OP(Multiply);
+    FHE_TRACE_SPAN("multiply", "multiply");
     
-    std::vector<ModInt> result(poly.size());
+    if (ct1.size() != 2 || ct2.size() != 2 || ct1_ntt.size() != 2 || ct2_ntt.size() != 2) {
+        throw std::invalid_argument("Can only multiply size-2 ciphertexts");
+    }
+    for (const auto* ct : {&ct1, &ct1_ntt, &ct2, &ct2_ntt}) {
+        for (const auto& comp : *ct) {
+            if (comp.size() != (size_t)N) {
+                throw std::invalid_argument("All ciphertext components must have size N");
+            }
+        }
+    }
     
-    for (size_t i = 0; i < poly.size(); i++) {
-        // Use high precision arithmetic
-        __int128 val = poly[i];
-        __int128 scaled = (val * t) / q;
-        
-        // Handle rounding
-        __int128 remainder = (val * t) % q;
-        if (remainder * 2 >= q) {
-            scaled++;
+    // d0 = a0*b0, d1 = a0*b1 + a1*b0, d2 = a1*b1, pointwise in NTT form
+    auto products = [](const NTT& ring, const std::vector<std::vector<ModInt>>& a,
+                       const std::vector<std::vector<ModInt>>& b) {
+        std::vector<std::vector<ModInt>> d = {
+            ring.pointwise_multiply(a[0], b[0]),
+            ring.add(ring.pointwise_multiply(a[0], b[1]), ring.pointwise_multiply(a[1], b[0])),
+            ring.pointwise_multiply(a[1], b[1])
+        };
+        for (auto& comp : d) {
+            ring.inverse(comp);
         }
+        return d;
+    };
+    
+    std::vector<std::vector<ModInt>> d_q, d_aux[2];
+    {
+        FHE_TRACE_SPAN("tensor_product", "multiply");
+        d_q = products(ntt, ct1_ntt, ct2_ntt);
         
-        result[i] = scaled % q;
-        if (result[i] < 0) result[i] += q;
+        // The same products of the centered lifts modulo each auxiliary
+        // prime; together with mod q they determine d over Z
+        for (int i = 0; i < 2; i++) {
+            const NTT& aux = aux_ntt[i];
+            ModInt p = aux.get_q();
+            auto lift = [&](const std::vector<std::vector<ModInt>>& ct) {
+                std::vector<std::vector<ModInt>> lifted(2, std::vector<ModInt>(N));
+                for (int c = 0; c < 2; c++) {
+                    for (int n = 0; n < N; n++) {
+                        ModInt v = ct[c][n] % q;
+                        if (v < 0) v += q;
+                        lifted[c][n] = v > q / 2 ? v - q + p : v;
+                    }
+                    aux.forward(lifted[c]);
+                }
+                return lifted;
+            };
+            d_aux[i] = products(aux, lift(ct1), lift(ct2));
+        }
     }
     
+    std::vector<std::vector<ModInt>> result(3, std::vector<ModInt>(N));
+    {
+        FHE_TRACE_SPAN("rescale", "multiply");
+        for (int c = 0; c < 3; c++) {
+            for (int n = 0; n < N; n++) {
+                result[c][n] = rescale(d_q[c][n], d_aux[0][c][n], d_aux[1][c][n]);
+            }
+        }
+    }
     return result;
 }
 
@@ -83,70 +155,529 @@ std::vector<std::vector<ModInt>> BFVMultiplier::multiply_ciphertexts(
     const std::vector<ModInt>& c1_0,
     const std::vector<ModInt>& c1_1,
     const std::vector<ModInt>& c2_0,
-    const std::vector<ModInt>& c2_1) {
+    const std::vector<ModInt>& c2_1) const {
     
     // Verify input sizes
-    if (c1_0.size() != N || c1_1.size() != N || 
-        c2_0.size() != N || c2_1.size() != N) {
+    if (c1_0.size() != (size_t)N || c1_1.size() != (size_t)N || 
+        c2_0.size() != (size_t)N || c2_1.size() != (size_t)N) {
         throw std::invalid_argument("All ciphertext components must have size N");
     }
     
-    // Apply gadget decomposition for better scaling
-    std::vector<ModInt> c1_0_G = gadget_compose(gadget_decompose(c1_0));
-    std::vector<ModInt> c1_1_G = gadget_compose(gadget_decompose(c1_1));
-    std::vector<ModInt> c2_0_G = gadget_compose(gadget_decompose(c2_0));
-    std::vector<ModInt> c2_1_G = gadget_compose(gadget_decompose(c2_1));
+    std::vector<std::vector<ModInt>> ct1 = {c1_0, c1_1};
+    std::vector<std::vector<ModInt>> ct2 = {c2_0, c2_1};
+    std::vector<std::vector<ModInt>> ct1_ntt = ct1;
+    std::vector<std::vector<ModInt>> ct2_ntt = ct2;
+    for (auto& comp : ct1_ntt) {
+        ntt.forward(comp);
+    }
+    for (auto& comp : ct2_ntt) {
+        ntt.forward(comp);
+    }
+    
+    return multiply_ciphertexts_ntt(ct1, ct1_ntt, ct2, ct2_ntt);
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::decompose_ntt(
+    const std::vector<ModInt>& poly) const {
+    FHE_TRACE_SPAN("gadget_decompose", "keyswitch");
+    
+    std::vector<std::vector<ModInt>> digits = gadget.decompose(poly);
+    for (auto& digit : digits) {
+        ntt.forward(digit);
+    }
+    return digits;
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::key_switch_digits_ntt(
+    const std::vector<std::vector<ModInt>>& digits_ntt,
+    const std::vector<std::vector<ModInt>>& key_ntt) const {
     
-    // Compute tensor product components using NTT
-    // d0 = c1_0 * c2_0
-    std::vector<ModInt> d0 = ntt.multiply(c1_0_G, c2_0_G);
+    int digits = gadget.num_digits();
+    if (digits_ntt.size() != (size_t)digits || key_ntt.size() != 2 * (size_t)digits) {
+        throw std::invalid_argument("Key must have two components per decomposition digit (" +
+                                    std::to_string(digits) + " digits)");
+    }
+    
+    std::vector<std::vector<ModInt>> result(2, std::vector<ModInt>(N, 0));
+    for (int j = 0; j < digits; j++) {
+        result[0] = ntt.add(result[0], ntt.pointwise_multiply(digits_ntt[j], key_ntt[2 * j]));
+        result[1] = ntt.add(result[1], ntt.pointwise_multiply(digits_ntt[j], key_ntt[2 * j + 1]));
+    }
+    return result;
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::key_switch_ntt(
+    const std::vector<ModInt>& poly,
+    const std::vector<std::vector<ModInt>>& key_ntt) const {
+    
+    return key_switch_digits_ntt(decompose_ntt(poly), key_ntt);
+}
+
+std::shared_ptr<const std::vector<std::vector<ModInt>>> BFVMultiplier::relin_key_ntt(
+    const std::vector<std::vector<ModInt>>& relin_key) const {
+    
+    if (relin_key.size() != 2 * (size_t)gadget.num_digits()) {
+        throw std::invalid_argument("Invalid relinearization key format: expected " +
+                                    std::to_string(gadget.num_digits()) + " (b, a) pairs");
+    }
+    for (const auto& comp : relin_key) {
+        if (comp.size() != (size_t)N) {
+            throw std::invalid_argument("Invalid relinearization key format");
+        }
+    }
+    
+    // Comparing against the cached key is far cheaper than 2l forward NTTs
+    std::lock_guard<std::mutex> lock(relin_cache_mutex);
+    if (!relin_key_ntt_cached || relin_key != relin_key_cached) {
+        auto key_ntt = std::make_shared<std::vector<std::vector<ModInt>>>(relin_key);
+        for (auto& comp : *key_ntt) {
+            ntt.forward(comp);
+        }
+        relin_key_cached = relin_key;
+        relin_key_ntt_cached = std::move(key_ntt);
+    }
+    return relin_key_ntt_cached;
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::relinearize_key_ntt(
+    const std::vector<std::vector<ModInt>>& ct,
+    const std::vector<std::vector<ModInt>>& key_ntt) const {
     
-    // d1 = c1_0 * c2_1 + c1_1 * c2_0
-    std::vector<ModInt> d1_part1 = ntt.multiply(c1_0_G, c2_1_G);
-    std::vector<ModInt> d1_part2 = ntt.multiply(c1_1_G, c2_0_G);
-    std::vector<ModInt> d1 = ntt.add(d1_part1, d1_part2);
+    if (ct.size() == 2) {
+        return ct;
+    }
+    if (ct.size() != 3) {
+        throw std::invalid_argument("Can only relinearize size-3 ciphertexts");
+    }
     
-    // d2 = c1_1 * c2_1
-    std::vector<ModInt> d2 = ntt.multiply(c1_1_G, c2_1_G);
+    FHE_TIME_OP(Relinearize);
+    FHE_COUNT(KeySwitch, 1);
+    FHE_TRACE_SPAN("relinearize", "keyswitch");
+    FHE_PERF_SCOPE(KeySwitch, 2 * N);
     
-    // Apply BFV scaling to each component
-    d0 = scale_down(d0);
-    d1 = scale_down(d1);
-    d2 = scale_down(d2);
+    // Relinearization: c0 = d0 + sum_j D_j(d2) * b_j, c1 = d1 + sum_j D_j(d2) * a_j
+    // where (b_j, a_j) encrypts w^j * s^2, so the sum encrypts d2 * s^2
+    // with noise sum_j D_j(d2) * e_j, small because the digits are
+    std::vector<std::vector<ModInt>> key_part = key_switch_ntt(ct[2], key_ntt);
+    ntt.inverse(key_part[0]);
+    ntt.inverse(key_part[1]);
     
-    return {d0, d1, d2};
+    return {ntt.add(ct[0], key_part[0]), ntt.add(ct[1], key_part[1])};
 }
 
 std::vector<std::vector<ModInt>> BFVMultiplier::relinearize(
     const std::vector<ModInt>& d0,
     const std::vector<ModInt>& d1,
     const std::vector<ModInt>& d2,
-    const std::vector<std::vector<ModInt>>& relin_key) {
+    const std::vector<std::vector<ModInt>>& relin_key) const {
+    
+    if (d0.size() != (size_t)N || d1.size() != (size_t)N || d2.size() != (size_t)N) {
+        throw std::invalid_argument("All ciphertext components must have size N");
+    }
+    
+    return relinearize_key_ntt({d0, d1, d2}, *relin_key_ntt(relin_key));
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::multiply_relinearize(
+    const std::vector<std::vector<ModInt>>& ct1,
+    const std::vector<std::vector<ModInt>>& ct2,
+    const std::vector<std::vector<ModInt>>& relin_key) const {
+    
+    if (ct1.size() != 2 || ct2.size() != 2) {
+        throw std::invalid_argument("Can only multiply size-2 ciphertexts");
+    }
+    
+    auto d = multiply_ciphertexts(ct1[0], ct1[1], ct2[0], ct2[1]);
+    return relinearize(d[0], d[1], d[2], relin_key);
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::add_ciphertexts(
+    const std::vector<std::vector<ModInt>>& ct1,
+    const std::vector<std::vector<ModInt>>& ct2) const {
+    
+    const auto& longer = ct1.size() >= ct2.size() ? ct1 : ct2;
+    const auto& shorter = ct1.size() >= ct2.size() ? ct2 : ct1;
+    
+    std::vector<std::vector<ModInt>> result = longer;
+    for (size_t i = 0; i < shorter.size(); i++) {
+        result[i] = ntt.add(longer[i], shorter[i]);
+    }
+    return result;
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::multiply_scalar(
+    const std::vector<std::vector<ModInt>>& ct,
+    ModInt scalar) const {
+    
+    // Use the centered representative of the scalar in Z_t so that
+    // the noise grows by at most t/2 instead of t
+    scalar %= t;
+    if (scalar < 0) scalar += t;
+    if (scalar > t / 2) scalar -= t;
+    ModInt scalar_q = scalar < 0 ? scalar + q : scalar;
+    
+    std::vector<std::vector<ModInt>> result;
+    result.reserve(ct.size());
+    for (const auto& comp : ct) {
+        result.push_back(ntt.scalar_mul(comp, scalar_q));
+    }
+    return result;
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::multiply_plain(
+    const std::vector<std::vector<ModInt>>& ct,
+    const std::vector<ModInt>& plain) const {
+    FHE_TIME_OP(MultiplyPlain);
+    
+    if (plain.size() != (size_t)N) {
+        throw std::invalid_argument("Plaintext must have size N");
+    }
+    
+    // Centered plaintext coefficients keep the noise growth minimal
+    std::vector<ModInt> plain_q(N);
+    for (int i = 0; i < N; i++) {
+        ModInt v = plain[i] % t;
+        if (v < 0) v += t;
+        plain_q[i] = v > t / 2 ? v - t + q : v;
+    }
+    ntt.forward(plain_q);
+    
+    std::vector<std::vector<ModInt>> result;
+    result.reserve(ct.size());
+    for (const auto& comp : ct) {
+        std::vector<ModInt> comp_ntt = comp;
+        ntt.forward(comp_ntt);
+        std::vector<ModInt> product = ntt.pointwise_multiply(comp_ntt, plain_q);
+        ntt.inverse(product);
+        result.push_back(std::move(product));
+    }
+    return result;
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::add_scalar(
+    const std::vector<std::vector<ModInt>>& ct,
+    ModInt scalar) const {
+    
+    if (ct.empty() || ct[0].size() != (size_t)N) {
+        throw std::invalid_argument("All ciphertext components must have size N");
+    }
+    
+    // A constant polynomial encodes the same value in every slot,
+    // so adding Delta*scalar to the constant coefficient suffices
+    scalar %= t;
+    if (scalar < 0) scalar += t;
+    
+    std::vector<std::vector<ModInt>> result = ct;
+    ModInt scaled = (ModInt)(((__int128)delta * scalar) % q);
+    result[0][0] = (result[0][0] + scaled) % q;
+    return result;
+}
+
+std::optional<std::vector<std::vector<ModInt>>> BFVMultiplier::combine_blocks(
+    const std::vector<std::optional<std::vector<std::vector<ModInt>>>>& blocks,
+    size_t lo, size_t hi,
+    const std::vector<std::vector<std::vector<ModInt>>>& giant_powers,
+    const std::vector<std::vector<ModInt>>& key_ntt) const {
+    
+    if (hi - lo == 1) {
+        return blocks[lo];
+    }
+    
+    // Split at the largest power of two below the block count, so that
+    // p = low(m) + m^(k * split) * high(m) keeps the depth logarithmic
+    size_t split = 1;
+    int level = 0;
+    while (split * 2 < hi - lo) {
+        split *= 2;
+        level++;
+    }
+    
+    auto low = combine_blocks(blocks, lo, lo + split, giant_powers, key_ntt);
+    auto high = combine_blocks(blocks, lo + split, hi, giant_powers, key_ntt);
+    
+    if (!high) {
+        return low;
+    }
+    
+    // Only the high part is multiplied again; low and the product are
+    // summed as size-3 ciphertexts and share the caller's relinearization
+    auto h = relinearize_key_ntt(*high, key_ntt);
+    const auto& g = giant_powers[level];
+    auto shifted = multiply_ciphertexts(h[0], h[1], g[0], g[1]);
+    if (!low) {
+        return shifted;
+    }
+    return add_ciphertexts(*low, shifted);
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::evaluate_polynomial(
+    const std::vector<ModInt>& c0,
+    const std::vector<ModInt>& c1,
+    const std::vector<ModInt>& coeffs,
+    const std::vector<std::vector<ModInt>>& relin_key) const {
+    FHE_TIME_OP(EvaluatePolynomial);
+    
+    if (c0.size() != (size_t)N || c1.size() != (size_t)N) {
+        throw std::invalid_argument("All ciphertext components must have size N");
+    }
+    
+    // Reduce coefficients into [0, t) and drop leading zeros
+    std::vector<ModInt> a(coeffs.size());
+    for (size_t i = 0; i < coeffs.size(); i++) {
+        a[i] = coeffs[i] % t;
+        if (a[i] < 0) a[i] += t;
+    }
+    while (!a.empty() && a.back() == 0) {
+        a.pop_back();
+    }
+    
+    // Constant polynomial: return a noiseless trivial encryption
+    if (a.size() <= 1) {
+        std::vector<std::vector<ModInt>> trivial(2, std::vector<ModInt>(N, 0));
+        return add_scalar(trivial, a.empty() ? 0 : a[0]);
+    }
+    
+    size_t degree = a.size() - 1;
+    
+    // Baby-step size k: a power of two close to sqrt(d + 1)
+    size_t k = 1;
+    while (k * k < degree + 1) {
+        k *= 2;
+    }
+    
+    // Baby steps m^1 .. m^k, each at depth ceil(log2(i)); m^k is only
+    // needed as the first giant step when there is more than one block
+    size_t num_blocks = (a.size() + k - 1) / k;
+    size_t max_power = num_blocks > 1 ? k : degree;
+    
+    const auto key_ntt = relin_key_ntt(relin_key);
+    
+    // m^i = m^other * m^rest; a baby step is relinearized only if it is
+    // a factor of a later one or the first giant step, otherwise it enters
+    // the blocks below as a size-3 ciphertext
+    auto factors = [](size_t i) {
+        size_t high_bit = 1;
+        while (high_bit * 2 <= i) {
+            high_bit *= 2;
+        }
+        size_t rest = (i == high_bit) ? i / 2 : i - high_bit;
+        size_t other = (i == high_bit) ? i / 2 : high_bit;
+        return std::make_pair(other, rest);
+    };
+    std::vector<bool> is_factor(k + 1, false);
+    for (size_t i = 2; i <= max_power; i++) {
+        auto [other, rest] = factors(i);
+        is_factor[other] = is_factor[rest] = true;
+    }
+    if (num_blocks > 1) {
+        is_factor[k] = true;
+    }
+    
+    std::vector<std::vector<std::vector<ModInt>>> powers(k + 1);
+    powers[1] = {c0, c1};
+    for (size_t i = 2; i <= max_power; i++) {
+        auto [other, rest] = factors(i);
+        const auto& x = powers[other];
+        const auto& y = powers[rest];
+        powers[i] = multiply_ciphertexts(x[0], x[1], y[0], y[1]);
+        if (is_factor[i]) {
+            powers[i] = relinearize_key_ntt(powers[i], *key_ntt);
+        }
+    }
+    
+    // Transform the baby steps to NTT form once; every block below is
+    // then a linear combination computed pointwise without further NTTs
+    std::vector<std::vector<std::vector<ModInt>>> powers_ntt(k);
+    for (size_t i = 1; i < k && i <= max_power; i++) {
+        powers_ntt[i] = powers[i];
+        for (auto& comp : powers_ntt[i]) {
+            ntt.forward(comp);
+        }
+    }
+    
+    // Giant steps m^k, m^2k, m^4k, ... by repeated squaring
+    std::vector<std::vector<std::vector<ModInt>>> giant_powers;
+    if (num_blocks > 1) {
+        giant_powers.push_back(powers[k]);
+    }
+    for (size_t span = 2; span < num_blocks; span *= 2) {
+        const auto& prev = giant_powers.back();
+        giant_powers.push_back(relinearize_key_ntt(
+            multiply_ciphertexts(prev[0], prev[1], prev[0], prev[1]), *key_ntt));
+    }
+    
+    // Evaluate each block q_j(m) = sum_{i<k} a[jk + i] m^i with scalar
+    // multiplications only, accumulating in 128 bits before reducing
+    std::vector<std::optional<std::vector<std::vector<ModInt>>>> blocks(num_blocks);
+    for (size_t j = 0; j < num_blocks; j++) {
+        size_t base = j * k;
+        size_t end = std::min(base + k, a.size());
+        
+        bool has_linear = false;
+        for (size_t i = base + 1; i < end; i++) {
+            has_linear |= (a[i] != 0);
+        }
+        if (!has_linear) {
+            if (a[base] != 0) {
+                std::vector<std::vector<ModInt>> trivial(2, std::vector<ModInt>(N, 0));
+                blocks[j] = add_scalar(trivial, a[base]);
+            }
+            continue;
+        }
+        
+        // Size 3 as soon as one term is an unrelinearized baby step
+        size_t size = 2;
+        for (size_t i = base + 1; i < end; i++) {
+            if (a[i] != 0) size = std::max(size, powers_ntt[i - base].size());
+        }
+        
+        std::vector<std::vector<ModInt>> block(size, std::vector<ModInt>(N));
+        for (size_t comp = 0; comp < size; comp++) {
+            std::vector<__int128> acc(N, 0);
+            for (size_t i = base + 1; i < end; i++) {
+                if (a[i] == 0 || comp >= powers_ntt[i - base].size()) continue;
+                ModInt scalar = a[i] > t / 2 ? a[i] - t : a[i];
+                const auto& src = powers_ntt[i - base][comp];
+                for (int n = 0; n < N; n++) {
+                    acc[n] += (__int128)src[n] * scalar;
+                }
+            }
+            for (int n = 0; n < N; n++) {
+                ModInt r = (ModInt)(acc[n] % q);
+                block[comp][n] = r < 0 ? r + q : r;
+            }
+            ntt.inverse(block[comp]);
+        }
+        blocks[j] = add_scalar(block, a[base]);
+    }
+    
+    auto result = combine_blocks(blocks, 0, num_blocks, giant_powers, *key_ntt);
+    return relinearize_key_ntt(*result, *key_ntt);
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::lookup(
+    const std::vector<ModInt>& c0,
+    const std::vector<ModInt>& c1,
+    const LookupTable& table,
+    const std::vector<std::vector<ModInt>>& relin_key) const {
+    
+    if (table.get_t() != t) {
+        throw std::invalid_argument("Lookup table plaintext modulus does not match t");
+    }
+    
+    return evaluate_polynomial(c0, c1, table.get_coefficients(), relin_key);
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::rotate_ntt(
+    const std::vector<std::vector<ModInt>>& ct_ntt,
+    uint64_t galois_elt,
+    const GaloisKeys& galois_keys) const {
+    
+    if (ct_ntt.size() != 2) {
+        throw std::invalid_argument("Can only rotate size-2 ciphertexts");
+    }
+    
+    std::vector<ModInt> c1 = ct_ntt[1];
+    ntt.inverse(c1);
+    return rotate_digits_ntt(ct_ntt[0], decompose_ntt(c1), galois_elt, galois_keys);
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::rotate_digits_ntt(
+    const std::vector<ModInt>& c0_ntt,
+    const std::vector<std::vector<ModInt>>& c1_digits_ntt,
+    uint64_t galois_elt,
+    const GaloisKeys& galois_keys) const {
+    FHE_COUNT(KeySwitch, 1);
+    FHE_TRACE_SPAN("rotate_key_switch", "keyswitch");
+    FHE_PERF_SCOPE(KeySwitch, 2 * N);
+    
+    const auto& key = galois_keys.get(galois_elt);
     
-    // Relinearization: reduce (d0, d1, d2) to (c0, c1)
-    // Using evaluation key (relinearization key)
+    // (c0(X^g), c1(X^g)) decrypts under s(X^g); switch it back to s:
+    // c0' = c0(X^g) + sum_j D_j(c1)(X^g) * b_j, c1' = sum_j D_j(c1)(X^g) * a_j
+    std::vector<std::vector<ModInt>> rotated(c1_digits_ntt.size());
+    for (size_t j = 0; j < rotated.size(); j++) {
+        rotated[j] = galois.apply_ntt(c1_digits_ntt[j], galois_elt);
+    }
+    
+    std::vector<std::vector<ModInt>> result = key_switch_digits_ntt(rotated, key);
+    result[0] = ntt.add(result[0], galois.apply_ntt(c0_ntt, galois_elt));
+    return result;
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::apply_galois(
+    const std::vector<ModInt>& c0,
+    const std::vector<ModInt>& c1,
+    uint64_t galois_elt,
+    const GaloisKeys& galois_keys) const {
     
-    if (relin_key.size() < 2 || relin_key[0].size() != N || relin_key[1].size() != N) {
-        throw std::invalid_argument("Invalid relinearization key format");
+    return rotate_hoisted(c0, c1, {galois_elt}, galois_keys)[0];
+}
+
+std::vector<std::vector<std::vector<ModInt>>> BFVMultiplier::rotate_hoisted(
+    const std::vector<ModInt>& c0,
+    const std::vector<ModInt>& c1,
+    const std::vector<uint64_t>& galois_elts,
+    const GaloisKeys& galois_keys) const {
+    FHE_TIME_OP(Rotate);
+    
+    if (c0.size() != (size_t)N || c1.size() != (size_t)N) {
+        throw std::invalid_argument("All ciphertext components must have size N");
     }
     
-    // Decompose d2
-    std::vector<ModInt> d2_decomp = gadget_decompose(d2);
+    std::vector<ModInt> c0_ntt = c0;
+    ntt.forward(c0_ntt);
+    std::vector<std::vector<ModInt>> c1_digits = decompose_ntt(c1);
     
-    // The relin_key should have been constructed as (evk_0, evk_1)
-    // where evk encrypts s^2
+    std::vector<std::vector<std::vector<ModInt>>> results;
+    results.reserve(galois_elts.size());
+    for (uint64_t elt : galois_elts) {
+        auto rotated = rotate_digits_ntt(c0_ntt, c1_digits, elt, galois_keys);
+        for (auto& comp : rotated) {
+            ntt.inverse(comp);
+        }
+        results.push_back(std::move(rotated));
+    }
+    return results;
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::sum_slots(
+    const std::vector<ModInt>& c0,
+    const std::vector<ModInt>& c1,
+    const GaloisKeys& galois_keys) const {
+    FHE_TIME_OP(SumSlots);
+    
+    if (c0.size() != (size_t)N || c1.size() != (size_t)N) {
+        throw std::invalid_argument("All ciphertext components must have size N");
+    }
     
-    // For simplicity, we'll use a basic approach:
-    // new_c0 = d0 + d2 * relin_key[0]
-    // new_c1 = d1 + d2 * relin_key[1]
+    std::vector<std::vector<ModInt>> acc = {c0, c1};
+    for (auto& comp : acc) {
+        ntt.forward(comp);
+    }
     
-    std::vector<ModInt> rk0_contrib = ntt.multiply(d2, relin_key[0]);
-    std::vector<ModInt> rk1_contrib = ntt.multiply(d2, relin_key[1]);
+    // acc <- acc + rot(acc) doubles the number of summed slots per step;
+    // only c1 leaves NTT form, to be decomposed for each key switch
+    for (uint64_t elt : galois.sum_slots_elts()) {
+        auto rotated = rotate_ntt(acc, elt, galois_keys);
+        acc[0] = ntt.add(acc[0], rotated[0]);
+        acc[1] = ntt.add(acc[1], rotated[1]);
+    }
     
-    std::vector<ModInt> c0 = ntt.add(d0, rk0_contrib);
-    std::vector<ModInt> c1 = ntt.add(d1, rk1_contrib);
+    for (auto& comp : acc) {
+        ntt.inverse(comp);
+    }
+    return acc;
+}
+
+std::vector<std::vector<ModInt>> BFVMultiplier::masked_sum(
+    const std::vector<std::vector<ModInt>>& ct_values,
+    const std::vector<std::vector<ModInt>>& ct_mask,
+    const std::vector<std::vector<ModInt>>& relin_key,
+    const GaloisKeys& galois_keys) const {
     
-    return {c0, c1};
+    auto masked = multiply_relinearize(ct_values, ct_mask, relin_key);
+    return sum_slots(masked[0], masked[1], galois_keys);
 }
 
 } // namespace fhe_cpp
@@ -7,24 +7,63 @@
 #define FHE_BFV_MULT_H
 
 #include "ntt.h"
+#include "lookup_table.h"
+#include "galois.h"
+#include "gadget.h"
 #include <vector>
+#include <optional>
+#include <memory>
+#include <mutex>
 
 namespace fhe_cpp {
 
 class BFVMultiplier {
 private:
     NTT ntt;
+    GaloisTool galois;
     ModInt q;
     ModInt t;
     int N;
     ModInt delta;  // floor(q/t)
+    GadgetDecomposition gadget;
     
-    // Gadget matrix operations
-    std::vector<ModInt> gadget_decompose(const std::vector<ModInt>& vec);
-    std::vector<ModInt> gadget_compose(const std::vector<ModInt>& vec);
+    // Two auxiliary NTT primes whose product exceeds 2*t*N*q: the tensor
+    // product is computed exactly over Z (via CRT) before the t/q rescale
+    std::vector<NTT> aux_ntt;
+    std::vector<ModInt> aux_q_inv;  // q^-1 mod p_i
+    ModInt aux_crt;                 // p_0^-1 mod p_1
+    
+    // round(t * d / q) mod q for the integer d given by its residues mod q
+    // and mod both auxiliary primes
+    ModInt rescale(ModInt d_q, ModInt d_p0, ModInt d_p1) const;
+    
+    // Relinearization key in NTT form, transformed on first use and kept
+    // while callers pass the same key (GaloisKeys are stored this way)
+    mutable std::mutex relin_cache_mutex;
+    mutable std::vector<std::vector<ModInt>> relin_key_cached;
+    mutable std::shared_ptr<const std::vector<std::vector<ModInt>>> relin_key_ntt_cached;
+    
+    std::shared_ptr<const std::vector<std::vector<ModInt>>> relin_key_ntt(
+        const std::vector<std::vector<ModInt>>& relin_key) const;
+    
+    // Relinearize a size-3 ciphertext with the key in NTT form; size-2
+    // ciphertexts are returned unchanged
+    std::vector<std::vector<ModInt>> relinearize_key_ntt(
+        const std::vector<std::vector<ModInt>>& ct,
+        const std::vector<std::vector<ModInt>>& key_ntt) const;
+    
+    // Paterson-Stockmeyer giant-step recursion over blocks [lo, hi)
+    // Blocks and the result may be left unrelinearized (size 3)
+    std::optional<std::vector<std::vector<ModInt>>> combine_blocks(
+        const std::vector<std::optional<std::vector<std::vector<ModInt>>>>& blocks,
+        size_t lo, size_t hi,
+        const std::vector<std::vector<std::vector<ModInt>>>& giant_powers,
+        const std::vector<std::vector<ModInt>>& key_ntt) const;
     
 public:
-    BFVMultiplier(int N, ModInt q, ModInt t);
+    // decomp_bits is the key-switching digit size (0: no decomposition);
+    // relinearization and Galois keys must be generated with the same one
+    BFVMultiplier(int N, ModInt q, ModInt t, int decomp_bits = DEFAULT_DECOMP_BITS);
     ~BFVMultiplier() = default;
     
     // Multiply two ciphertexts (c0, c1) format
@@ -34,20 +73,152 @@ public:
         const std::vector<ModInt>& c1_1,
         const std::vector<ModInt>& c2_0,
         const std::vector<ModInt>& c2_1
-    );
+    ) const;
+    
+    // Same as multiply_ciphertexts, reusing NTT forms (mod q) the caller
+    // already holds, so cached transforms of reused operands are not
+    // recomputed; the coefficient forms are still needed for the exact
+    // product over Z
+    std::vector<std::vector<ModInt>> multiply_ciphertexts_ntt(
+        const std::vector<std::vector<ModInt>>& ct1,
+        const std::vector<std::vector<ModInt>>& ct1_ntt,
+        const std::vector<std::vector<ModInt>>& ct2,
+        const std::vector<std::vector<ModInt>>& ct2_ntt
+    ) const;
     
     // Relinearize (d0, d1, d2) back to (c0, c1)
+    // relin_key holds one pair (b_j, a_j) per decomposition digit, flattened
+    // as [b_0, a_0, b_1, a_1, ...], with b_j = -(a_j*s + e_j) + w^j * s^2
     std::vector<std::vector<ModInt>> relinearize(
         const std::vector<ModInt>& d0,
         const std::vector<ModInt>& d1,
         const std::vector<ModInt>& d2,
         const std::vector<std::vector<ModInt>>& relin_key
-    );
+    ) const;
+    
+    // Key switch of poly (coefficient form) with a per-digit key in NTT
+    // form: returns sum_j (D_j(poly) * key[2j], D_j(poly) * key[2j+1]) in
+    // NTT form
+    std::vector<std::vector<ModInt>> key_switch_ntt(
+        const std::vector<ModInt>& poly,
+        const std::vector<std::vector<ModInt>>& key_ntt
+    ) const;
+    
+    // Digits D_j(poly) of a polynomial in coefficient form, each in NTT form
+    std::vector<std::vector<ModInt>> decompose_ntt(const std::vector<ModInt>& poly) const;
+    
+    // key_switch_ntt for digits already decomposed by decompose_ntt
+    std::vector<std::vector<ModInt>> key_switch_digits_ntt(
+        const std::vector<std::vector<ModInt>>& digits_ntt,
+        const std::vector<std::vector<ModInt>>& key_ntt
+    ) const;
+    
+    // Multiply two size-2 ciphertexts and relinearize back to size 2
+    std::vector<std::vector<ModInt>> multiply_relinearize(
+        const std::vector<std::vector<ModInt>>& ct1,
+        const std::vector<std::vector<ModInt>>& ct2,
+        const std::vector<std::vector<ModInt>>& relin_key
+    ) const;
+    
+    // Component-wise sum of two ciphertexts (sizes may differ)
+    std::vector<std::vector<ModInt>> add_ciphertexts(
+        const std::vector<std::vector<ModInt>>& ct1,
+        const std::vector<std::vector<ModInt>>& ct2
+    ) const;
+    
+    // Multiply the encrypted message by a plaintext constant in Z_t
+    std::vector<std::vector<ModInt>> multiply_scalar(
+        const std::vector<std::vector<ModInt>>& ct,
+        ModInt scalar
+    ) const;
+    
+    // Multiply by a plaintext polynomial with coefficients in Z_t
+    std::vector<std::vector<ModInt>> multiply_plain(
+        const std::vector<std::vector<ModInt>>& ct,
+        const std::vector<ModInt>& plain
+    ) const;
+    
+    // Add a plaintext constant in Z_t to every slot of the message
+    std::vector<std::vector<ModInt>> add_scalar(
+        const std::vector<std::vector<ModInt>>& ct,
+        ModInt scalar
+    ) const;
+    
+    // Evaluate p(m) = sum coeffs[i] * m^i over Z_t homomorphically
+    // Baby-step/giant-step Paterson-Stockmeyer: O(sqrt(d)) ciphertext
+    // multiplications and O(log d) depth for a degree-d polynomial
+    // Products are only relinearized before they are multiplied again, and
+    // the result once at the end
+    std::vector<std::vector<ModInt>> evaluate_polynomial(
+        const std::vector<ModInt>& c0,
+        const std::vector<ModInt>& c1,
+        const std::vector<ModInt>& coeffs,
+        const std::vector<std::vector<ModInt>>& relin_key
+    ) const;
+    
+    // Map every slot m to table[m] using the table's cached interpolation
+    std::vector<std::vector<ModInt>> lookup(
+        const std::vector<ModInt>& c0,
+        const std::vector<ModInt>& c1,
+        const LookupTable& table,
+        const std::vector<std::vector<ModInt>>& relin_key
+    ) const;
+    
+    // Apply the automorphism X -> X^g (a slot rotation) to a ciphertext
+    std::vector<std::vector<ModInt>> apply_galois(
+        const std::vector<ModInt>& c0,
+        const std::vector<ModInt>& c1,
+        uint64_t galois_elt,
+        const GaloisKeys& galois_keys
+    ) const;
+    
+    // Apply X -> X^g and key-switch back to s, all in NTT form
+    // c1 is decomposed on every call (one inverse and l forward NTTs)
+    std::vector<std::vector<ModInt>> rotate_ntt(
+        const std::vector<std::vector<ModInt>>& ct_ntt,
+        uint64_t galois_elt,
+        const GaloisKeys& galois_keys
+    ) const;
+    
+    // Rotation from c0 in NTT form and the digits of c1 from decompose_ntt
+    // X -> X^g maps the digits of c1 to digits of c1(X^g), so rotations of
+    // one ciphertext share a single decomposition (hoisting)
+    std::vector<std::vector<ModInt>> rotate_digits_ntt(
+        const std::vector<ModInt>& c0_ntt,
+        const std::vector<std::vector<ModInt>>& c1_digits_ntt,
+        uint64_t galois_elt,
+        const GaloisKeys& galois_keys
+    ) const;
+    
+    // Several rotations of the same ciphertext with hoisted NTTs:
+    // c0 is transformed and c1 decomposed once, shared by every rotation
+    std::vector<std::vector<std::vector<ModInt>>> rotate_hoisted(
+        const std::vector<ModInt>& c0,
+        const std::vector<ModInt>& c1,
+        const std::vector<uint64_t>& galois_elts,
+        const GaloisKeys& galois_keys
+    ) const;
+    
+    // Fold all N slots so that every slot holds their sum
+    // log2(N/2) row rotations plus one column swap, kept in NTT form
+    std::vector<std::vector<ModInt>> sum_slots(
+        const std::vector<ModInt>& c0,
+        const std::vector<ModInt>& c1,
+        const GaloisKeys& galois_keys
+    ) const;
     
-    // Scale multiplication result properly (BFV specific)
-    std::vector<ModInt> scale_down(const std::vector<ModInt>& poly);
+    // sum_slots(values * mask) for a 0/1 mask, e.g. a COUNT or SUM filter
+    std::vector<std::vector<ModInt>> masked_sum(
+        const std::vector<std::vector<ModInt>>& ct_values,
+        const std::vector<std::vector<ModInt>>& ct_mask,
+        const std::vector<std::vector<ModInt>>& relin_key,
+        const GaloisKeys& galois_keys
+    ) const;
     
     ModInt get_delta() const { return delta; }
+    const GadgetDecomposition& get_gadget() const { return gadget; }
+    ModInt get_t() const { return t; }
+    const NTT& get_ntt() const { return ntt; }
 };
 
 } // namespace fhe_cpp
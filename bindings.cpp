@@ -6,14 +6,35 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/numpy.h>
+#include <pybind11/functional.h>
 #include "ntt.h"
+#include "ntt_tuning.h"
 #include "bfv_mult.h"
+#include "lookup_table.h"
+#include "galois.h"
+#include "table_scan.h"
+#include "string_match.h"
+#include "linear_algebra.h"
+#include "expr_graph.h"
+#include "batch_encoder.h"
+#include "decryptor.h"
+#include "encryptor.h"
+#include "noise.h"
+#include "param_planner.h"
+#include "modulus_switch.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include "thread_pool.h"
+#include <exception>
+#include <memory>
 
 namespace py = pybind11;
 using namespace fhe_cpp;
 
 // Helper to convert numpy arrays to std::vector
 std::vector<ModInt> numpy_to_vector(py::array_t<int64_t> arr) {
+    FHE_TRACE_SPAN("numpy_to_vector", "python");
     auto buf = arr.request();
     int64_t* ptr = static_cast<int64_t*>(buf.ptr);
     return std::vector<ModInt>(ptr, ptr + buf.size);
@@ -21,17 +42,117 @@ std::vector<ModInt> numpy_to_vector(py::array_t<int64_t> arr) {
 
 // Helper to convert std::vector to numpy array
 py::array_t<int64_t> vector_to_numpy(const std::vector<ModInt>& vec) {
+    FHE_TRACE_SPAN("vector_to_numpy", "python");
     return py::array_t<int64_t>(vec.size(), vec.data());
 }
 
+// Helper to convert a (c0, c1[, c2]) tuple of numpy arrays to components
+std::vector<std::vector<ModInt>> tuple_to_ciphertext(py::tuple ct) {
+    std::vector<std::vector<ModInt>> result;
+    for (auto comp : ct) {
+        result.push_back(numpy_to_vector(comp.cast<py::array_t<int64_t>>()));
+    }
+    return result;
+}
+
+// Helper to convert a key given as a list of numpy arrays, e.g. a
+// relinearization key [b_0, a_0, b_1, a_1, ...]
+std::vector<std::vector<ModInt>> sequence_to_key(py::sequence key) {
+    std::vector<std::vector<ModInt>> result;
+    for (auto comp : key) {
+        result.push_back(numpy_to_vector(comp.cast<py::array_t<int64_t>>()));
+    }
+    return result;
+}
+
+// Helper to convert ciphertext components to a tuple of numpy arrays
+py::tuple ciphertext_to_tuple(const std::vector<std::vector<ModInt>>& ct) {
+    py::tuple result(ct.size());
+    for (size_t i = 0; i < ct.size(); i++) {
+        result[i] = vector_to_numpy(ct[i]);
+    }
+    return result;
+}
+
+// Helper for async methods: run work() on the global thread pool and
+// return an asyncio future of the running loop, resolved with
+// convert(result) through loop.call_soon_threadsafe
+// owner (the bound C++ object) is kept alive until the future resolves;
+// all Python references are created and dropped with the GIL held
+// Only for single operations: a parallel_for inside work() runs inline
+// on the pool worker, so batched calls are awaited from Python through
+// an executor thread instead
+template <typename Result>
+py::object submit_async(py::object owner, std::function<Result()> work,
+                        std::function<py::object(const Result&)> convert) {
+    struct Pending {
+        py::object owner;
+        py::object loop;
+        py::object future;
+    };
+    auto pending = std::make_shared<Pending>();
+    pending->owner = std::move(owner);
+    pending->loop = py::module_::import("asyncio").attr("get_running_loop")();
+    pending->future = pending->loop.attr("create_future")();
+    py::object future = pending->future;
+    
+    ThreadPool::global()->submit([pending, work = std::move(work),
+                                  convert = std::move(convert)] {
+        Result result;
+        std::exception_ptr error;
+        try {
+            result = work();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        
+        py::gil_scoped_acquire acquire;
+        py::object value;
+        bool failed = error != nullptr;
+        try {
+            if (error) std::rethrow_exception(error);
+            value = convert(result);
+        } catch (const std::invalid_argument& e) {
+            value = py::module_::import("builtins").attr("ValueError")(e.what());
+            failed = true;
+        } catch (const std::exception& e) {
+            value = py::module_::import("builtins").attr("RuntimeError")(e.what());
+            failed = true;
+        }
+        
+        py::cpp_function resolve([](py::object fut, py::object v, bool is_error) {
+            if (fut.attr("done")().cast<bool>()) return;   // Cancelled meanwhile
+            fut.attr(is_error ? "set_exception" : "set_result")(v);
+        });
+        try {
+            pending->loop.attr("call_soon_threadsafe")(resolve, pending->future, value, failed);
+        } catch (py::error_already_set&) {
+            // Loop already closed: nobody is waiting for the result
+        }
+        pending->owner = py::object();
+        pending->loop = py::object();
+        pending->future = py::object();
+    });
+    return future;
+}
+
 PYBIND11_MODULE(fhe_fast_mult, m) {
     m.doc() = "Fast FHE multiplication using NTT (C++ backend)";
     
     // NTT class bindings
     py::class_<NTT>(m, "NTT")
-        .def(py::init<int, ModInt>(),
-             py::arg("N"), py::arg("q"),
-             "Initialize NTT with polynomial degree N and modulus q")
+        .def(py::init([](int N, ModInt q, const std::string& variant) {
+                 return new NTT(N, q, parse_ntt_variant(variant));
+             }),
+             py::arg("N"), py::arg("q"), py::arg("variant") = "auto",
+             "Initialize NTT with polynomial degree N and modulus q; variant is "
+             "'auto' (tuning profile), 'reference', 'merged' or 'merged_shoup'")
+        
+        .def("variant", [](const NTT& ntt) {
+            return std::string(ntt_variant_name(ntt.get_variant()));
+        }, "Kernel this transform dispatches to")
+        .def("parallel_batch", &NTT::get_parallel_batch,
+             "Smallest batch transformed on the thread pool")
         
         .def("multiply", [](const NTT& ntt, 
                            py::array_t<int64_t> a, 
@@ -76,9 +197,21 @@ PYBIND11_MODULE(fhe_fast_mult, m) {
     
     // BFVMultiplier class bindings
     py::class_<BFVMultiplier>(m, "BFVMultiplier")
-        .def(py::init<int, ModInt, ModInt>(),
+        .def(py::init<int, ModInt, ModInt, int>(),
              py::arg("N"), py::arg("q"), py::arg("t"),
-             "Initialize BFV multiplier with N, q (ciphertext modulus), t (plaintext modulus)")
+             py::arg("decomp_bits") = DEFAULT_DECOMP_BITS,
+             "Initialize BFV multiplier with N, q (ciphertext modulus), t (plaintext modulus) "
+             "and the key-switching digit size in bits (0: no decomposition)")
+        
+        .def("decomp_bits", [](const BFVMultiplier& mult) {
+            return mult.get_gadget().digit_bits();
+        }, "Key-switching digit size w = 2^decomp_bits")
+        .def("num_digits", [](const BFVMultiplier& mult) {
+            return mult.get_gadget().num_digits();
+        }, "Digits per key switch; keys hold one (b, a) pair per digit")
+        .def("digit_power", [](const BFVMultiplier& mult, int j) {
+            return mult.get_gadget().power(j);
+        }, py::arg("j"), "w^j mod q, the factor key j encrypts with the target secret")
         
         .def("multiply_ciphertexts", [](const BFVMultiplier& mult,
                                         py::array_t<int64_t> c1_0,
@@ -104,12 +237,8 @@ PYBIND11_MODULE(fhe_fast_mult, m) {
                               py::array_t<int64_t> d0,
                               py::array_t<int64_t> d1,
                               py::array_t<int64_t> d2,
-                              py::array_t<int64_t> rk0,
-                              py::array_t<int64_t> rk1) {
-            std::vector<std::vector<ModInt>> relin_key = {
-                numpy_to_vector(rk0),
-                numpy_to_vector(rk1)
-            };
+                              py::sequence relin_key_seq) {
+            std::vector<std::vector<ModInt>> relin_key = sequence_to_key(relin_key_seq);
             
             auto result = mult.relinearize(
                 numpy_to_vector(d0),
@@ -124,28 +253,916 @@ PYBIND11_MODULE(fhe_fast_mult, m) {
             );
         }, "Relinearize (d0, d1, d2) to (c0, c1)")
         
+        .def("multiply_ciphertexts_async", [](py::object self,
+                                              py::array_t<int64_t> c1_0,
+                                              py::array_t<int64_t> c1_1,
+                                              py::array_t<int64_t> c2_0,
+                                              py::array_t<int64_t> c2_1) {
+            const BFVMultiplier* mult = &self.cast<const BFVMultiplier&>();
+            return submit_async<std::vector<std::vector<ModInt>>>(self,
+                [mult, a0 = numpy_to_vector(c1_0), a1 = numpy_to_vector(c1_1),
+                 b0 = numpy_to_vector(c2_0), b1 = numpy_to_vector(c2_1)] {
+                    return mult->multiply_ciphertexts(a0, a1, b0, b1);
+                },
+                [](const std::vector<std::vector<ModInt>>& r) -> py::object {
+                    return ciphertext_to_tuple(r);
+                });
+        }, "Awaitable multiply_ciphertexts, computed on the native thread pool")
+        
+        .def("relinearize_async", [](py::object self,
+                                     py::array_t<int64_t> d0,
+                                     py::array_t<int64_t> d1,
+                                     py::array_t<int64_t> d2,
+                                     py::sequence relin_key_seq) {
+            const BFVMultiplier* mult = &self.cast<const BFVMultiplier&>();
+            std::vector<std::vector<ModInt>> relin_key = sequence_to_key(relin_key_seq);
+            return submit_async<std::vector<std::vector<ModInt>>>(self,
+                [mult, e0 = numpy_to_vector(d0), e1 = numpy_to_vector(d1),
+                 e2 = numpy_to_vector(d2), relin_key] {
+                    return mult->relinearize(e0, e1, e2, relin_key);
+                },
+                [](const std::vector<std::vector<ModInt>>& r) -> py::object {
+                    return ciphertext_to_tuple(r);
+                });
+        }, "Awaitable relinearize, computed on the native thread pool")
+        
+        .def("evaluate_polynomial", [](const BFVMultiplier& mult,
+                                       py::array_t<int64_t> c0,
+                                       py::array_t<int64_t> c1,
+                                       py::array_t<int64_t> coeffs,
+                                       py::sequence relin_key_seq) {
+            std::vector<std::vector<ModInt>> relin_key = sequence_to_key(relin_key_seq);
+            
+            auto result = mult.evaluate_polynomial(
+                numpy_to_vector(c0),
+                numpy_to_vector(c1),
+                numpy_to_vector(coeffs),
+                relin_key
+            );
+            
+            return py::make_tuple(
+                vector_to_numpy(result[0]),
+                vector_to_numpy(result[1])
+            );
+        }, py::arg("c0"), py::arg("c1"), py::arg("coeffs"),
+           py::arg("relin_key"),
+           "Evaluate sum coeffs[i] * m^i over Z_t (Paterson-Stockmeyer)")
+        
+        .def("lookup", [](const BFVMultiplier& mult,
+                          py::array_t<int64_t> c0,
+                          py::array_t<int64_t> c1,
+                          const LookupTable& table,
+                          py::sequence relin_key_seq) {
+            std::vector<std::vector<ModInt>> relin_key = sequence_to_key(relin_key_seq);
+            
+            auto result = mult.lookup(
+                numpy_to_vector(c0),
+                numpy_to_vector(c1),
+                table,
+                relin_key
+            );
+            
+            return py::make_tuple(
+                vector_to_numpy(result[0]),
+                vector_to_numpy(result[1])
+            );
+        }, py::arg("c0"), py::arg("c1"), py::arg("table"),
+           py::arg("relin_key"),
+           "Map each encrypted value m to table[m]")
+        
+        .def("apply_galois", [](const BFVMultiplier& mult,
+                                py::array_t<int64_t> c0,
+                                py::array_t<int64_t> c1,
+                                uint64_t galois_elt,
+                                const GaloisKeys& galois_keys) {
+            auto result = mult.apply_galois(
+                numpy_to_vector(c0), numpy_to_vector(c1),
+                galois_elt, galois_keys);
+            return ciphertext_to_tuple(result);
+        }, py::arg("c0"), py::arg("c1"), py::arg("galois_elt"),
+           py::arg("galois_keys"),
+           "Apply X -> X^g to a ciphertext (slot rotation)")
+        
+        .def("rotate_hoisted", [](const BFVMultiplier& mult,
+                                  py::array_t<int64_t> c0,
+                                  py::array_t<int64_t> c1,
+                                  std::vector<uint64_t> galois_elts,
+                                  const GaloisKeys& galois_keys) {
+            auto results = mult.rotate_hoisted(
+                numpy_to_vector(c0), numpy_to_vector(c1),
+                galois_elts, galois_keys);
+            py::list out;
+            for (const auto& ct : results) {
+                out.append(ciphertext_to_tuple(ct));
+            }
+            return out;
+        }, py::arg("c0"), py::arg("c1"), py::arg("galois_elts"),
+           py::arg("galois_keys"),
+           "Several rotations of one ciphertext sharing a single NTT")
+        
+        .def("sum_slots", [](const BFVMultiplier& mult,
+                             py::array_t<int64_t> c0,
+                             py::array_t<int64_t> c1,
+                             const GaloisKeys& galois_keys) {
+            auto result = mult.sum_slots(
+                numpy_to_vector(c0), numpy_to_vector(c1), galois_keys);
+            return ciphertext_to_tuple(result);
+        }, py::arg("c0"), py::arg("c1"), py::arg("galois_keys"),
+           "Sum all slots into every slot (rotate-and-sum)")
+        
+        .def("multiply_plain", [](const BFVMultiplier& mult, py::tuple ct,
+                                  py::array_t<int64_t> plain) {
+            return ciphertext_to_tuple(mult.multiply_plain(tuple_to_ciphertext(ct),
+                                                           numpy_to_vector(plain)));
+        }, py::arg("ct"), py::arg("plain"),
+           "Multiply by a plaintext polynomial (centered coefficients, NTT)")
+        
+        .def("multiply_scalar", [](const BFVMultiplier& mult, py::tuple ct, ModInt scalar) {
+            return ciphertext_to_tuple(mult.multiply_scalar(tuple_to_ciphertext(ct), scalar));
+        }, py::arg("ct"), py::arg("scalar"),
+           "Multiply the encrypted message by a constant in Z_t")
+        
+        .def("masked_sum", [](const BFVMultiplier& mult,
+                              py::tuple ct_values,
+                              py::tuple ct_mask,
+                              py::sequence relin_key_seq,
+                              const GaloisKeys& galois_keys) {
+            std::vector<std::vector<ModInt>> relin_key = sequence_to_key(relin_key_seq);
+            auto result = mult.masked_sum(
+                tuple_to_ciphertext(ct_values), tuple_to_ciphertext(ct_mask),
+                relin_key, galois_keys);
+            return ciphertext_to_tuple(result);
+        }, py::arg("ct_values"), py::arg("ct_mask"),
+           py::arg("relin_key"), py::arg("galois_keys"),
+           "Sum of values over the slots where mask is 1")
+        
+        .def("inner_product_coeff", [](const BFVMultiplier& mult,
+                                       py::array_t<int64_t> c0,
+                                       py::array_t<int64_t> c1,
+                                       py::array_t<int64_t> pt_vector) {
+            const NTT& ntt = mult.get_ntt();
+            auto plain = encode_coeff_reversed(
+                numpy_to_vector(pt_vector), ntt.get_N(), mult.get_t());
+            auto result = mult.multiply_plain(
+                {numpy_to_vector(c0), numpy_to_vector(c1)}, plain);
+            return ciphertext_to_tuple(result);
+        }, py::arg("c0"), py::arg("c1"), py::arg("pt_vector"),
+           "Inner product with a plaintext vector in coefficient 0 "
+           "(ciphertext must use coefficient encoding)")
+        
         .def("get_delta", &BFVMultiplier::get_delta,
              "Get delta = floor(q/t)");
     
-    // Utility functions
-    m.def("find_ntt_prime", [](int N) -> int64_t {
-        // Find a prime q such that q = 1 (mod 2N)
-        int64_t q = 2 * N + 1;
-        
-        auto is_prime = [](int64_t n) {
-            if (n < 2) return false;
-            if (n == 2) return true;
-            if (n % 2 == 0) return false;
-            for (int64_t i = 3; i * i <= n; i += 2) {
-                if (n % i == 0) return false;
-            }
-            return true;
-        };
-        
-        while (!is_prime(q)) {
-            q += 2 * N;
-        }
+    // LookupTable class bindings
+    py::class_<LookupTable>(m, "LookupTable")
+        .def(py::init([](py::array_t<int64_t> table, ModInt t) {
+                 return new LookupTable(numpy_to_vector(table), t);
+             }),
+             py::arg("table"), py::arg("t"),
+             "Interpolate table over Z_t on the domain 0..len(table)-1")
+        
+        .def("coefficients", [](const LookupTable& lt) {
+            return vector_to_numpy(lt.get_coefficients());
+        }, "Interpolating polynomial coefficients, lowest degree first")
+        
+        .def("evaluate", &LookupTable::evaluate,
+             "Evaluate the interpolated polynomial in the clear")
+        
+        .def("size", &LookupTable::size, "Number of table entries");
+    
+    // GaloisTool class bindings
+    py::class_<GaloisTool>(m, "GaloisTool")
+        .def(py::init<int, ModInt>(),
+             py::arg("N"), py::arg("q"),
+             "Galois automorphisms of Z_q[X]/(X^N + 1)")
+        
+        .def("apply", [](const GaloisTool& tool,
+                         py::array_t<int64_t> poly,
+                         uint64_t galois_elt) {
+            return vector_to_numpy(tool.apply(numpy_to_vector(poly), galois_elt));
+        }, py::arg("poly"), py::arg("galois_elt"),
+           "Apply X -> X^g to a polynomial in coefficient form")
+        
+        .def("rotation_elt", &GaloisTool::rotation_elt,
+             "Galois element for a left row rotation by step")
+        .def("column_swap_elt", &GaloisTool::column_swap_elt,
+             "Galois element swapping the two slot rows")
+        .def("sum_slots_elts", &GaloisTool::sum_slots_elts,
+             "Galois elements required by sum_slots");
+    
+    // GaloisKeys class bindings
+    py::class_<GaloisKeys>(m, "GaloisKeys")
+        .def(py::init([](const NTT& ntt, py::dict keys) {
+                 std::map<uint64_t, std::vector<std::vector<ModInt>>> key_map;
+                 for (auto item : keys) {
+                     uint64_t elt = item.first.cast<uint64_t>();
+                     key_map[elt] = tuple_to_ciphertext(
+                         py::tuple(item.second.cast<py::sequence>()));
+                 }
+                 return new GaloisKeys(ntt, key_map);
+             }),
+             py::arg("ntt"), py::arg("keys"),
+             "Galois keys {g: (b_0, a_0, b_1, a_1, ...)}, converted to NTT form once")
+        
+        .def("has", &GaloisKeys::has, "Check if a key exists for g")
+        .def("elements", &GaloisKeys::elements, "Galois elements with keys");
+    
+    // TableScanner class bindings
+    py::class_<TableScanner>(m, "TableScanner")
+        .def(py::init<const BFVMultiplier&, int, size_t>(),
+             py::arg("mult"), py::arg("num_threads") = 0, py::arg("block_rows") = 8,
+             py::keep_alive<1, 2>(),
+             "Encrypted row store scanned in parallel row blocks "
+             "(num_threads=0 shares the global thread pool)")
+        
+        .def("add_row", [](TableScanner& scanner, py::tuple key, py::tuple payload,
+                           int64_t bucket) {
+            return scanner.add_row(tuple_to_ciphertext(key), tuple_to_ciphertext(payload),
+                                   bucket);
+        }, py::arg("key"), py::arg("payload"), py::arg("bucket") = -1,
+           "Append a (key, payload) row of ciphertexts with an optional "
+           "index bucket tag; returns its index")
+        
+        .def("num_rows", &TableScanner::num_rows, "Number of stored rows")
+        .def("rows_in_bucket", &TableScanner::rows_in_bucket,
+             "Rows tagged with the given index bucket")
+        .def("num_threads", &TableScanner::num_threads, "Number of scan workers")
+        
+        .def("exact_match_batch", [](const TableScanner& scanner, py::list targets,
+                                     py::function sink) {
+            std::vector<std::vector<std::vector<ModInt>>> target_cts;
+            for (auto ct : targets) {
+                target_cts.push_back(tuple_to_ciphertext(ct.cast<py::tuple>()));
+            }
+            
+            py::gil_scoped_release release;
+            scanner.exact_match_batch(target_cts,
+                [&sink](size_t row, std::vector<std::vector<std::vector<ModInt>>>& diffs) {
+                    py::gil_scoped_acquire acquire;
+                    py::list out;
+                    for (const auto& ct : diffs) {
+                        out.append(ciphertext_to_tuple(ct));
+                    }
+                    sink(row, out);
+                });
+        }, py::arg("targets"), py::arg("sink"),
+           "key - target for every (query, row) in one pass, streamed as "
+           "sink(row, [diff per query]) in block completion order")
+        
+        .def("exact_match_indexed", [](const TableScanner& scanner,
+                                       py::list targets,
+                                       std::vector<int64_t> buckets) {
+            std::vector<std::vector<std::vector<ModInt>>> target_cts;
+            for (auto ct : targets) {
+                target_cts.push_back(tuple_to_ciphertext(ct.cast<py::tuple>()));
+            }
+            
+            std::vector<std::vector<std::pair<size_t, std::vector<std::vector<ModInt>>>>> diffs;
+            {
+                py::gil_scoped_release release;
+                diffs = scanner.exact_match_indexed(target_cts, buckets);
+            }
+            
+            py::list out;
+            for (const auto& query : diffs) {
+                py::list rows;
+                for (const auto& entry : query) {
+                    rows.append(py::make_tuple(entry.first, ciphertext_to_tuple(entry.second)));
+                }
+                out.append(rows);
+            }
+            return out;
+        }, py::arg("targets"), py::arg("buckets"),
+           "key - target over each query's bucket only; returns [query] -> [(row, diff)]")
+        
+        .def("sum_batch", [](const TableScanner& scanner,
+                             py::list masks,
+                             py::sequence relin_key_seq) {
+            std::vector<std::vector<std::vector<std::vector<ModInt>>>> mask_cts;
+            for (auto query : masks) {
+                std::vector<std::vector<std::vector<ModInt>>> rows;
+                for (auto ct : query.cast<py::list>()) {
+                    rows.push_back(tuple_to_ciphertext(ct.cast<py::tuple>()));
+                }
+                mask_cts.push_back(std::move(rows));
+            }
+            std::vector<std::vector<ModInt>> relin_key = sequence_to_key(relin_key_seq);
+            
+            std::vector<std::vector<std::vector<ModInt>>> sums;
+            {
+                py::gil_scoped_release release;
+                sums = scanner.sum_batch(mask_cts, relin_key);
+            }
+            
+            py::list out;
+            for (const auto& ct : sums) {
+                out.append(ciphertext_to_tuple(ct));
+            }
+            return out;
+        }, py::arg("masks"), py::arg("relin_key"),
+           "Per-query SUM of mask * payload over all rows");
+    
+    // StringMatcher class bindings
+    py::class_<StringMatcher>(m, "StringMatcher")
+        .def(py::init<const BFVMultiplier&, int, ModInt>(),
+             py::arg("mult"), py::arg("string_len"), py::arg("char_range") = 256,
+             py::keep_alive<1, 2>(),
+             "Equality/prefix tests on strings packed one character per slot")
         
-        return q;
-    }, "Find a prime suitable for NTT with given N");
+        .def("equal", [](const StringMatcher& matcher,
+                         py::tuple ct_a,
+                         py::tuple ct_b,
+                         py::sequence relin_key_seq,
+                         const GaloisKeys& galois_keys) {
+            std::vector<std::vector<ModInt>> relin_key = sequence_to_key(relin_key_seq);
+            auto result = matcher.equal(
+                tuple_to_ciphertext(ct_a), tuple_to_ciphertext(ct_b),
+                relin_key, galois_keys);
+            return ciphertext_to_tuple(result);
+        }, py::arg("ct_a"), py::arg("ct_b"), py::arg("relin_key"),
+           py::arg("galois_keys"),
+           "Slot k*stride holds 1 if string k matches, else 0")
+        
+        .def("prefix_match", [](const StringMatcher& matcher,
+                                py::tuple ct_a,
+                                py::tuple ct_b,
+                                py::array_t<int64_t> position_mask,
+                                py::sequence relin_key_seq,
+                                const GaloisKeys& galois_keys) {
+            std::vector<std::vector<ModInt>> relin_key = sequence_to_key(relin_key_seq);
+            auto result = matcher.prefix_match(
+                tuple_to_ciphertext(ct_a), tuple_to_ciphertext(ct_b),
+                numpy_to_vector(position_mask), relin_key, galois_keys);
+            return ciphertext_to_tuple(result);
+        }, py::arg("ct_a"), py::arg("ct_b"), py::arg("position_mask"),
+           py::arg("relin_key"), py::arg("galois_keys"),
+           "Like equal, comparing only positions where position_mask is 1")
+        
+        .def("prefix_mask", [](const StringMatcher& matcher,
+                               const BatchEncoder& encoder,
+                               int prefix_len) {
+            return vector_to_numpy(matcher.prefix_mask(encoder, prefix_len));
+        }, py::arg("encoder"), py::arg("prefix_len"),
+           "Slot-encoded mask selecting the first prefix_len characters of each string")
+        
+        .def("required_galois_elts", &StringMatcher::required_galois_elts,
+             "Galois elements needed by the rotate-and-multiply fold")
+        .def("get_stride", &StringMatcher::get_stride)
+        .def("strings_per_ciphertext", &StringMatcher::strings_per_ciphertext);
+    
+    // CoeffInnerProduct class bindings
+    py::class_<CoeffInnerProduct>(m, "CoeffInnerProduct")
+        .def(py::init([](const BFVMultiplier& mult, py::list vectors) {
+                 std::vector<std::vector<ModInt>> vecs;
+                 for (auto vec : vectors) {
+                     vecs.push_back(numpy_to_vector(vec.cast<py::array_t<int64_t>>()));
+                 }
+                 return new CoeffInnerProduct(mult, vecs);
+             }),
+             py::arg("mult"), py::arg("vectors"), py::keep_alive<1, 2>(),
+             "Pre-encode plaintext vectors (reversed, NTT form) for inner products")
+        
+        .def("inner_product", [](const CoeffInnerProduct& ip,
+                                 py::array_t<int64_t> c0,
+                                 py::array_t<int64_t> c1,
+                                 size_t k) {
+            auto result = ip.inner_product(numpy_to_vector(c0), numpy_to_vector(c1), k);
+            return ciphertext_to_tuple(result);
+        }, py::arg("c0"), py::arg("c1"), py::arg("k"),
+           "Inner product with stored vector k, in coefficient 0")
+        
+        .def("inner_product_batch", [](const CoeffInnerProduct& ip,
+                                       py::array_t<int64_t> c0,
+                                       py::array_t<int64_t> c1) {
+            std::vector<ModInt> c0_vec = numpy_to_vector(c0);
+            std::vector<ModInt> c1_vec = numpy_to_vector(c1);
+            std::vector<std::vector<std::vector<ModInt>>> results;
+            {
+                // Runs on the thread pool, whose async completions need the GIL
+                py::gil_scoped_release release;
+                results = ip.inner_product_batch(c0_vec, c1_vec);
+            }
+            py::list out;
+            for (const auto& ct : results) {
+                out.append(ciphertext_to_tuple(ct));
+            }
+            return out;
+        }, py::arg("c0"), py::arg("c1"),
+           "Inner products with every stored vector (one forward NTT)")
+        
+        .def("size", &CoeffInnerProduct::size, "Number of stored vectors");
+    
+    // DiagonalMatrix class bindings
+    py::class_<DiagonalMatrix>(m, "DiagonalMatrix")
+        .def(py::init([](const BFVMultiplier& mult, py::list matrix,
+                         const BatchEncoder& encoder) {
+                 std::vector<std::vector<ModInt>> rows;
+                 for (auto row : matrix) {
+                     rows.push_back(numpy_to_vector(row.cast<py::array_t<int64_t>>()));
+                 }
+                 return new DiagonalMatrix(mult, rows, encoder);
+             }),
+             py::arg("mult"), py::arg("matrix"), py::arg("encoder"), py::keep_alive<1, 2>(),
+             "Pre-encode the matrix diagonals with the batch encoder")
+        .def(py::init([](const BFVMultiplier& mult, py::list matrix,
+                         std::function<py::array_t<int64_t>(py::array_t<int64_t>)> encode_slots) {
+                 std::vector<std::vector<ModInt>> rows;
+                 for (auto row : matrix) {
+                     rows.push_back(numpy_to_vector(row.cast<py::array_t<int64_t>>()));
+                 }
+                 SlotEncoder encoder = [&encode_slots](const std::vector<ModInt>& slots) {
+                     return numpy_to_vector(encode_slots(vector_to_numpy(slots)));
+                 };
+                 return new DiagonalMatrix(mult, rows, encoder);
+             }),
+             py::arg("mult"), py::arg("matrix"), py::arg("encode_slots"), py::keep_alive<1, 2>(),
+             "Pre-encode the matrix diagonals (BSGS pre-rotated, NTT form)")
+        
+        .def("multiply", [](const DiagonalMatrix& mat,
+                            py::array_t<int64_t> c0,
+                            py::array_t<int64_t> c1,
+                            const GaloisKeys& galois_keys) {
+            auto c0_vec = numpy_to_vector(c0);
+            auto c1_vec = numpy_to_vector(c1);
+            std::vector<std::vector<ModInt>> result;
+            {
+                py::gil_scoped_release release;
+                result = mat.multiply(c0_vec, c1_vec, galois_keys);
+            }
+            return ciphertext_to_tuple(result);
+        }, py::arg("c0"), py::arg("c1"), py::arg("galois_keys"),
+           "Encrypted matrix-vector product (vector replicated with period n)")
+        
+        .def("required_galois_elts", &DiagonalMatrix::required_galois_elts,
+             "Galois elements for the baby-step and giant-step rotations")
+        .def("get_n", &DiagonalMatrix::get_n)
+        .def("get_baby_steps", &DiagonalMatrix::get_baby_steps)
+        .def("get_giant_steps", &DiagonalMatrix::get_giant_steps);
+    
+    // ExprGraph class bindings
+    py::class_<ExprGraph>(m, "ExprGraph")
+        .def(py::init<const BFVMultiplier&>(), py::arg("mult"), py::keep_alive<1, 2>(),
+             "Lazy evaluation graph; operations return node ids and run on evaluate()")
+        
+        .def("set_relin_key", [](ExprGraph& graph, py::sequence relin_key_seq) {
+            graph.set_relin_key(sequence_to_key(relin_key_seq));
+        }, py::arg("relin_key"))
+        .def("set_galois_keys", &ExprGraph::set_galois_keys, py::arg("galois_keys"),
+             py::keep_alive<1, 2>())
+        
+        .def("input", [](ExprGraph& graph, py::tuple ct) {
+            return graph.input(tuple_to_ciphertext(ct));
+        }, py::arg("ct"), "Add a ciphertext leaf")
+        .def("add", &ExprGraph::add, py::arg("a"), py::arg("b"))
+        .def("subtract", &ExprGraph::subtract, py::arg("a"), py::arg("b"))
+        .def("multiply_scalar", &ExprGraph::multiply_scalar, py::arg("a"), py::arg("scalar"))
+        .def("add_scalar", &ExprGraph::add_scalar, py::arg("a"), py::arg("scalar"))
+        .def("multiply", &ExprGraph::multiply, py::arg("a"), py::arg("b"))
+        .def("relinearize", &ExprGraph::relinearize, py::arg("a"))
+        .def("multiply_plain", [](ExprGraph& graph, size_t a, py::array_t<int64_t> plain) {
+            return graph.multiply_plain(a, numpy_to_vector(plain));
+        }, py::arg("a"), py::arg("plain"))
+        .def("rotate", &ExprGraph::rotate, py::arg("a"), py::arg("galois_elt"))
+        
+        .def("evaluate", [](ExprGraph& graph, const std::vector<size_t>& ids) {
+            std::vector<std::vector<std::vector<ModInt>>> results;
+            {
+                py::gil_scoped_release release;
+                results = graph.evaluate(ids);
+            }
+            py::list out;
+            for (const auto& ct : results) {
+                out.append(ciphertext_to_tuple(ct));
+            }
+            return out;
+        }, py::arg("ids"), "Plan and compute the given nodes; returns coefficient-form tuples")
+        
+        .def("size_of", &ExprGraph::size_of, py::arg("id"))
+        .def("num_nodes", &ExprGraph::num_nodes)
+        .def("stats", [](const ExprGraph& graph) {
+            const ExprStats& s = graph.stats();
+            py::dict stats;
+            stats["nodes"] = s.nodes;
+            stats["steps"] = s.steps;
+            stats["fused_nodes"] = s.fused_nodes;
+            stats["levels"] = s.levels;
+            stats["forward_ntts"] = s.forward_ntts;
+            stats["inverse_ntts"] = s.inverse_ntts;
+            stats["relinearizations"] = s.relinearizations;
+            stats["relinearizations_saved"] = s.relinearizations_saved;
+            return stats;
+        }, "Plan statistics of the last evaluate()");
+    
+    // BatchEncoder class bindings
+    py::class_<BatchEncoder>(m, "BatchEncoder")
+        .def(py::init<int, ModInt>(),
+             py::arg("N"), py::arg("t"),
+             "Slot encoder over the prime t (requires t = 1 mod 2N)")
+        .def_static("supports", &BatchEncoder::supports,
+                    py::arg("N"), py::arg("t"),
+                    "Whether t admits batching for degree N")
+        
+        .def("encode", [](const BatchEncoder& enc, py::array_t<int64_t> values) {
+            return vector_to_numpy(enc.encode(numpy_to_vector(values)));
+        }, py::arg("values"), "Slot values (row 0 first) -> plaintext polynomial")
+        
+        .def("decode", [](const BatchEncoder& enc, py::array_t<int64_t> poly) {
+            return vector_to_numpy(enc.decode(numpy_to_vector(poly)));
+        }, py::arg("poly"), "Plaintext polynomial -> N slot values in [0, t)")
+        
+        .def("encode_batch", [](const BatchEncoder& enc, py::list values) {
+            std::vector<std::vector<ModInt>> vecs;
+            for (auto v : values) {
+                vecs.push_back(numpy_to_vector(v.cast<py::array_t<int64_t>>()));
+            }
+            std::vector<std::vector<ModInt>> polys;
+            {
+                py::gil_scoped_release release;
+                polys = enc.encode_batch(vecs);
+            }
+            py::list out;
+            for (const auto& p : polys) {
+                out.append(vector_to_numpy(p));
+            }
+            return out;
+        }, py::arg("values"), "Encode many slot vectors in one call")
+        
+        .def("decode_batch", [](const BatchEncoder& enc, py::list polys) {
+            std::vector<std::vector<ModInt>> vecs;
+            for (auto p : polys) {
+                vecs.push_back(numpy_to_vector(p.cast<py::array_t<int64_t>>()));
+            }
+            std::vector<std::vector<ModInt>> values;
+            {
+                py::gil_scoped_release release;
+                values = enc.decode_batch(vecs);
+            }
+            py::list out;
+            for (const auto& v : values) {
+                out.append(vector_to_numpy(v));
+            }
+            return out;
+        }, py::arg("polys"), "Decode many plaintext polynomials in one call")
+        
+        .def("slot_count", &BatchEncoder::slot_count)
+        .def("row_size", &BatchEncoder::row_size)
+        .def("get_t", &BatchEncoder::get_t);
+    
+    // Decryptor class bindings
+    py::class_<Decryptor>(m, "Decryptor")
+        .def(py::init([](const NTT& ntt, ModInt t, py::array_t<int64_t> secret_key) {
+                 return new Decryptor(ntt, t, numpy_to_vector(secret_key));
+             }),
+             py::arg("ntt"), py::arg("t"), py::arg("secret_key"), py::keep_alive<1, 2>(),
+             "Decryptor holding the secret key in NTT form")
+        
+        .def("decrypt", [](const Decryptor& dec, py::tuple ct) {
+            auto ct_vec = tuple_to_ciphertext(ct);
+            std::vector<ModInt> m;
+            {
+                py::gil_scoped_release release;
+                m = dec.decrypt(ct_vec);
+            }
+            return vector_to_numpy(m);
+        }, py::arg("ct"), "Exact round(t * (c0 + c1*s) / q) mod t")
+        
+        .def("decrypt_batch", [](const Decryptor& dec, py::list cts) {
+            std::vector<std::vector<std::vector<ModInt>>> ct_vecs;
+            for (auto ct : cts) {
+                ct_vecs.push_back(tuple_to_ciphertext(ct.cast<py::tuple>()));
+            }
+            std::vector<std::vector<ModInt>> results;
+            {
+                py::gil_scoped_release release;
+                results = dec.decrypt_batch(ct_vecs);
+            }
+            py::list out;
+            for (const auto& m : results) {
+                out.append(vector_to_numpy(m));
+            }
+            return out;
+        }, py::arg("cts"), "Decrypt many ciphertexts in one call")
+        
+        .def("decrypt_async", [](py::object self, py::tuple ct) {
+            const Decryptor* dec = &self.cast<const Decryptor&>();
+            return submit_async<std::vector<ModInt>>(self,
+                [dec, ct_vec = tuple_to_ciphertext(ct)] { return dec->decrypt(ct_vec); },
+                [](const std::vector<ModInt>& m) -> py::object { return vector_to_numpy(m); });
+        }, py::arg("ct"), "Awaitable decrypt, computed on the native thread pool")
+        
+        .def("phase", [](const Decryptor& dec, py::tuple ct) {
+            return vector_to_numpy(dec.phase(tuple_to_ciphertext(ct)));
+        }, py::arg("ct"), "c0 + c1*s mod q, before scaling")
+        
+        .def("invariant_noise_budget", [](const Decryptor& dec, py::tuple ct) {
+            return dec.invariant_noise_budget(tuple_to_ciphertext(ct));
+        }, py::arg("ct"), "Exact bits of noise budget left (0 when exhausted)");
+    
+    // KeyGenerator class bindings
+    py::class_<KeyGenerator>(m, "KeyGenerator")
+        .def(py::init<const NTT&, double, uint64_t>(),
+             py::arg("ntt"), py::arg("sigma") = 3.2, py::arg("seed") = 0,
+             py::keep_alive<1, 2>(),
+             "Native key generation (seed=0 seeds from the OS)")
+        .def(py::init([](const NTT& ntt, py::array_t<int64_t> secret_key,
+                         double sigma, uint64_t seed) {
+                 return new KeyGenerator(ntt, numpy_to_vector(secret_key), sigma, seed);
+             }),
+             py::arg("ntt"), py::arg("secret_key"), py::arg("sigma") = 3.2,
+             py::arg("seed") = 0, py::keep_alive<1, 2>(),
+             "Key generation for an existing secret key (coefficient form)")
+        .def("secret_key", [](const KeyGenerator& kg) {
+            return vector_to_numpy(kg.secret_key());
+        })
+        .def("public_key", [](KeyGenerator& kg) {
+            return ciphertext_to_tuple(kg.public_key());
+        }, "(b, a) with b = -(a*s + e)")
+        .def("relin_key", [](KeyGenerator& kg, int decomp_bits) {
+            py::list out;
+            for (const auto& comp : kg.relin_key(decomp_bits)) {
+                out.append(vector_to_numpy(comp));
+            }
+            return out;
+        }, py::arg("decomp_bits") = DEFAULT_DECOMP_BITS,
+           "[b_0, a_0, b_1, a_1, ...] with b_j = -(a_j*s + e_j) + w^j * s^2")
+        .def("galois_keys", [](KeyGenerator& kg, const std::vector<uint64_t>& elts,
+                               int decomp_bits) {
+            py::dict out;
+            for (const auto& entry : kg.galois_keys(elts, decomp_bits)) {
+                out[py::int_(entry.first)] = ciphertext_to_tuple(entry.second);
+            }
+            return out;
+        }, py::arg("galois_elts"), py::arg("decomp_bits") = DEFAULT_DECOMP_BITS,
+           "{g: (b_0, a_0, b_1, a_1, ...)} for GaloisKeys");
+    
+    // Encryptor class bindings
+    py::class_<Encryptor>(m, "Encryptor")
+        .def(py::init([](const NTT& ntt, ModInt t, py::tuple public_key,
+                         double sigma, uint64_t seed) {
+                 return new Encryptor(ntt, t, tuple_to_ciphertext(public_key), sigma, seed);
+             }),
+             py::arg("ntt"), py::arg("t"), py::arg("public_key"),
+             py::arg("sigma") = 3.2, py::arg("seed") = 0, py::keep_alive<1, 2>(),
+             "Native public-key encryption (one instance per thread)")
+        .def("encrypt", [](Encryptor& enc, py::array_t<int64_t> plain) {
+            auto vec = numpy_to_vector(plain);
+            std::vector<std::vector<ModInt>> ct;
+            {
+                py::gil_scoped_release release;
+                ct = enc.encrypt(vec);
+            }
+            return ciphertext_to_tuple(ct);
+        }, py::arg("plain"), "Encrypt a plaintext polynomial with coefficients in [0, t)")
+        .def("encrypt_batch", [](Encryptor& enc, py::list plains) {
+            std::vector<std::vector<ModInt>> vecs;
+            for (auto p : plains) {
+                vecs.push_back(numpy_to_vector(p.cast<py::array_t<int64_t>>()));
+            }
+            std::vector<std::vector<std::vector<ModInt>>> cts;
+            {
+                py::gil_scoped_release release;
+                cts = enc.encrypt_batch(vecs);
+            }
+            py::list out;
+            for (const auto& ct : cts) {
+                out.append(ciphertext_to_tuple(ct));
+            }
+            return out;
+        }, py::arg("plains"));
+    
+    // NoiseModel class bindings
+    py::class_<NoiseModel>(m, "NoiseModel")
+        .def(py::init<int, ModInt, ModInt, double, int>(),
+             py::arg("N"), py::arg("q"), py::arg("t"),
+             py::arg("sigma") = 3.2, py::arg("decomp_bits") = 0,
+             "Heuristic invariant-noise bounds (decomp_bits=0: no decomposition)")
+        .def("fresh", &NoiseModel::fresh)
+        .def("add", &NoiseModel::add, py::arg("v1"), py::arg("v2"))
+        .def("add_plain", &NoiseModel::add_plain, py::arg("v"))
+        .def("multiply_plain", &NoiseModel::multiply_plain,
+             py::arg("v"), py::arg("plain_norm") = -1.0)
+        .def("multiply_scalar", &NoiseModel::multiply_scalar,
+             py::arg("v"), py::arg("scalar_norm"))
+        .def("multiply", &NoiseModel::multiply, py::arg("v1"), py::arg("v2"))
+        .def("relinearize", &NoiseModel::relinearize, py::arg("v"))
+        .def("rotate", &NoiseModel::rotate, py::arg("v"))
+        .def("budget", &NoiseModel::budget, py::arg("v"),
+             "Bits of budget left for invariant noise v")
+        .def("mod_switch", &NoiseModel::mod_switch, py::arg("v"), py::arg("q_to"),
+             "Noise after switching to modulus q_to")
+        .def("min_modulus_bits", &NoiseModel::min_modulus_bits,
+             py::arg("v"), py::arg("min_budget") = 1.0,
+             "Smallest log2(q_to) keeping min_budget bits after switching")
+        .def_static("from_log_q", &NoiseModel::from_log_q,
+                    py::arg("N"), py::arg("log_q"), py::arg("t"),
+                    py::arg("sigma") = 3.2, py::arg("decomp_bits") = 0,
+                    "Model for a modulus given by its size (q mod t taken as t - 1)");
+    
+    // Parameter planning bindings
+    py::class_<ParameterPlan>(m, "ParameterPlan")
+        .def_readonly("N", &ParameterPlan::N)
+        .def_readonly("t", &ParameterPlan::t)
+        .def_readonly("security", &ParameterPlan::security)
+        .def_readonly("modulus_bits", &ParameterPlan::modulus_bits)
+        .def_readonly("moduli", &ParameterPlan::moduli)
+        .def_readonly("decomp_bits", &ParameterPlan::decomp_bits)
+        .def_readonly("budget_left", &ParameterPlan::budget_left)
+        .def_readonly("ntt_us", &ParameterPlan::ntt_us)
+        .def_readonly("add_us", &ParameterPlan::add_us)
+        .def_readonly("multiply_us", &ParameterPlan::multiply_us)
+        .def_readonly("relinearize_us", &ParameterPlan::relinearize_us)
+        .def_readonly("rotate_us", &ParameterPlan::rotate_us)
+        .def_readonly("circuit_us", &ParameterPlan::circuit_us)
+        .def("__repr__", [](const ParameterPlan& p) {
+            return "ParameterPlan(N=" + std::to_string(p.N) +
+                   ", log2(q)=" + std::to_string(p.modulus_bits) +
+                   ", moduli=" + std::to_string(p.moduli.size()) +
+                   ", decomp_bits=" + std::to_string(p.decomp_bits) + ")";
+        });
+    
+    py::class_<ParameterPlanner>(m, "ParameterPlanner")
+        .def(py::init<double, double, double>(),
+             py::arg("sigma") = 3.2, py::arg("butterfly_ns") = 3.0, py::arg("mulmod_ns") = 2.0,
+             "Planner with error width and per-operation cost constants")
+        .def("plan", &ParameterPlanner::plan,
+             py::arg("depth"), py::arg("t"), py::arg("rotations") = 0,
+             py::arg("security") = 128, py::arg("batching") = true,
+             py::arg("min_budget") = 1.0,
+             "Cheapest (N, moduli, decomposition base) for the circuit")
+        .def_static("max_modulus_bits", &ParameterPlanner::max_modulus_bits,
+                    py::arg("N"), py::arg("security") = 128,
+                    "Largest log2(q) for N at the security level");
+    
+    // Modulus switching and compact serialization
+    m.def("mod_switch", [](py::tuple ct, ModInt q_from, ModInt q_to) {
+        auto ct_vec = tuple_to_ciphertext(ct);
+        return ciphertext_to_tuple(mod_switch(ct_vec, q_from, q_to));
+    }, py::arg("ct"), py::arg("q_from"), py::arg("q_to"),
+       "round(q_to / q_from * c) mod q_to for every component");
+    
+    m.def("pack_ciphertext", [](py::tuple ct, ModInt q) {
+        auto data = pack_ciphertext(tuple_to_ciphertext(ct), q);
+        return py::bytes(reinterpret_cast<const char*>(data.data()), data.size());
+    }, py::arg("ct"), py::arg("q"), "Pack components at ceil(log2 q) bits per coefficient");
+    
+    m.def("unpack_ciphertext", [](py::bytes data, int N, int num_components, ModInt q) {
+        std::string raw = data;
+        std::vector<uint8_t> bytes(raw.begin(), raw.end());
+        return ciphertext_to_tuple(unpack_ciphertext(bytes, N, num_components, q));
+    }, py::arg("data"), py::arg("N"), py::arg("num_components"), py::arg("q"),
+       "Inverse of pack_ciphertext");
+    
+    m.def("encode_coeff_vector", [](py::array_t<int64_t> values, int N, ModInt t) {
+        return vector_to_numpy(encode_coeff_vector(numpy_to_vector(values), N, t));
+    }, py::arg("values"), py::arg("N"), py::arg("t"),
+       "Coefficient encoding a(X) = sum v_i X^i");
+    
+    m.def("encode_coeff_reversed", [](py::array_t<int64_t> values, int N, ModInt t) {
+        return vector_to_numpy(encode_coeff_reversed(numpy_to_vector(values), N, t));
+    }, py::arg("values"), py::arg("N"), py::arg("t"),
+       "Reversed negacyclic encoding for inner products in coefficient 0");
+    
+    // Instrumentation
+    m.def("set_instrumentation", &Instrumentation::set_enabled, py::arg("enabled"),
+          "Switch operation counters and latency histograms on or off");
+    m.def("instrumentation_enabled", &Instrumentation::enabled);
+    m.def("instrumentation_compiled_in", &Instrumentation::compiled_in,
+          "Whether the module was built with FHE_INSTRUMENTATION");
+    m.def("reset_instrumentation", &Instrumentation::reset);
+    
+    m.def("instrumentation_snapshot", []() {
+        InstrumentationSnapshot snap = Instrumentation::snapshot();
+        py::dict counters;
+        for (const auto& entry : snap.counters) {
+            counters[py::str(entry.first)] = entry.second;
+        }
+        py::dict ops;
+        for (const auto& entry : snap.ops) {
+            const LatencyStats& s = entry.second;
+            py::dict stats;
+            stats["count"] = s.count;
+            stats["total_ns"] = s.total_ns;
+            stats["min_ns"] = s.min_ns;
+            stats["max_ns"] = s.max_ns;
+            stats["mean_ns"] = s.mean_ns;
+            stats["p50_ns"] = s.p50_ns;
+            stats["p90_ns"] = s.p90_ns;
+            stats["p99_ns"] = s.p99_ns;
+            stats["p999_ns"] = s.p999_ns;
+            ops[py::str(entry.first)] = stats;
+        }
+        py::dict result;
+        result["counters"] = counters;
+        result["ops"] = ops;
+        return result;
+    }, "Counters and per-operation latency percentiles recorded so far");
+    
+    // Chrome trace / Perfetto spans
+    m.def("start_tracing", &Tracer::start, py::arg("max_events_per_thread") = 1 << 16,
+          "Start recording trace spans into per-thread buffers");
+    m.def("stop_tracing", &Tracer::stop);
+    m.def("tracing_enabled", &Tracer::enabled);
+    m.def("clear_trace", &Tracer::clear, "Discard recorded spans (call while idle)");
+    m.def("trace_now_ns", &Tracer::now_ns, "Timestamp on the trace clock");
+    m.def("trace_record", [](const std::string& name, const std::string& category,
+                             uint64_t start_ns, uint64_t end_ns) {
+        if (Tracer::enabled()) {
+            Tracer::record(Tracer::intern(name), Tracer::intern(category), start_ns, end_ns);
+        }
+    }, py::arg("name"), py::arg("category"), py::arg("start_ns"), py::arg("end_ns"),
+       "Record a span measured with trace_now_ns() (e.g. from Python code)");
+    m.def("chrome_trace_json", &Tracer::chrome_trace_json);
+    m.def("write_chrome_trace", &Tracer::write_chrome_trace, py::arg("path"),
+          "Write recorded spans as Chrome trace JSON (open in Perfetto)");
+    m.def("trace_stats", []() {
+        py::dict stats;
+        stats["recorded"] = Tracer::recorded();
+        stats["dropped"] = Tracer::dropped();
+        return stats;
+    });
+    
+    // Hardware performance counters
+    m.def("perf_counters_supported", &PerfCounters::supported);
+    m.def("set_perf_counters", &PerfCounters::set_enabled, py::arg("enabled"),
+          "Profile NTT, pointwise and key-switching kernels with perf_event_open; "
+          "returns False when no counter could be opened");
+    m.def("perf_counters_enabled", &PerfCounters::enabled);
+    m.def("reset_perf_counters", &PerfCounters::reset);
+    m.def("perf_counter_snapshot", []() {
+        py::dict result;
+        for (const auto& entry : PerfCounters::snapshot()) {
+            const PerfKernelStats& s = entry.second;
+            py::dict stats;
+            stats["calls"] = s.calls;
+            stats["coefficients"] = s.coefficients;
+            stats["events"] = s.events;
+            stats["ipc"] = s.ipc;
+            stats["per_coefficient"] = s.per_coefficient;
+            result[py::str(entry.first)] = stats;
+        }
+        return result;
+    }, "Per-kernel counter totals, IPC and events per coefficient");
+    
+    // Process-wide thread pool
+    m.def("configure_thread_pool", [](int num_threads, bool pin_threads) {
+        py::gil_scoped_release release;
+        ThreadPool::configure_global(num_threads, pin_threads);
+    }, py::arg("num_threads") = 0, py::arg("pin_threads") = true,
+       "Replace the global pool every parallel native path runs on "
+       "(num_threads=0 uses every allowed CPU)");
+    m.def("thread_pool_size", []() { return ThreadPool::global()->size(); });
+    m.def("thread_pool_stats", []() {
+        ThreadPoolStats s = ThreadPool::global()->stats();
+        py::dict stats;
+        stats["workers"] = s.workers;
+        stats["numa_nodes"] = s.numa_nodes;
+        stats["parallel_for_calls"] = s.parallel_for_calls;
+        stats["inline_calls"] = s.inline_calls;
+        stats["tasks_executed"] = s.tasks_executed;
+        stats["tasks_stolen"] = s.tasks_stolen;
+        stats["remote_steals"] = s.remote_steals;
+        return stats;
+    });
+    m.def("reset_thread_pool_stats", []() { ThreadPool::global()->reset_stats(); });
+    
+    // NTT kernel autotuning
+    m.def("tune_ntt", [](const std::vector<int>& ring_sizes, const std::vector<int>& modulus_bits,
+                         int reps, bool save) {
+        std::vector<NttTuningEntry> entries;
+        {
+            py::gil_scoped_release release;
+            entries = NttTuner::tune(ring_sizes, modulus_bits, reps, save);
+        }
+        py::list out;
+        for (const auto& e : entries) {
+            py::dict d;
+            d["cpu"] = e.cpu;
+            d["N"] = e.N;
+            d["modulus_bits"] = e.modulus_bits;
+            d["variant"] = ntt_variant_name(e.variant);
+            d["forward_ns"] = e.forward_ns;
+            d["inverse_ns"] = e.inverse_ns;
+            d["parallel_batch"] = e.parallel_batch;
+            out.append(d);
+        }
+        return out;
+    }, py::arg("ring_sizes"), py::arg("modulus_bits"), py::arg("reps") = 20,
+       py::arg("save") = true,
+       "Benchmark the NTT variants and the batch threading threshold, and "
+       "record them in the tuning profile");
+    m.def("ntt_tuning_profile", &NttTuner::profile_path);
+    m.def("set_ntt_tuning_profile", &NttTuner::set_profile_path, py::arg("path"));
+    m.def("set_ntt_autotune", &NttTuner::set_auto_tune, py::arg("enabled"),
+          "Tune missing (N, modulus size) pairs when an NTT is first constructed");
+    
+    // Utility functions
+    m.def("find_ntt_prime", &find_ntt_prime,
+          py::arg("N"), py::arg("bits") = 0,
+          "Find a prime q = 1 (mod 2N): the smallest, or the largest below 2^bits");
+    
+    m.def("find_ntt_primes", &find_ntt_primes,
+          py::arg("N"), py::arg("bits"), py::arg("count"),
+          "Distinct NTT-friendly primes below 2^bits, largest first");
+    
+    m.def("is_prime", &is_prime, py::arg("n"), "Deterministic 64-bit primality test");
 }
@@ -27,11 +27,12 @@ class Plaintext:
 class Ciphertext:
     """Ciphertext representation (c0, c1) or (c0, c1, c2) for fresh/multiplied"""
     
-    def __init__(self, components, params=None):
+    def __init__(self, components, params=None, noise=None):
         """
         Args:
             components: List of polynomial components [c0, c1] or [c0, c1, c2]
             params: Optional parameters (N, t, q)
+            noise: Optional estimated invariant noise bound (None if untracked)
         """
         if not isinstance(components, list):
             raise ValueError("Components must be a list of polynomials")
@@ -39,6 +40,7 @@ class Ciphertext:
         self.components = components
         self.params = params
         self.size = len(components)
+        self.noise = noise
     
     def get_components(self):
         return self.components
@@ -53,7 +55,7 @@ class Ciphertext:
     def copy(self):
         """Create a deep copy of the ciphertext"""
         new_components = [c.copy() for c in self.components]
-        return Ciphertext(new_components, self.params)
+        return Ciphertext(new_components, self.params, self.noise)
     
     def __add__(self, other):
         """Addition placeholder - actual implementation in BFVScheme"""
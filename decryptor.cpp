@@ -0,0 +1,98 @@
+/*
+ * Decryptor Implementation
+ */
+
+#include "decryptor.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "thread_pool.h"
+#include <cmath>
+
+namespace fhe_cpp {
+
+Decryptor::Decryptor(const NTT& ntt, ModInt t, const std::vector<ModInt>& secret_key)
+    : ntt(ntt), q(ntt.get_q()), t(t) {
+    
+    if (secret_key.size() != (size_t)ntt.get_N()) {
+        throw std::invalid_argument("Secret key size must equal N");
+    }
+    if (t < 2 || t >= q) {
+        throw std::invalid_argument("Plaintext modulus must satisfy 2 <= t < q");
+    }
+    
+    std::vector<ModInt> s(secret_key);
+    for (auto& v : s) {
+        v %= q;
+        if (v < 0) v += q;
+    }
+    ntt.forward(s);
+    
+    sk_powers_ntt.push_back(s);
+    sk_powers_ntt.push_back(ntt.pointwise_multiply(s, s));
+}
+
+ModInt Decryptor::scale_round(ModInt x) const {
+    // floor((2*t*x + q) / (2*q)) = round(t*x / q), exactly in 128 bits
+    __int128 num = 2 * (__int128)t * x + q;
+    ModInt r = (ModInt)(num / (2 * (__int128)q));
+    return r % t;
+}
+
+std::vector<ModInt> Decryptor::phase(const std::vector<std::vector<ModInt>>& ct) const {
+    int N = ntt.get_N();
+    if (ct.size() < 2 || ct.size() > sk_powers_ntt.size() + 1) {
+        throw std::invalid_argument("Can only decrypt size-2 or size-3 ciphertexts");
+    }
+    for (const auto& comp : ct) {
+        if (comp.size() != (size_t)N) {
+            throw std::invalid_argument("All ciphertext components must have size N");
+        }
+    }
+    
+    // Sum c_i * s^i in NTT form, one inverse NTT at the end
+    std::vector<ModInt> acc(N, 0);
+    for (size_t i = 1; i < ct.size(); i++) {
+        std::vector<ModInt> c(ct[i]);
+        ntt.forward(c);
+        acc = ntt.add(acc, ntt.pointwise_multiply(c, sk_powers_ntt[i - 1]));
+    }
+    ntt.inverse(acc);
+    return ntt.add(acc, ct[0]);
+}
+
+std::vector<ModInt> Decryptor::decrypt(const std::vector<std::vector<ModInt>>& ct) const {
+    FHE_TIME_OP(Decrypt);
+    FHE_TRACE_SPAN("decrypt", "decrypt");
+    std::vector<ModInt> m = phase(ct);
+    for (auto& v : m) {
+        v = scale_round(v);
+    }
+    return m;
+}
+
+std::vector<std::vector<ModInt>> Decryptor::decrypt_batch(
+    const std::vector<std::vector<std::vector<ModInt>>>& cts) const {
+    
+    std::vector<std::vector<ModInt>> results(cts.size());
+    ThreadPool::global()->parallel_for(cts.size(), [&](size_t i) {
+        results[i] = decrypt(cts[i]);
+    });
+    return results;
+}
+
+int Decryptor::invariant_noise_budget(const std::vector<std::vector<ModInt>>& ct) const {
+    std::vector<ModInt> p = phase(ct);
+    
+    // t * (Delta*m + e) mod q = t*e - (q mod t)*m: the scaled noise
+    ModInt max_noise = 0;
+    for (ModInt x : p) {
+        ModInt v = (ModInt)(((__int128)t * x) % q);
+        if (v > q / 2) v = q - v;
+        max_noise = std::max(max_noise, v);
+    }
+    
+    double bits = std::log2((double)q) - std::log2((double)std::max<ModInt>(max_noise, 1)) - 1;
+    return bits > 0 ? (int)std::floor(bits) : 0;
+}
+
+} // namespace fhe_cpp
@@ -0,0 +1,50 @@
+/*
+ * Native BFV decryption
+ * The secret key is kept in NTT form and the scaling by t/q is done with
+ * exact integer rounding, so 60-bit moduli lose no precision
+ */
+
+#ifndef FHE_DECRYPTOR_H
+#define FHE_DECRYPTOR_H
+
+#include "ntt.h"
+#include <vector>
+
+namespace fhe_cpp {
+
+class Decryptor {
+private:
+    const NTT& ntt;
+    ModInt q;           // Ciphertext modulus
+    ModInt t;           // Plaintext modulus
+    
+    // s and s^2 in NTT form (size-2 and size-3 ciphertexts)
+    std::vector<std::vector<ModInt>> sk_powers_ntt;
+    
+    // round(t * x / q) mod t for x in [0, q)
+    ModInt scale_round(ModInt x) const;
+
+public:
+    // secret_key in coefficient form, any representative mod q
+    Decryptor(const NTT& ntt, ModInt t, const std::vector<ModInt>& secret_key);
+    ~Decryptor() = default;
+    
+    // c0 + c1*s (+ c2*s^2) mod q, in coefficient form
+    std::vector<ModInt> phase(const std::vector<std::vector<ModInt>>& ct) const;
+    
+    // Plaintext polynomial with coefficients in [0, t); accepts size-2 and
+    // size-3 ciphertexts
+    std::vector<ModInt> decrypt(const std::vector<std::vector<ModInt>>& ct) const;
+    
+    std::vector<std::vector<ModInt>> decrypt_batch(
+        const std::vector<std::vector<std::vector<ModInt>>>& cts) const;
+    
+    // Bits of noise budget left: log2(q) - log2(||t*(c0 + c1*s) mod q||) - 1,
+    // where the norm is the largest centered coefficient; 0 once decryption
+    // is no longer guaranteed
+    int invariant_noise_budget(const std::vector<std::vector<ModInt>>& ct) const;
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_DECRYPTOR_H
@@ -0,0 +1,167 @@
+/*
+ * Key Generation and Encryption Implementation
+ */
+
+#include "encryptor.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace fhe_cpp {
+
+PolySampler::PolySampler(int N, ModInt q, double sigma, uint64_t seed)
+    : N(N), q(q), sigma(sigma), rng(seed != 0 ? seed : std::random_device{}()) {}
+
+std::vector<ModInt> PolySampler::uniform() {
+    std::uniform_int_distribution<ModInt> dist(0, q - 1);
+    std::vector<ModInt> poly(N);
+    for (auto& c : poly) c = dist(rng);
+    return poly;
+}
+
+std::vector<ModInt> PolySampler::ternary() {
+    std::uniform_int_distribution<int> dist(-1, 1);
+    std::vector<ModInt> poly(N);
+    for (auto& c : poly) {
+        int v = dist(rng);
+        c = v < 0 ? q - 1 : v;
+    }
+    return poly;
+}
+
+std::vector<ModInt> PolySampler::gaussian() {
+    std::normal_distribution<double> dist(0.0, sigma);
+    ModInt bound = (ModInt)(6 * sigma);
+    std::vector<ModInt> poly(N);
+    for (auto& c : poly) {
+        ModInt v = (ModInt)std::llround(dist(rng));
+        v = std::max(-bound, std::min(bound, v));
+        c = v < 0 ? v + q : v;
+    }
+    return poly;
+}
+
+KeyGenerator::KeyGenerator(const NTT& ntt, double sigma, uint64_t seed)
+    : ntt(ntt), galois(ntt.get_N(), ntt.get_q()),
+      sampler(ntt.get_N(), ntt.get_q(), sigma, seed) {
+    sk = sampler.ternary();
+    sk_ntt = sk;
+    ntt.forward(sk_ntt);
+}
+
+KeyGenerator::KeyGenerator(const NTT& ntt, const std::vector<ModInt>& secret_key,
+                           double sigma, uint64_t seed)
+    : ntt(ntt), galois(ntt.get_N(), ntt.get_q()),
+      sampler(ntt.get_N(), ntt.get_q(), sigma, seed) {
+    if ((int)secret_key.size() != ntt.get_N()) {
+        throw std::invalid_argument("Secret key size must equal N");
+    }
+    ModInt q = ntt.get_q();
+    sk.resize(secret_key.size());
+    for (size_t i = 0; i < sk.size(); i++) {
+        sk[i] = ((secret_key[i] % q) + q) % q;
+    }
+    sk_ntt = sk;
+    ntt.forward(sk_ntt);
+}
+
+std::vector<std::vector<ModInt>> KeyGenerator::encrypt_zero_plus(const std::vector<ModInt>& m) {
+    std::vector<ModInt> a = sampler.uniform();
+    std::vector<ModInt> a_ntt = a;
+    ntt.forward(a_ntt);
+    std::vector<ModInt> as = ntt.pointwise_multiply(a_ntt, sk_ntt);
+    ntt.inverse(as);
+    
+    std::vector<ModInt> b = ntt.subtract(m, ntt.add(as, sampler.gaussian()));
+    return {b, a};
+}
+
+std::vector<std::vector<ModInt>> KeyGenerator::public_key() {
+    return encrypt_zero_plus(std::vector<ModInt>(ntt.get_N(), 0));
+}
+
+std::vector<std::vector<ModInt>> KeyGenerator::relin_key(int decomp_bits) {
+    std::vector<ModInt> s2 = ntt.pointwise_multiply(sk_ntt, sk_ntt);
+    ntt.inverse(s2);
+    
+    GadgetDecomposition gadget(ntt.get_N(), ntt.get_q(), decomp_bits);
+    std::vector<std::vector<ModInt>> key;
+    for (int j = 0; j < gadget.num_digits(); j++) {
+        for (auto& comp : encrypt_zero_plus(ntt.scalar_mul(s2, gadget.power(j)))) {
+            key.push_back(std::move(comp));
+        }
+    }
+    return key;
+}
+
+std::map<uint64_t, std::vector<std::vector<ModInt>>> KeyGenerator::galois_keys(
+    const std::vector<uint64_t>& galois_elts, int decomp_bits) {
+    GadgetDecomposition gadget(ntt.get_N(), ntt.get_q(), decomp_bits);
+    std::map<uint64_t, std::vector<std::vector<ModInt>>> keys;
+    for (uint64_t g : galois_elts) {
+        std::vector<ModInt> s_g = galois.apply(sk, g);
+        auto& key = keys[g];
+        for (int j = 0; j < gadget.num_digits(); j++) {
+            for (auto& comp : encrypt_zero_plus(ntt.scalar_mul(s_g, gadget.power(j)))) {
+                key.push_back(std::move(comp));
+            }
+        }
+    }
+    return keys;
+}
+
+Encryptor::Encryptor(const NTT& ntt, ModInt t,
+                     const std::vector<std::vector<ModInt>>& public_key,
+                     double sigma, uint64_t seed)
+    : ntt(ntt), t(t), delta(ntt.get_q() / t),
+      sampler(ntt.get_N(), ntt.get_q(), sigma, seed) {
+    if (public_key.size() != 2) {
+        throw std::invalid_argument("Public key must have two components");
+    }
+    for (const auto& comp : public_key) {
+        if ((int)comp.size() != ntt.get_N()) {
+            throw std::invalid_argument("Public key components must have size N");
+        }
+        pk_ntt.push_back(comp);
+        ntt.forward(pk_ntt.back());
+    }
+}
+
+std::vector<std::vector<ModInt>> Encryptor::encrypt(const std::vector<ModInt>& plain) {
+    FHE_TRACE_SPAN("encrypt", "encrypt");
+    int N = ntt.get_N();
+    ModInt q = ntt.get_q();
+    if ((int)plain.size() != N) {
+        throw std::invalid_argument("Plaintext must have N coefficients");
+    }
+    
+    std::vector<ModInt> u = sampler.ternary();
+    ntt.forward(u);
+    std::vector<ModInt> c0 = ntt.pointwise_multiply(pk_ntt[0], u);
+    std::vector<ModInt> c1 = ntt.pointwise_multiply(pk_ntt[1], u);
+    ntt.inverse(c0);
+    ntt.inverse(c1);
+    
+    std::vector<ModInt> e1 = sampler.gaussian();
+    std::vector<ModInt> e2 = sampler.gaussian();
+    for (int i = 0; i < N; i++) {
+        ModInt m = plain[i] % t;
+        if (m < 0) m += t;
+        ModInt scaled = (ModInt)(((__int128)delta * m) % q);
+        c0[i] = (ModInt)(((__int128)c0[i] + e1[i] + scaled) % q);
+        c1[i] = (c1[i] + e2[i]) % q;
+    }
+    return {c0, c1};
+}
+
+std::vector<std::vector<std::vector<ModInt>>> Encryptor::encrypt_batch(
+    const std::vector<std::vector<ModInt>>& plains) {
+    std::vector<std::vector<std::vector<ModInt>>> cts;
+    cts.reserve(plains.size());
+    for (const auto& p : plains) {
+        cts.push_back(encrypt(p));
+    }
+    return cts;
+}
+
+} // namespace fhe_cpp
@@ -0,0 +1,94 @@
+/*
+ * Native BFV key generation and public-key encryption
+ * Same distributions as the Python scheme: ternary secret and encryption
+ * randomness, rounded Gaussian errors bounded by 6 sigma
+ */
+
+#ifndef FHE_ENCRYPTOR_H
+#define FHE_ENCRYPTOR_H
+
+#include "ntt.h"
+#include "galois.h"
+#include "gadget.h"
+#include <vector>
+#include <map>
+#include <random>
+
+namespace fhe_cpp {
+
+// Polynomial samplers over Z_q (coefficients returned in [0, q))
+class PolySampler {
+private:
+    int N;
+    ModInt q;
+    double sigma;
+    std::mt19937_64 rng;
+
+public:
+    // seed = 0 seeds from std::random_device
+    PolySampler(int N, ModInt q, double sigma = 3.2, uint64_t seed = 0);
+    
+    std::vector<ModInt> uniform();
+    std::vector<ModInt> ternary();
+    std::vector<ModInt> gaussian();
+};
+
+class KeyGenerator {
+private:
+    const NTT& ntt;
+    GaloisTool galois;
+    PolySampler sampler;
+    std::vector<ModInt> sk;         // Ternary secret, coefficient form
+    std::vector<ModInt> sk_ntt;
+    
+    // (-(a*s + e) + m, a) in coefficient form
+    std::vector<std::vector<ModInt>> encrypt_zero_plus(const std::vector<ModInt>& m);
+
+public:
+    KeyGenerator(const NTT& ntt, double sigma = 3.2, uint64_t seed = 0);
+    // Keys for an existing secret (coefficient form, any representative mod q)
+    KeyGenerator(const NTT& ntt, const std::vector<ModInt>& secret_key,
+                 double sigma = 3.2, uint64_t seed = 0);
+    ~KeyGenerator() = default;
+    
+    const std::vector<ModInt>& secret_key() const { return sk; }
+    
+    // (b, a) with b = -(a*s + e)
+    std::vector<std::vector<ModInt>> public_key();
+    
+    // One (b_j, a_j) per decomposition digit with b_j = -(a_j*s + e_j) + w^j * s^2,
+    // flattened as [b_0, a_0, b_1, a_1, ...], the layout relinearize expects
+    std::vector<std::vector<ModInt>> relin_key(int decomp_bits = DEFAULT_DECOMP_BITS);
+    
+    // Per-digit keys b_j = -(a_j*s + e_j) + w^j * s(X^g) for each element,
+    // in the layout GaloisKeys expects
+    std::map<uint64_t, std::vector<std::vector<ModInt>>> galois_keys(
+        const std::vector<uint64_t>& galois_elts, int decomp_bits = DEFAULT_DECOMP_BITS);
+};
+
+// Not thread-safe (owns its sampler); use one Encryptor per thread
+class Encryptor {
+private:
+    const NTT& ntt;
+    ModInt t;
+    ModInt delta;                                   // floor(q / t)
+    std::vector<std::vector<ModInt>> pk_ntt;        // (b, a) in NTT form
+    PolySampler sampler;
+
+public:
+    Encryptor(const NTT& ntt, ModInt t,
+              const std::vector<std::vector<ModInt>>& public_key,
+              double sigma = 3.2, uint64_t seed = 0);
+    ~Encryptor() = default;
+    
+    // (b*u + e1 + delta*m, a*u + e2) for a plaintext polynomial with
+    // coefficients in [0, t)
+    std::vector<std::vector<ModInt>> encrypt(const std::vector<ModInt>& plain);
+    
+    std::vector<std::vector<std::vector<ModInt>>> encrypt_batch(
+        const std::vector<std::vector<ModInt>>& plains);
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_ENCRYPTOR_H
@@ -0,0 +1,601 @@
+/*
+ * Lazy Expression Graph Implementation
+ */
+
+#include "expr_graph.h"
+#include "instrumentation.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace fhe_cpp {
+
+// One kernel of an evaluation plan
+// Element-wise groups compute sum(coeff * leaf) plus a constant added to
+// component 0 (the constant term in coefficient form, every evaluation
+// in NTT form), optionally followed by a single relinearization
+struct ExprGraph::Step {
+    size_t node;
+    ExprOp op;
+    std::vector<std::pair<size_t, ModInt>> terms;
+    ModInt constant = 0;
+    bool relin_after = false;
+    Domain in = Domain::Coeff;
+    Domain out = Domain::Coeff;
+    std::vector<size_t> inputs;
+    size_t level = 0;
+};
+
+namespace {
+
+ModInt mul_mod(ModInt a, ModInt b, ModInt q) {
+    return (ModInt)(((unsigned __int128)a * b) % q);
+}
+
+} // namespace
+
+ExprGraph::ExprGraph(const BFVMultiplier& mult)
+    : mult(mult), ntt(mult.get_ntt()), galois_keys(nullptr),
+      forward_count(0), inverse_count(0), last_stats{} {
+}
+
+void ExprGraph::set_relin_key(const Ciphertext& relin_key) {
+    int N = ntt.get_N();
+    if (relin_key.size() != 2 * (size_t)mult.get_gadget().num_digits()) {
+        throw std::invalid_argument("Invalid relinearization key format");
+    }
+    relin_key_ntt = relin_key;
+    for (auto& comp : relin_key_ntt) {
+        if (comp.size() != (size_t)N) {
+            throw std::invalid_argument("Invalid relinearization key format");
+        }
+        ntt.forward(comp);
+    }
+}
+
+void ExprGraph::check(size_t id) const {
+    if (id >= nodes.size()) {
+        throw std::invalid_argument("Unknown expression node");
+    }
+}
+
+bool ExprGraph::is_linear(ExprOp op) const {
+    return op == ExprOp::Add || op == ExprOp::Subtract ||
+           op == ExprOp::MultiplyScalar || op == ExprOp::AddScalar;
+}
+
+size_t ExprGraph::push(Node node) {
+    for (size_t arg : node.args) {
+        check(arg);
+    }
+    nodes.push_back(std::move(node));
+    values.emplace_back();
+    return nodes.size() - 1;
+}
+
+size_t ExprGraph::input(const Ciphertext& ct) {
+    int N = ntt.get_N();
+    ModInt q = ntt.get_q();
+    if (ct.size() != 2 && ct.size() != 3) {
+        throw std::invalid_argument("Inputs must be size-2 or size-3 ciphertexts");
+    }
+    
+    Value value;
+    value.coeff = ct;
+    for (auto& comp : value.coeff) {
+        if (comp.size() != (size_t)N) {
+            throw std::invalid_argument("All ciphertext components must have size N");
+        }
+        for (auto& c : comp) {
+            c %= q;
+            if (c < 0) c += q;
+        }
+    }
+    
+    size_t id = push({ExprOp::Input, {}, 0, 0, 0, ct.size()});
+    values[id] = std::move(value);
+    return id;
+}
+
+size_t ExprGraph::add(size_t a, size_t b) {
+    check(a);
+    check(b);
+    return push({ExprOp::Add, {a, b}, 0, 0, 0, std::max(nodes[a].size, nodes[b].size)});
+}
+
+size_t ExprGraph::subtract(size_t a, size_t b) {
+    check(a);
+    check(b);
+    return push({ExprOp::Subtract, {a, b}, 0, 0, 0, std::max(nodes[a].size, nodes[b].size)});
+}
+
+size_t ExprGraph::multiply_scalar(size_t a, ModInt scalar) {
+    check(a);
+    return push({ExprOp::MultiplyScalar, {a}, scalar, 0, 0, nodes[a].size});
+}
+
+size_t ExprGraph::add_scalar(size_t a, ModInt scalar) {
+    check(a);
+    return push({ExprOp::AddScalar, {a}, scalar, 0, 0, nodes[a].size});
+}
+
+size_t ExprGraph::multiply(size_t a, size_t b) {
+    check(a);
+    check(b);
+    if (nodes[a].size != 2 || nodes[b].size != 2) {
+        throw std::invalid_argument("Can only multiply size-2 ciphertexts");
+    }
+    return push({ExprOp::Multiply, {a, b}, 0, 0, 0, 3});
+}
+
+size_t ExprGraph::relinearize(size_t a) {
+    check(a);
+    if (nodes[a].size != 3) {
+        throw std::invalid_argument("Can only relinearize size-3 ciphertexts");
+    }
+    if (relin_key_ntt.empty()) {
+        throw std::runtime_error("Relinearization key not set");
+    }
+    return push({ExprOp::Relinearize, {a}, 0, 0, 0, 2});
+}
+
+size_t ExprGraph::multiply_plain(size_t a, const std::vector<ModInt>& plain) {
+    check(a);
+    int N = ntt.get_N();
+    ModInt q = ntt.get_q();
+    ModInt t = mult.get_t();
+    if (plain.size() != (size_t)N) {
+        throw std::invalid_argument("Plaintext must have size N");
+    }
+    
+    // Same centered lift as BFVMultiplier::multiply_plain
+    std::vector<ModInt> plain_q(N);
+    for (int i = 0; i < N; i++) {
+        ModInt v = plain[i] % t;
+        if (v < 0) v += t;
+        plain_q[i] = v > t / 2 ? v - t + q : v;
+    }
+    ntt.forward(plain_q);
+    plains.push_back(plain);
+    plains_ntt.push_back(std::move(plain_q));
+    return push({ExprOp::MultiplyPlain, {a}, 0, plains.size() - 1, 0, nodes[a].size});
+}
+
+size_t ExprGraph::rotate(size_t a, uint64_t galois_elt) {
+    check(a);
+    if (nodes[a].size != 2) {
+        throw std::invalid_argument("Can only rotate size-2 ciphertexts");
+    }
+    if (galois_keys == nullptr || !galois_keys->has(galois_elt)) {
+        throw std::runtime_error("No Galois key for element " + std::to_string(galois_elt));
+    }
+    return push({ExprOp::Rotate, {a}, 0, 0, galois_elt, 2});
+}
+
+void ExprGraph::forward(Ciphertext& ct) {
+    for (auto& comp : ct) {
+        ntt.forward(comp);
+    }
+    forward_count += ct.size();
+}
+
+void ExprGraph::inverse(Ciphertext& ct) {
+    for (auto& comp : ct) {
+        ntt.inverse(comp);
+    }
+    inverse_count += ct.size();
+}
+
+// Relinearize d (size 3, in domain `in`) into a size-2 result in `out`;
+// the digits of d2 are taken in coefficient form and the key products
+// formed pointwise
+ExprGraph::Ciphertext ExprGraph::relinearize_in(const Ciphertext& d, Domain in, Domain out) {
+    FHE_COUNT(KeySwitch, 1);
+    FHE_TRACE_SPAN("relinearize", "keyswitch");
+    
+    std::vector<ModInt> d2 = d[2];
+    if (in == Domain::Ntt) {
+        Ciphertext tmp = {d2};
+        inverse(tmp);
+        d2 = std::move(tmp[0]);
+    }
+    Ciphertext key_part = mult.key_switch_ntt(d2, relin_key_ntt);
+    forward_count += mult.get_gadget().num_digits();
+    
+    if (out == Domain::Ntt) {
+        Ciphertext d01 = {d[0], d[1]};
+        if (in == Domain::Coeff) forward(d01);
+        return {ntt.add(d01[0], key_part[0]), ntt.add(d01[1], key_part[1])};
+    }
+    
+    inverse(key_part);
+    if (in == Domain::Ntt) {
+        Ciphertext d01 = {d[0], d[1]};
+        inverse(d01);
+        return {ntt.add(d01[0], key_part[0]), ntt.add(d01[1], key_part[1])};
+    }
+    return {ntt.add(d[0], key_part[0]), ntt.add(d[1], key_part[1])};
+}
+
+void ExprGraph::run(Step& step, std::vector<Value>& work) {
+    auto value_of = [&](size_t id) -> const Value& {
+        return values[id].has(Domain::Coeff) || values[id].has(Domain::Ntt) ? values[id] : work[id];
+    };
+    const Node& node = nodes[step.node];
+    ModInt q = ntt.get_q();
+    Ciphertext result;
+    
+    switch (step.op) {
+        case ExprOp::Multiply: {
+            // Products mod q reuse the NTT forms; the exact product over Z
+            // also needs the coefficients
+            const Value& a = value_of(node.args[0]);
+            const Value& b = value_of(node.args[1]);
+            result = mult.multiply_ciphertexts_ntt(a.coeff, a.ntt, b.coeff, b.ntt);
+            inverse_count += 3;
+            break;
+        }
+        
+        case ExprOp::MultiplyPlain:
+            for (const auto& comp : value_of(node.args[0]).ntt) {
+                result.push_back(ntt.pointwise_multiply(comp, plains_ntt[node.plain]));
+            }
+            break;
+        
+        case ExprOp::Rotate: {
+            // The key switch decomposes c1 in coefficient form, reused
+            // when the input already has one
+            const Value& a = value_of(node.args[0]);
+            std::vector<ModInt> c1 = a.has(Domain::Coeff) ? a.coeff[1] : a.ntt[1];
+            if (!a.has(Domain::Coeff)) {
+                ntt.inverse(c1);
+                inverse_count += 1;
+            }
+            result = mult.rotate_digits_ntt(a.ntt[0], mult.decompose_ntt(c1),
+                                            node.galois_elt, *galois_keys);
+            forward_count += mult.get_gadget().num_digits();
+            break;
+        }
+        
+        case ExprOp::Relinearize:
+            result = relinearize_in(value_of(node.args[0]).get(step.in), step.in, step.out);
+            break;
+        
+        default: {
+            // Fused element-wise group: one pass over the leaves
+            FHE_TRACE_SPAN("fused_elementwise", "expr");
+            size_t size = 0;
+            for (const auto& term : step.terms) {
+                size = std::max(size, nodes[term.first].size);
+            }
+            size = std::max<size_t>(size, step.relin_after ? 3 : node.size);
+            
+            size_t N = ntt.get_N();
+            result.assign(size, std::vector<ModInt>(N, 0));
+            for (size_t c = 0; c < size; c++) {
+                auto& out = result[c];
+                for (const auto& term : step.terms) {
+                    const Ciphertext& leaf = value_of(term.first).get(step.in);
+                    if (c >= leaf.size()) continue;
+                    const auto& x = leaf[c];
+                    if (term.second == 1) {
+                        for (size_t j = 0; j < N; j++) {
+                            ModInt v = out[j] + x[j];
+                            out[j] = v >= q ? v - q : v;
+                        }
+                    } else {
+                        for (size_t j = 0; j < N; j++) {
+                            ModInt v = out[j] + mul_mod(x[j], term.second, q);
+                            out[j] = v >= q ? v - q : v;
+                        }
+                    }
+                }
+            }
+            if (step.constant != 0) {
+                size_t count = step.in == Domain::Coeff ? 1 : N;
+                for (size_t j = 0; j < count; j++) {
+                    ModInt v = result[0][j] + step.constant;
+                    result[0][j] = v >= q ? v - q : v;
+                }
+            }
+            if (step.relin_after) {
+                result = relinearize_in(result, step.in, step.out);
+            }
+            break;
+        }
+    }
+    
+    (step.out == Domain::Coeff ? work[step.node].coeff : work[step.node].ntt) = std::move(result);
+}
+
+std::vector<ExprGraph::Ciphertext> ExprGraph::evaluate(const std::vector<size_t>& ids) {
+    FHE_TRACE_SPAN("expr_evaluate", "expr");
+    for (size_t id : ids) {
+        check(id);
+    }
+    
+    size_t n = nodes.size();
+    ModInt q = ntt.get_q();
+    ModInt t = mult.get_t();
+    auto held = [&](size_t id) {
+        return values[id].has(Domain::Coeff) || values[id].has(Domain::Ntt);
+    };
+    
+    // Nodes to compute: everything reachable from the requested ids that
+    // is not already held
+    std::vector<char> needed(n, 0), requested(n, 0);
+    std::vector<size_t> stack;
+    for (size_t id : ids) {
+        requested[id] = 1;
+        stack.push_back(id);
+    }
+    while (!stack.empty()) {
+        size_t id = stack.back();
+        stack.pop_back();
+        if (needed[id] || held(id)) continue;
+        needed[id] = 1;
+        for (size_t arg : nodes[id].args) stack.push_back(arg);
+    }
+    
+    std::vector<std::vector<size_t>> consumers(n);
+    for (size_t id = 0; id < n; id++) {
+        if (!needed[id]) continue;
+        for (size_t arg : nodes[id].args) consumers[arg].push_back(id);
+    }
+    auto single_private_use = [&](size_t id) {
+        return needed[id] && !requested[id] && consumers[id].size() == 1;
+    };
+    
+    // Element-wise nodes used once by another element-wise node are folded
+    // into their consumer's group
+    std::vector<char> absorbed(n, 0);
+    size_t fused = 0;
+    for (size_t id = 0; id < n; id++) {
+        if (is_linear(nodes[id].op) && single_private_use(id) &&
+            is_linear(nodes[consumers[id][0]].op)) {
+            absorbed[id] = 1;
+            fused++;
+        }
+    }
+    
+    auto wants_ntt = [&](size_t id) {
+        for (size_t c : consumers[id]) {
+            ExprOp op = nodes[c].op;
+            if (op == ExprOp::Multiply || op == ExprOp::MultiplyPlain || op == ExprOp::Rotate) {
+                return !requested[id];
+            }
+        }
+        return false;
+    };
+    
+    // Expand every element-wise group into sum(coeff * leaf) + constant
+    std::map<size_t, Step> groups;
+    size_t saved = 0;
+    for (size_t id = 0; id < n; id++) {
+        if (!needed[id] || absorbed[id] || !is_linear(nodes[id].op)) continue;
+        Step& step = groups[id];
+        std::map<size_t, ModInt> terms;
+        ModInt constant = 0;
+        std::vector<std::pair<size_t, ModInt>> todo = {{id, 1}};
+        while (!todo.empty()) {
+            auto [x, c] = todo.back();
+            todo.pop_back();
+            const Node& xn = nodes[x];
+            if (x != id && !absorbed[x]) {
+                terms[x] = (terms[x] + c) % q;
+                continue;
+            }
+            switch (xn.op) {
+                case ExprOp::Add:
+                    todo.push_back({xn.args[0], c});
+                    todo.push_back({xn.args[1], c});
+                    break;
+                case ExprOp::Subtract:
+                    todo.push_back({xn.args[0], c});
+                    todo.push_back({xn.args[1], c == 0 ? 0 : q - c});
+                    break;
+                case ExprOp::MultiplyScalar: {
+                    // Centered scalar, as in BFVMultiplier::multiply_scalar
+                    ModInt s = xn.scalar % t;
+                    if (s < 0) s += t;
+                    if (s > t / 2) s -= t;
+                    todo.push_back({xn.args[0], mul_mod(c, s < 0 ? s + q : s, q)});
+                    break;
+                }
+                default: {     // AddScalar
+                    ModInt s = xn.scalar % t;
+                    if (s < 0) s += t;
+                    ModInt scaled = mul_mod(mult.get_delta(), s, q);
+                    constant = (constant + mul_mod(c, scaled, q)) % q;
+                    todo.push_back({xn.args[0], c});
+                    break;
+                }
+            }
+        }
+        
+        // Lazy relinearization: a sum of several privately used
+        // relinearized products is relinearized once (relinearization
+        // is linear), provided no other leaf is itself size 3
+        std::vector<size_t> relins;
+        bool other_size3 = false;
+        for (const auto& term : terms) {
+            if (nodes[term.first].op == ExprOp::Relinearize && single_private_use(term.first)) {
+                relins.push_back(term.first);
+            } else if (nodes[term.first].size == 3) {
+                other_size3 = true;
+            }
+        }
+        if (relins.size() >= 2 && !other_size3) {
+            for (size_t r : relins) {
+                ModInt c = terms[r];
+                terms.erase(r);
+                size_t d = nodes[r].args[0];
+                terms[d] = (terms[d] + c) % q;
+                absorbed[r] = 1;
+            }
+            step.relin_after = true;
+            saved += relins.size() - 1;
+        }
+        
+        for (const auto& term : terms) {
+            if (term.second != 0) step.terms.push_back(term);
+        }
+        step.constant = constant;
+        for (const auto& term : step.terms) step.inputs.push_back(term.first);
+    }
+    
+    // Build steps in id order (arguments always precede their users),
+    // choosing where each value lives
+    std::vector<Step> steps;
+    std::vector<long> step_of(n, -1);
+    std::vector<char> avail_ntt(n, 0), avail_coeff(n, 0);
+    for (size_t id = 0; id < n; id++) {
+        if (held(id)) {
+            avail_coeff[id] = values[id].has(Domain::Coeff);
+            avail_ntt[id] = values[id].has(Domain::Ntt);
+        }
+    }
+    
+    for (size_t id = 0; id < n; id++) {
+        if (!needed[id] || absorbed[id]) continue;
+        const Node& node = nodes[id];
+        Step step;
+        if (is_linear(node.op)) {
+            step = std::move(groups[id]);
+            
+            // Work in the domain most leaves already have
+            size_t miss_coeff = 0, miss_ntt = 0;
+            for (size_t leaf : step.inputs) {
+                miss_coeff += !avail_coeff[leaf];
+                miss_ntt += !avail_ntt[leaf];
+            }
+            bool ntt_out = wants_ntt(id);
+            step.in = (miss_ntt < miss_coeff || (miss_ntt == miss_coeff && ntt_out))
+                ? Domain::Ntt : Domain::Coeff;
+            step.out = step.relin_after ? (ntt_out ? Domain::Ntt : Domain::Coeff) : step.in;
+        } else {
+            step.inputs = node.args;
+            switch (node.op) {
+                case ExprOp::Multiply:
+                    step.in = Domain::Ntt;
+                    step.out = Domain::Coeff;
+                    break;
+                case ExprOp::MultiplyPlain:
+                case ExprOp::Rotate:
+                    step.in = step.out = Domain::Ntt;
+                    break;
+                case ExprOp::Relinearize:
+                    step.out = wants_ntt(id) ? Domain::Ntt : Domain::Coeff;
+                    step.in = (step.out == Domain::Ntt ? avail_ntt : avail_coeff)[node.args[0]]
+                        ? step.out
+                        : (avail_ntt[node.args[0]] ? Domain::Ntt : Domain::Coeff);
+                    break;
+                default:
+                    break;
+            }
+        }
+        step.node = id;
+        step.op = node.op;
+        std::sort(step.inputs.begin(), step.inputs.end());
+        step.inputs.erase(std::unique(step.inputs.begin(), step.inputs.end()), step.inputs.end());
+        
+        (step.out == Domain::Ntt ? avail_ntt : avail_coeff)[id] = 1;
+        step_of[id] = (long)steps.size();
+        steps.push_back(std::move(step));
+    }
+    
+    // A step runs one level after the latest step it reads
+    size_t levels = 0;
+    std::vector<size_t> uses(n, 0);
+    for (auto& step : steps) {
+        for (size_t input : step.inputs) {
+            if (step_of[input] >= 0) {
+                step.level = std::max(step.level, steps[step_of[input]].level + 1);
+            }
+            uses[input]++;
+        }
+        levels = std::max(levels, step.level + 1);
+    }
+    
+    std::vector<std::vector<size_t>> by_level(levels);
+    for (size_t s = 0; s < steps.size(); s++) {
+        by_level[steps[s].level].push_back(s);
+    }
+    
+    forward_count = 0;
+    inverse_count = 0;
+    size_t relinearizations = 0;
+    for (const auto& step : steps) {
+        relinearizations += step.op == ExprOp::Relinearize || step.relin_after;
+    }
+    
+    std::vector<Value> work(n);
+    auto slot = [&](size_t id) -> Value& { return held(id) ? values[id] : work[id]; };
+    auto pool = ThreadPool::global();
+    
+    for (const auto& level : by_level) {
+        // Convert the inputs this level reads in a domain they lack; each
+        // (value, domain) pair is converted once and shared by all readers.
+        // Multiplications read both forms of their inputs
+        std::vector<std::pair<size_t, Domain>> conversions;
+        for (size_t s : level) {
+            for (size_t input : steps[s].inputs) {
+                if (!slot(input).has(steps[s].in)) {
+                    conversions.emplace_back(input, steps[s].in);
+                } else if (steps[s].op == ExprOp::Multiply && !slot(input).has(Domain::Coeff)) {
+                    conversions.emplace_back(input, Domain::Coeff);
+                }
+            }
+        }
+        std::sort(conversions.begin(), conversions.end());
+        conversions.erase(std::unique(conversions.begin(), conversions.end()), conversions.end());
+        pool->parallel_for(conversions.size(), [&](size_t i) {
+            Value& v = slot(conversions[i].first);
+            if (conversions[i].second == Domain::Ntt) {
+                v.ntt = v.coeff;
+                forward(v.ntt);
+            } else {
+                v.coeff = v.ntt;
+                inverse(v.coeff);
+            }
+        });
+        
+        pool->parallel_for(level.size(), [&](size_t i) {
+            run(steps[level[i]], work);
+        });
+        
+        // Release intermediates once their last reader has run
+        for (size_t s : level) {
+            for (size_t input : steps[s].inputs) {
+                if (--uses[input] == 0 && !held(input) && !requested[input]) {
+                    work[input] = Value();
+                }
+            }
+        }
+    }
+    
+    std::vector<Ciphertext> results;
+    results.reserve(ids.size());
+    for (size_t id : ids) {
+        if (!held(id)) {
+            values[id] = std::move(work[id]);
+        }
+        Value& v = values[id];
+        if (!v.has(Domain::Coeff)) {
+            v.coeff = v.ntt;
+            inverse(v.coeff);
+        }
+        results.push_back(v.coeff);
+    }
+    
+    size_t evaluated = 0;
+    for (size_t id = 0; id < n; id++) evaluated += needed[id];
+    last_stats = {evaluated, steps.size(), fused, levels, forward_count.load(),
+                  inverse_count.load(), relinearizations, saved};
+    return results;
+}
+
+} // namespace fhe_cpp
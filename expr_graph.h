@@ -0,0 +1,133 @@
+/*
+ * Lazy expression graph
+ * Evaluator calls record nodes of a DAG instead of computing; evaluate()
+ * plans the requested results as a whole: chains of element-wise ops are
+ * fused into one pass, values stay in NTT form between NTT consumers,
+ * each value is transformed at most once per domain, sums of
+ * relinearized products are relinearized once, and independent nodes
+ * run in parallel on the global thread pool
+ *
+ * Results are identical to the eager BFVMultiplier calls, except where a
+ * sum of products is relinearized once: the digit decomposition is not
+ * linear, so that ciphertext differs from the sum of separately
+ * relinearized terms (same message, less key-switching noise)
+ */
+
+#ifndef FHE_EXPR_GRAPH_H
+#define FHE_EXPR_GRAPH_H
+
+#include "bfv_mult.h"
+#include "galois.h"
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+namespace fhe_cpp {
+
+enum class ExprOp {
+    Input,
+    Add,
+    Subtract,
+    MultiplyScalar,
+    AddScalar,
+    Multiply,       // Size-3 result
+    Relinearize,
+    MultiplyPlain,
+    Rotate
+};
+
+struct ExprStats {
+    size_t nodes;                   // Nodes evaluated by the last plan
+    size_t steps;                   // Kernels run after fusion
+    size_t fused_nodes;             // Element-wise nodes folded into another
+    size_t levels;                  // Parallel stages
+    size_t forward_ntts;
+    size_t inverse_ntts;
+    size_t relinearizations;
+    size_t relinearizations_saved;  // Relinearizations merged into a sum
+};
+
+class ExprGraph {
+public:
+    using Ciphertext = std::vector<std::vector<ModInt>>;
+
+private:
+    enum class Domain { Coeff, Ntt };
+    
+    struct Node {
+        ExprOp op;
+        std::vector<size_t> args;
+        ModInt scalar;          // MultiplyScalar / AddScalar
+        size_t plain;           // MultiplyPlain: index into plains
+        uint64_t galois_elt;    // Rotate
+        size_t size;            // Number of ciphertext components
+    };
+    
+    // Value of a node in either domain; empty when not held
+    struct Value {
+        Ciphertext coeff;
+        Ciphertext ntt;
+        bool has(Domain d) const { return !(d == Domain::Coeff ? coeff : ntt).empty(); }
+        const Ciphertext& get(Domain d) const { return d == Domain::Coeff ? coeff : ntt; }
+    };
+    
+    struct Step;
+    
+    const BFVMultiplier& mult;
+    const NTT& ntt;
+    const GaloisKeys* galois_keys;
+    Ciphertext relin_key_ntt;
+    
+    std::vector<Node> nodes;
+    std::vector<Value> values;          // Inputs and already evaluated results
+    std::vector<std::vector<ModInt>> plains;
+    std::vector<std::vector<ModInt>> plains_ntt;
+    
+    std::atomic<size_t> forward_count;
+    std::atomic<size_t> inverse_count;
+    ExprStats last_stats;
+    
+    size_t push(Node node);
+    void check(size_t id) const;
+    bool is_linear(ExprOp op) const;
+    
+    void forward(Ciphertext& ct);
+    void inverse(Ciphertext& ct);
+    Ciphertext relinearize_in(const Ciphertext& d, Domain in, Domain out);
+    void run(Step& step, std::vector<Value>& work);
+
+public:
+    explicit ExprGraph(const BFVMultiplier& mult);
+    
+    ExprGraph(const ExprGraph&) = delete;
+    ExprGraph& operator=(const ExprGraph&) = delete;
+    
+    // Keys used by relinearize / rotate nodes (relin key in coefficient form)
+    void set_relin_key(const Ciphertext& relin_key);
+    void set_galois_keys(const GaloisKeys& keys) { galois_keys = &keys; }
+    
+    // Graph construction; every call returns the new node's id
+    size_t input(const Ciphertext& ct);
+    size_t add(size_t a, size_t b);
+    size_t subtract(size_t a, size_t b);
+    size_t multiply_scalar(size_t a, ModInt scalar);
+    size_t add_scalar(size_t a, ModInt scalar);
+    size_t multiply(size_t a, size_t b);
+    size_t relinearize(size_t a);
+    size_t multiply_plain(size_t a, const std::vector<ModInt>& plain);
+    size_t rotate(size_t a, uint64_t galois_elt);
+    
+    // Compute the requested nodes (coefficient form); results are kept,
+    // so later evaluations reuse them
+    std::vector<Ciphertext> evaluate(const std::vector<size_t>& ids);
+    Ciphertext evaluate(size_t id) { return evaluate(std::vector<size_t>{id})[0]; }
+    
+    size_t num_nodes() const { return nodes.size(); }
+    size_t size_of(size_t id) const { check(id); return nodes[id].size; }
+    ExprOp op_of(size_t id) const { check(id); return nodes[id].op; }
+    const ExprStats& stats() const { return last_stats; }
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_EXPR_GRAPH_H
@@ -5,6 +5,8 @@ Uses our own BFV implementation with NumPy optimization
 
 import sys
 import time
+import hmac
+import hashlib
 import numpy as np
 
 # Import our custom FHE library
@@ -47,10 +49,28 @@ def ints_to_string(ints):
     return ''.join(chars)
 
 
+def bucket_tag(value, index_key, num_buckets):
+    """
+    Keyed-hash bucket of a value: HMAC-SHA256(index_key, value) mod num_buckets
+    The server sees only the tag; fewer buckets leak less about the value
+    but leave more rows to scan per query
+    """
+    digest = hmac.new(index_key, str(value).encode('utf-8'), hashlib.sha256).digest()
+    return int.from_bytes(digest[:8], 'big') % num_buckets
+
+
 class CustomFHEClient:
-    def __init__(self, fhe):
+    def __init__(self, fhe, index_key=None, num_index_buckets=None):
+        """
+        Args:
+            fhe: FHE scheme instance
+            index_key: Secret key (bytes) for bucket tags; None disables the index
+            num_index_buckets: Number of index buckets (controls leakage)
+        """
         self.fhe = fhe
-
+        self.index_key = index_key
+        self.num_index_buckets = num_index_buckets
+    
     def encrypt_dataset(self, data):
         """
         Encrypt dataset using our custom FHE
@@ -72,26 +92,56 @@ class CustomFHEClient:
             pt_email = self.fhe.encode(email_vals)
             enc_email = self.fhe.encrypt(pt_email)
             
-            encrypted_rows.append({
+            enc_row = {
                 'date': enc_date,
                 'email': enc_email
-            })
+            }
+            
+            # 3. Optional index tag for bucketed exact match
+            if self.index_key is not None:
+                enc_row['bucket'] = bucket_tag(
+                    date_val, self.index_key, self.num_index_buckets)
+            
+            encrypted_rows.append(enc_row)
             
             print_progress(i + 1, len(data), start_time, 
                           prefix='Encrypting', suffix=f'Row {i+1}')
         
         return encrypted_rows
-
+    
     def encrypt_query(self, target_date):
         """Encrypt single target date for Exact Match"""
         pt = self.fhe.encode(target_date)
         return self.fhe.encrypt(pt)
-
+    
+    def encrypt_indexed_query(self, target_date):
+        """Encrypt target date and name the index bucket to scan"""
+        if self.index_key is None:
+            raise ValueError("Client was created without an index key")
+        bucket = bucket_tag(target_date, self.index_key, self.num_index_buckets)
+        return self.encrypt_query(target_date), bucket
+    
+    def decrypt_indexed_results(self, results):
+        """Decrypt (row, email, diff) results from process_indexed_query"""
+        print("\nDecrypting Indexed Results")
+        
+        matches = {}
+        for row, enc_email, enc_diff in results:
+            diff_val = self.fhe.decode(self.fhe.decrypt(enc_diff), num_values=1)
+            if diff_val == 0:
+                email_ints = self.fhe.decode(self.fhe.decrypt(enc_email), num_values=12)
+                matches[row] = f"MATCH: {ints_to_string(email_ints)}"
+        
+        return matches
+    
     def decrypt_results(self, results):
         """Decrypt and check for exact matches (zeros)"""
         print("\nDecrypting Results")
         start_time = time.time()
         
+        if hasattr(self.fhe, 'decrypt_batch'):
+            return self._decrypt_results_batch(results, start_time)
+        
         plain_results = []
         for i, (enc_email, enc_diff) in enumerate(results):
             # Decrypt the difference
@@ -112,12 +162,36 @@ class CustomFHEClient:
                           prefix='Decrypting', suffix=f'Row {i+1}')
         
         return plain_results
+    
+    def _decrypt_results_batch(self, results, start_time):
+        """decrypt_results with two native batch calls (diffs, then matches)"""
+        pt_diffs = self.fhe.decrypt_batch([enc_diff for _, enc_diff in results])
+        diff_vals = [self.fhe.decode(pt, num_values=1) for pt in pt_diffs]
+        
+        matched = [i for i, d in enumerate(diff_vals) if d == 0]
+        pt_emails = self.fhe.decrypt_batch([results[i][0] for i in matched])
+        
+        plain_results = ["---"] * len(results)
+        for i, pt_email in zip(matched, pt_emails):
+            email_ints = self.fhe.decode(pt_email, num_values=12)
+            plain_results[i] = f"MATCH: {ints_to_string(email_ints)}"
+        
+        print_progress(len(results), len(results), start_time,
+                      prefix='Decrypting', suffix=f'Row {len(results)}')
+        return plain_results
+    
+    def decrypt_aggregate(self, enc_total):
+        """Decrypt a single aggregate (SUM/COUNT) ciphertext"""
+        pt_total = self.fhe.decrypt(enc_total)
+        return self.fhe.decode(pt_total, num_values=1)
 
 
 class CustomFHEServer:
     def __init__(self, fhe):
         self.fhe = fhe
-
+        self._scanner = None
+        self._scanner_rows = None
+    
     def process_query(self, enc_data, enc_target_date):
         """
         Targeted Search: Compute (Data - Target)
@@ -142,6 +216,93 @@ class CustomFHEServer:
                           prefix='Processing', suffix=f'Row {i+1}')
         
         return results
+    
+    def process_indexed_query(self, enc_data, enc_target_date, bucket):
+        """
+        Bucketed Search: only the rows tagged with the query's bucket are
+        compared; the comparison itself is unchanged and stays encrypted
+        Returns (row, enc_email, diff) for the scanned rows
+        """
+        print(f"\nProcessing Indexed Query (bucket {bucket})")
+        start_time = time.time()
+        
+        if hasattr(self.fhe, 'create_table_scanner') and self.fhe.use_cpp:
+            if self._scanner is None or self._scanner_rows is not enc_data:
+                self._scanner = self.fhe.create_table_scanner(enc_data)
+                self._scanner_rows = enc_data
+            diffs = self.fhe.exact_match_indexed(
+                self._scanner, [enc_target_date], [bucket])[0]
+            results = [(row, enc_data[row]['email'], diff) for row, diff in diffs]
+        else:
+            results = []
+            for i, row in enumerate(enc_data):
+                if row.get('bucket') != bucket:
+                    continue
+                diff = self.fhe.sub(row['date'], enc_target_date)
+                results.append((i, row['email'], diff))
+        
+        print(f"Scanned {len(results)} of {len(enc_data)} rows "
+              f"in {time.time() - start_time:.2f}s")
+        return results
+    
+    def process_queries(self, enc_data, enc_targets, sink=None):
+        """
+        Batch Search: evaluate many targets in a single pass over the table
+        Each row is loaded once and reused by every query
+        With a sink, each row's results are streamed as sink(row, email,
+        diffs) with one difference per target, and nothing is returned;
+        otherwise returns one result list per target, as process_query would
+        """
+        print(f"\nProcessing {len(enc_targets)} Queries (Single Pass)")
+        start_time = time.time()
+        
+        if sink is None:
+            results = [[None] * len(enc_data) for _ in enc_targets]
+            
+            def sink(row, email, diffs):
+                for qi, diff in enumerate(diffs):
+                    results[qi][row] = (email, diff)
+        else:
+            results = None
+        
+        if hasattr(self.fhe, 'create_table_scanner') and self.fhe.use_cpp:
+            if self._scanner is None or self._scanner_rows is not enc_data:
+                self._scanner = self.fhe.create_table_scanner(enc_data)
+                self._scanner_rows = enc_data
+            self.fhe.exact_match_batch(
+                self._scanner, enc_targets,
+                lambda row, diffs: sink(row, enc_data[row]['email'], diffs))
+            print(f"Processed {len(enc_data)} rows x {len(enc_targets)} queries "
+                  f"in {time.time() - start_time:.2f}s")
+            return results
+        
+        for i, row in enumerate(enc_data):
+            diffs = [self.fhe.sub(row['date'], enc_target) for enc_target in enc_targets]
+            sink(i, row['email'], diffs)
+            
+            print_progress(i + 1, len(enc_data), start_time,
+                          prefix='Processing', suffix=f'Row {i+1}')
+        
+        return results
+    
+    def aggregate(self, enc_values, enc_mask=None, shrink=False):
+        """
+        Aggregate Query: SUM (or COUNT of ones) over all slots
+        Returns a single ciphertext instead of one per row
+        With shrink, the result is switched to the smallest modulus that
+        still decrypts before it is returned
+        """
+        if enc_mask is None:
+            result = self.fhe.sum_slots(enc_values)
+        else:
+            result = self.fhe.masked_sum(enc_values, enc_mask)
+        return self.shrink(result) if shrink else result
+    
+    def shrink(self, ct):
+        """Modulus-switch a response ciphertext down when its noise is tracked"""
+        if not hasattr(self.fhe, 'mod_switch_to') or ct.noise is None:
+            return ct
+        return self.fhe.mod_switch_to(ct)
 
 
 def main():
@@ -0,0 +1,62 @@
+/*
+ * Gadget Decomposition Implementation
+ */
+
+#include "gadget.h"
+
+namespace fhe_cpp {
+
+GadgetDecomposition::GadgetDecomposition(int N, ModInt q, int decomp_bits)
+    : N(N), q(q) {
+    if (q < 2) {
+        throw std::invalid_argument("Modulus must be at least 2");
+    }
+    if (decomp_bits < 0) {
+        throw std::invalid_argument("Decomposition base must be non-negative");
+    }
+    
+    int log_q = 0;
+    while (log_q < 63 && ((ModInt)1 << log_q) <= q) log_q++;
+    
+    bits = (decomp_bits == 0 || decomp_bits >= log_q) ? log_q : decomp_bits;
+    digits = (log_q + bits - 1) / bits;
+    
+    powers.resize(digits);
+    ModInt w = (ModInt)(((unsigned __int128)1 << bits) % (unsigned __int128)q);
+    powers[0] = 1;
+    for (int j = 1; j < digits; j++) {
+        powers[j] = (ModInt)(((__int128)powers[j - 1] * w) % q);
+    }
+}
+
+std::vector<std::vector<ModInt>> GadgetDecomposition::decompose(
+    const std::vector<ModInt>& poly) const {
+    if (poly.size() != (size_t)N) {
+        throw std::invalid_argument("Input size must equal N");
+    }
+    
+    std::vector<std::vector<ModInt>> result(digits, std::vector<ModInt>(N));
+    ModInt w = (ModInt)1 << (bits < 62 ? bits : 62);
+    ModInt half = w / 2;
+    
+    for (int i = 0; i < N; i++) {
+        // Balanced digits of the centered representative; the last digit
+        // takes the remainder, which is at most w/2 + 1 in size
+        ModInt x = poly[i] % q;
+        if (x < 0) x += q;
+        if (x > q / 2) x -= q;
+        
+        for (int j = 0; j < digits; j++) {
+            ModInt d = x;
+            if (j + 1 < digits) {
+                d = x & (w - 1);
+                if (d >= half) d -= w;
+                x = (x - d) >> bits;
+            }
+            result[j][i] = d < 0 ? d + q : d;
+        }
+    }
+    return result;
+}
+
+} // namespace fhe_cpp
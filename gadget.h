@@ -0,0 +1,47 @@
+/*
+ * Gadget decomposition for key switching
+ * A polynomial c mod q is split into l balanced base-w digits,
+ * c = sum_j w^j * d_j with |d_j| <= w/2, so a key switch multiplies small
+ * digits by keys encrypting w^j * s' and adds l * N * w/2 * e of noise
+ * instead of the q * e a single undecomposed product would
+ */
+
+#ifndef FHE_GADGET_H
+#define FHE_GADGET_H
+
+#include "ntt.h"
+#include <vector>
+
+namespace fhe_cpp {
+
+// Digit size used when none is given (4 digits for a 60-bit modulus)
+const int DEFAULT_DECOMP_BITS = 16;
+
+class GadgetDecomposition {
+private:
+    int N;
+    ModInt q;
+    int bits;                   // log2(w)
+    int digits;                 // l = ceil(log2(q) / bits)
+    std::vector<ModInt> powers; // w^j mod q
+
+public:
+    // decomp_bits = 0 (or at least the size of q) keeps a single digit,
+    // i.e. no decomposition
+    GadgetDecomposition(int N, ModInt q, int decomp_bits = DEFAULT_DECOMP_BITS);
+    ~GadgetDecomposition() = default;
+    
+    int num_digits() const { return digits; }
+    int digit_bits() const { return bits; }
+    
+    // w^j mod q, the factor key j encrypts alongside the target secret
+    ModInt power(int j) const { return powers.at(j); }
+    
+    // Digits of a polynomial in coefficient form; each digit is returned
+    // in [0, q) (negative digits as q - |d|)
+    std::vector<std::vector<ModInt>> decompose(const std::vector<ModInt>& poly) const;
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_GADGET_H
@@ -0,0 +1,114 @@
+/*
+ * Galois Automorphism Implementation
+ */
+
+#include "galois.h"
+#include <string>
+
+namespace fhe_cpp {
+
+GaloisTool::GaloisTool(int N, ModInt q) : N(N), q(q) {
+    if ((N & (N - 1)) != 0) {
+        throw std::invalid_argument("N must be a power of 2");
+    }
+}
+
+std::vector<ModInt> GaloisTool::apply(const std::vector<ModInt>& poly,
+                                      uint64_t galois_elt) const {
+    if (poly.size() != (size_t)N) {
+        throw std::invalid_argument("Input size must equal N");
+    }
+    if (galois_elt % 2 == 0) {
+        throw std::invalid_argument("Galois element must be odd");
+    }
+    
+    uint64_t two_n = 2 * (uint64_t)N;
+    std::vector<ModInt> result(N);
+    
+    // X^i -> X^(i*g mod 2N), with X^N = -1
+    for (int i = 0; i < N; i++) {
+        uint64_t k = ((uint64_t)i * galois_elt) % two_n;
+        if (k < (uint64_t)N) {
+            result[k] = poly[i];
+        } else {
+            result[k - N] = poly[i] == 0 ? 0 : q - poly[i];
+        }
+    }
+    return result;
+}
+
+std::vector<ModInt> GaloisTool::apply_ntt(const std::vector<ModInt>& poly_ntt,
+                                          uint64_t galois_elt) const {
+    if (poly_ntt.size() != (size_t)N) {
+        throw std::invalid_argument("Input size must equal N");
+    }
+    if (galois_elt % 2 == 0) {
+        throw std::invalid_argument("Galois element must be odd");
+    }
+    
+    uint64_t two_n = 2 * (uint64_t)N;
+    std::vector<ModInt> result(N);
+    
+    // a(X^g) evaluated at psi^(2j+1) is a evaluated at psi^(g(2j+1))
+    for (int j = 0; j < N; j++) {
+        uint64_t exponent = (galois_elt * (2 * (uint64_t)j + 1)) % two_n;
+        result[j] = poly_ntt[(exponent - 1) / 2];
+    }
+    return result;
+}
+
+uint64_t GaloisTool::rotation_elt(int step) const {
+    // 3 has order N/2 mod 2N, so steps are taken mod the row size
+    int row_size = N / 2;
+    step %= row_size;
+    if (step < 0) step += row_size;
+    
+    uint64_t two_n = 2 * (uint64_t)N;
+    uint64_t elt = 1;
+    for (int i = 0; i < step; i++) {
+        elt = (elt * 3) % two_n;
+    }
+    return elt;
+}
+
+std::vector<uint64_t> GaloisTool::sum_slots_elts() const {
+    std::vector<uint64_t> elts;
+    for (int step = 1; step < N / 2; step *= 2) {
+        elts.push_back(rotation_elt(step));
+    }
+    elts.push_back(column_swap_elt());
+    return elts;
+}
+
+GaloisKeys::GaloisKeys(const NTT& ntt,
+                       const std::map<uint64_t, std::vector<std::vector<ModInt>>>& keys) {
+    for (const auto& entry : keys) {
+        if (entry.second.empty() || entry.second.size() % 2 != 0) {
+            throw std::invalid_argument("Galois key must have two components per digit");
+        }
+        std::vector<std::vector<ModInt>> key = entry.second;
+        for (auto& comp : key) {
+            ntt.forward(comp);
+        }
+        keys_ntt[entry.first] = std::move(key);
+    }
+}
+
+const std::vector<std::vector<ModInt>>& GaloisKeys::get(uint64_t galois_elt) const {
+    auto it = keys_ntt.find(galois_elt);
+    if (it == keys_ntt.end()) {
+        throw std::invalid_argument("Missing Galois key for element " +
+                                    std::to_string(galois_elt));
+    }
+    return it->second;
+}
+
+std::vector<uint64_t> GaloisKeys::elements() const {
+    std::vector<uint64_t> elts;
+    for (const auto& entry : keys_ntt) {
+        elts.push_back(entry.first);
+    }
+    return elts;
+}
+
+} // namespace fhe_cpp
@@ -0,0 +1,65 @@
+/*
+ * Galois automorphisms X -> X^g for slot rotations
+ * Rotation keys are kept in NTT form so rotations can be hoisted
+ */
+
+#ifndef FHE_GALOIS_H
+#define FHE_GALOIS_H
+
+#include "ntt.h"
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace fhe_cpp {
+
+class GaloisTool {
+private:
+    int N;      // Polynomial degree
+    ModInt q;   // Modulus
+
+public:
+    GaloisTool(int N, ModInt q);
+    ~GaloisTool() = default;
+    
+    // Apply X -> X^g to a polynomial in coefficient form
+    std::vector<ModInt> apply(const std::vector<ModInt>& poly, uint64_t galois_elt) const;
+    
+    // Apply X -> X^g to a polynomial in NTT form (a pure permutation,
+    // since NTT index j holds the evaluation at psi^(2j+1))
+    std::vector<ModInt> apply_ntt(const std::vector<ModInt>& poly_ntt, uint64_t galois_elt) const;
+    
+    // Galois element rotating both slot rows left by step (3^step mod 2N)
+    uint64_t rotation_elt(int step) const;
+    
+    // Galois element swapping the two slot rows (2N - 1)
+    uint64_t column_swap_elt() const { return 2 * (uint64_t)N - 1; }
+    
+    // Elements needed to fold all N slots: 3^(2^i) for each row
+    // doubling step, followed by the column swap
+    std::vector<uint64_t> sum_slots_elts() const;
+};
+
+// Rotation (Galois) keys, stored in NTT form
+// Key for g holds one (b_j, a_j) per decomposition digit, flattened as
+// [b_0, a_0, b_1, a_1, ...], with b_j = -(a_j*s + e_j) + w^j * s(X^g)
+class GaloisKeys {
+private:
+    std::map<uint64_t, std::vector<std::vector<ModInt>>> keys_ntt;
+
+public:
+    GaloisKeys(const NTT& ntt,
+               const std::map<uint64_t, std::vector<std::vector<ModInt>>>& keys);
+    ~GaloisKeys() = default;
+    
+    bool has(uint64_t galois_elt) const { return keys_ntt.count(galois_elt) > 0; }
+    
+    // Key components in NTT form; throws if no key was generated for g
+    const std::vector<std::vector<ModInt>>& get(uint64_t galois_elt) const;
+    
+    std::vector<uint64_t> elements() const;
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_GALOIS_H
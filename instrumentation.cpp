@@ -0,0 +1,172 @@
+/*
+ * Instrumentation Implementation
+ */
+
+#include "instrumentation.h"
+#include <algorithm>
+#include <cmath>
+
+namespace fhe_cpp {
+
+namespace {
+
+// Log-linear buckets: values below 16 get their own bucket, larger values
+// are split into 16 sub-buckets per power of two (<= 6.25% relative error)
+const int kSubBits = 4;
+const int kSubBuckets = 1 << kSubBits;
+const int kBuckets = 64 * kSubBuckets;
+
+int bucket_of(uint64_t v) {
+    if (v < (uint64_t)kSubBuckets) return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    int sub = (int)((v >> (msb - kSubBits)) & (kSubBuckets - 1));
+    return (msb - kSubBits + 1) * kSubBuckets + sub;
+}
+
+uint64_t bucket_lower(int b) {
+    if (b < kSubBuckets) return (uint64_t)b;
+    int msb = b / kSubBuckets + kSubBits - 1;
+    uint64_t sub = (uint64_t)(b % kSubBuckets);
+    return (kSubBuckets + sub) << (msb - kSubBits);
+}
+
+struct Histogram {
+    std::atomic<uint64_t> buckets[kBuckets];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> min;
+    std::atomic<uint64_t> max;
+    
+    void clear() {
+        for (auto& b : buckets) b.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        min.store(UINT64_MAX, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+    
+    Histogram() { clear(); }
+    
+    void record(uint64_t v) {
+        buckets[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(v, std::memory_order_relaxed);
+        
+        uint64_t cur = min.load(std::memory_order_relaxed);
+        while (v < cur && !min.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+        cur = max.load(std::memory_order_relaxed);
+        while (v > cur && !max.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+    }
+    
+    LatencyStats stats() const {
+        LatencyStats s{};
+        uint64_t counts[kBuckets];
+        uint64_t n = 0;
+        for (int b = 0; b < kBuckets; b++) {
+            counts[b] = buckets[b].load(std::memory_order_relaxed);
+            n += counts[b];
+        }
+        s.count = n;
+        if (n == 0) return s;
+        
+        s.total_ns = (double)total.load(std::memory_order_relaxed);
+        s.min_ns = (double)min.load(std::memory_order_relaxed);
+        s.max_ns = (double)max.load(std::memory_order_relaxed);
+        s.mean_ns = s.total_ns / n;
+        
+        // Percentile = lower bound of the bucket holding that rank,
+        // clamped to the observed range
+        auto percentile = [&](double p) {
+            uint64_t rank = (uint64_t)std::ceil(p * n);
+            if (rank == 0) rank = 1;
+            uint64_t seen = 0;
+            for (int b = 0; b < kBuckets; b++) {
+                seen += counts[b];
+                if (seen >= rank) {
+                    double v = (double)bucket_lower(b);
+                    return std::min(std::max(v, s.min_ns), s.max_ns);
+                }
+            }
+            return s.max_ns;
+        };
+        s.p50_ns = percentile(0.50);
+        s.p90_ns = percentile(0.90);
+        s.p99_ns = percentile(0.99);
+        s.p999_ns = percentile(0.999);
+        return s;
+    }
+};
+
+std::atomic<uint64_t> counters[(int)Counter::Count];
+Histogram histograms[(int)OpKind::Count];
+
+} // namespace
+
+std::atomic<bool> Instrumentation::active(false);
+
+bool Instrumentation::compiled_in() {
+#ifdef FHE_ENABLE_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Instrumentation::count(Counter counter, uint64_t n) {
+    counters[(int)counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+void Instrumentation::record(OpKind op, uint64_t nanoseconds) {
+    histograms[(int)op].record(nanoseconds);
+}
+
+InstrumentationSnapshot Instrumentation::snapshot() {
+    InstrumentationSnapshot snap;
+    for (int c = 0; c < (int)Counter::Count; c++) {
+        snap.counters[name((Counter)c)] = counters[c].load(std::memory_order_relaxed);
+    }
+    for (int op = 0; op < (int)OpKind::Count; op++) {
+        LatencyStats s = histograms[op].stats();
+        if (s.count > 0) {
+            snap.ops[name((OpKind)op)] = s;
+        }
+    }
+    return snap;
+}
+
+void Instrumentation::reset() {
+    for (auto& c : counters) c.store(0, std::memory_order_relaxed);
+    for (auto& h : histograms) h.clear();
+}
+
+const char* Instrumentation::name(Counter counter) {
+    switch (counter) {
+        case Counter::NttForward: return "ntt_forward";
+        case Counter::NttInverse: return "ntt_inverse";
+        case Counter::PointwiseMultiply: return "pointwise_multiply";
+        case Counter::KeySwitch: return "key_switch";
+        case Counter::PolyAllocation: return "poly_allocation";
+        default: return "unknown";
+    }
+}
+
+const char* Instrumentation::name(OpKind op) {
+    switch (op) {
+        case OpKind::Multiply: return "multiply";
+        case OpKind::Relinearize: return "relinearize";
+        case OpKind::MultiplyPlain: return "multiply_plain";
+        case OpKind::Rotate: return "rotate";
+        case OpKind::SumSlots: return "sum_slots";
+        case OpKind::EvaluatePolynomial: return "evaluate_polynomial";
+        case OpKind::MatVec: return "matvec";
+        case OpKind::InnerProduct: return "inner_product";
+        case OpKind::Encode: return "encode";
+        case OpKind::Decode: return "decode";
+        case OpKind::Decrypt: return "decrypt";
+        case OpKind::ModSwitch: return "mod_switch";
+        case OpKind::TableScan: return "table_scan";
+        default: return "unknown";
+    }
+}
+
+} // namespace fhe_cpp
@@ -0,0 +1,124 @@
+/*
+ * Operation-level instrumentation
+ * Counters for the primitive kernels and log-linear (HDR-style) latency
+ * histograms for evaluator calls. Compiled in with FHE_ENABLE_INSTRUMENTATION
+ * and switched on at runtime; when off, each probe is one relaxed load
+ */
+
+#ifndef FHE_INSTRUMENTATION_H
+#define FHE_INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace fhe_cpp {
+
+// Primitive kernel counters
+enum class Counter : int {
+    NttForward,
+    NttInverse,
+    PointwiseMultiply,
+    KeySwitch,
+    PolyAllocation,
+    Count
+};
+
+// Timed evaluator operations
+enum class OpKind : int {
+    Multiply,
+    Relinearize,
+    MultiplyPlain,
+    Rotate,
+    SumSlots,
+    EvaluatePolynomial,
+    MatVec,
+    InnerProduct,
+    Encode,
+    Decode,
+    Decrypt,
+    ModSwitch,
+    TableScan,
+    Count
+};
+
+struct LatencyStats {
+    uint64_t count;
+    double total_ns;
+    double min_ns;
+    double max_ns;
+    double mean_ns;
+    double p50_ns;
+    double p90_ns;
+    double p99_ns;
+    double p999_ns;
+};
+
+struct InstrumentationSnapshot {
+    std::map<std::string, uint64_t> counters;
+    std::map<std::string, LatencyStats> ops;    // Only ops recorded at least once
+};
+
+class Instrumentation {
+private:
+    static std::atomic<bool> active;
+
+public:
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+    static void set_enabled(bool on) { active.store(on, std::memory_order_relaxed); }
+    
+    // Whether the probes were compiled in at all
+    static bool compiled_in();
+    
+    static void count(Counter counter, uint64_t n = 1);
+    static void record(OpKind op, uint64_t nanoseconds);
+    
+    static InstrumentationSnapshot snapshot();
+    static void reset();
+    
+    static const char* name(Counter counter);
+    static const char* name(OpKind op);
+};
+
+// Records the lifetime of a scope into op's histogram when enabled
+class ScopedOpTimer {
+private:
+    OpKind op;
+    bool on;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedOpTimer(OpKind op)
+        : op(op), on(Instrumentation::enabled()) {
+        if (on) start = std::chrono::steady_clock::now();
+    }
+    
+    ~ScopedOpTimer() {
+        if (on) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            Instrumentation::record(op, (uint64_t)std::chrono::duration_cast<
+                std::chrono::nanoseconds>(elapsed).count());
+        }
+    }
+    
+    ScopedOpTimer(const ScopedOpTimer&) = delete;
+    ScopedOpTimer& operator=(const ScopedOpTimer&) = delete;
+};
+
+} // namespace fhe_cpp
+
+#ifdef FHE_ENABLE_INSTRUMENTATION
+#define FHE_COUNT(counter, n) \
+    do { \
+        if (::fhe_cpp::Instrumentation::enabled()) \
+            ::fhe_cpp::Instrumentation::count(::fhe_cpp::Counter::counter, (n)); \
+    } while (0)
+#define FHE_TIME_OP(op) ::fhe_cpp::ScopedOpTimer fhe_op_timer_(::fhe_cpp::OpKind::op)
+#else
+#define FHE_COUNT(counter, n) do {} while (0)
+#define FHE_TIME_OP(op) do {} while (0)
+#endif
+
+#endif // FHE_INSTRUMENTATION_H
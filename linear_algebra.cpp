@@ -0,0 +1,228 @@
+/*
+ * Encrypted Linear Algebra Implementation
+ */
+
+#include "linear_algebra.h"
+#include "instrumentation.h"
+#include "thread_pool.h"
+
+namespace fhe_cpp {
+
+std::vector<ModInt> encode_coeff_vector(const std::vector<ModInt>& values, int N, ModInt t) {
+    if ((int)values.size() > N) {
+        throw std::invalid_argument("Vector longer than N");
+    }
+    
+    std::vector<ModInt> poly(N, 0);
+    for (size_t i = 0; i < values.size(); i++) {
+        ModInt v = values[i] % t;
+        poly[i] = v < 0 ? v + t : v;
+    }
+    return poly;
+}
+
+std::vector<ModInt> encode_coeff_reversed(const std::vector<ModInt>& values, int N, ModInt t) {
+    if ((int)values.size() > N) {
+        throw std::invalid_argument("Vector longer than N");
+    }
+    
+    // X^i * X^(N-i) = X^N = -1, so the negation cancels the wrap-around
+    std::vector<ModInt> poly(N, 0);
+    for (size_t i = 0; i < values.size(); i++) {
+        ModInt v = values[i] % t;
+        if (v < 0) v += t;
+        if (i == 0) {
+            poly[0] = v;
+        } else {
+            poly[N - i] = v == 0 ? 0 : t - v;
+        }
+    }
+    return poly;
+}
+
+CoeffInnerProduct::CoeffInnerProduct(const BFVMultiplier& mult,
+                                     const std::vector<std::vector<ModInt>>& vectors)
+    : mult(mult), q(mult.get_ntt().get_q()), t(mult.get_t()), N(mult.get_ntt().get_N()) {
+    
+    plains_ntt.reserve(vectors.size());
+    for (const auto& vec : vectors) {
+        std::vector<ModInt> poly = encode_coeff_reversed(vec, N, t);
+        
+        // Centered representatives keep the noise growth minimal
+        for (auto& v : poly) {
+            if (v > t / 2) v = v - t + q;
+        }
+        mult.get_ntt().forward(poly);
+        plains_ntt.push_back(std::move(poly));
+    }
+}
+
+std::vector<std::vector<ModInt>> CoeffInnerProduct::inner_product(
+    const std::vector<ModInt>& c0,
+    const std::vector<ModInt>& c1,
+    size_t k) const {
+    FHE_TIME_OP(InnerProduct);
+    
+    if (k >= plains_ntt.size()) {
+        throw std::out_of_range("No stored vector with that index");
+    }
+    
+    const NTT& ntt = mult.get_ntt();
+    std::vector<std::vector<ModInt>> result = {c0, c1};
+    for (auto& comp : result) {
+        ntt.forward(comp);
+        comp = ntt.pointwise_multiply(comp, plains_ntt[k]);
+        ntt.inverse(comp);
+    }
+    return result;
+}
+
+std::vector<std::vector<std::vector<ModInt>>> CoeffInnerProduct::inner_product_batch(
+    const std::vector<ModInt>& c0,
+    const std::vector<ModInt>& c1) const {
+    FHE_TIME_OP(InnerProduct);
+    
+    const NTT& ntt = mult.get_ntt();
+    std::vector<ModInt> c0_ntt = c0;
+    std::vector<ModInt> c1_ntt = c1;
+    ntt.forward(c0_ntt);
+    ntt.forward(c1_ntt);
+    
+    std::vector<std::vector<std::vector<ModInt>>> results(plains_ntt.size());
+    ThreadPool::global()->parallel_for(plains_ntt.size(), [&](size_t i) {
+        std::vector<ModInt> r0 = ntt.pointwise_multiply(c0_ntt, plains_ntt[i]);
+        std::vector<ModInt> r1 = ntt.pointwise_multiply(c1_ntt, plains_ntt[i]);
+        ntt.inverse(r0);
+        ntt.inverse(r1);
+        results[i] = {std::move(r0), std::move(r1)};
+    });
+    return results;
+}
+
+DiagonalMatrix::DiagonalMatrix(const BFVMultiplier& mult,
+                               const std::vector<std::vector<ModInt>>& matrix,
+                               const SlotEncoder& encode_slots)
+    : mult(mult), galois(mult.get_ntt().get_N(), mult.get_ntt().get_q()),
+      n((int)matrix.size()) {
+    
+    int N = mult.get_ntt().get_N();
+    ModInt q = mult.get_ntt().get_q();
+    ModInt t = mult.get_t();
+    
+    if (n == 0 || (n & (n - 1)) != 0 || n > N / 2) {
+        throw std::invalid_argument("Matrix dimension must be a power of 2 dividing N/2");
+    }
+    for (const auto& row : matrix) {
+        if ((int)row.size() != n) {
+            throw std::invalid_argument("Matrix must be square");
+        }
+    }
+    
+    // n1 ~ sqrt(n) baby steps, n2 = n / n1 giant steps
+    n1 = 1;
+    while (n1 * n1 < n) n1 *= 2;
+    n2 = n / n1;
+    
+    diags_ntt.resize(n);
+    for (int k = 0; k < n2; k++) {
+        for (int i = 0; i < n1; i++) {
+            int j = n1 * k + i;
+            int shift = n1 * k;
+            
+            // d_j[r] = M[r][(r + j) mod n], pre-rotated right by n1*k and
+            // replicated with period n across both slot rows
+            std::vector<ModInt> slots(N);
+            bool nonzero = false;
+            for (int s = 0; s < N; s++) {
+                int r = ((s - shift) % n + n) % n;
+                ModInt v = matrix[r][(r + j) % n] % t;
+                slots[s] = v < 0 ? v + t : v;
+                nonzero |= (slots[s] != 0);
+            }
+            if (!nonzero) continue;
+            
+            std::vector<ModInt> poly = encode_slots(slots);
+            if ((int)poly.size() != N) {
+                throw std::invalid_argument("Slot encoder must return N coefficients");
+            }
+            for (auto& v : poly) {
+                v %= t;
+                if (v < 0) v += t;
+                if (v > t / 2) v = v - t + q;
+            }
+            mult.get_ntt().forward(poly);
+            diags_ntt[j] = std::move(poly);
+        }
+    }
+}
+
+DiagonalMatrix::DiagonalMatrix(const BFVMultiplier& mult,
+                               const std::vector<std::vector<ModInt>>& matrix,
+                               const BatchEncoder& encoder)
+    : DiagonalMatrix(mult, matrix, [&encoder](const std::vector<ModInt>& slots) {
+          return encoder.encode(slots);
+      }) {}
+
+std::vector<uint64_t> DiagonalMatrix::required_galois_elts() const {
+    std::vector<uint64_t> elts;
+    for (int i = 1; i < n1; i++) {
+        elts.push_back(galois.rotation_elt(i));
+    }
+    for (int k = 1; k < n2; k++) {
+        elts.push_back(galois.rotation_elt(n1 * k));
+    }
+    return elts;
+}
+
+std::vector<std::vector<ModInt>> DiagonalMatrix::multiply(
+    const std::vector<ModInt>& c0,
+    const std::vector<ModInt>& c1,
+    const GaloisKeys& galois_keys) const {
+    FHE_TIME_OP(MatVec);
+    
+    const NTT& ntt = mult.get_ntt();
+    int N = ntt.get_N();
+    if (c0.size() != (size_t)N || c1.size() != (size_t)N) {
+        throw std::invalid_argument("All ciphertext components must have size N");
+    }
+    
+    // Hoisted baby steps: c1 is decomposed and transformed once, then each
+    // rotation is a permutation of its digits plus a pointwise key switch
+    std::vector<std::vector<std::vector<ModInt>>> baby(n1);
+    baby[0] = {c0, c1};
+    for (auto& comp : baby[0]) {
+        ntt.forward(comp);
+    }
+    std::vector<std::vector<ModInt>> c1_digits = mult.decompose_ntt(c1);
+    for (int i = 1; i < n1; i++) {
+        baby[i] = mult.rotate_digits_ntt(baby[0][0], c1_digits, galois.rotation_elt(i), galois_keys);
+    }
+    
+    std::vector<std::vector<ModInt>> result(2, std::vector<ModInt>(N, 0));
+    for (int k = 0; k < n2; k++) {
+        // Inner sum over the baby steps, pointwise in NTT form
+        std::vector<std::vector<ModInt>> inner(2, std::vector<ModInt>(N, 0));
+        bool any = false;
+        for (int i = 0; i < n1; i++) {
+            const auto& diag = diags_ntt[n1 * k + i];
+            if (diag.empty()) continue;
+            for (int comp = 0; comp < 2; comp++) {
+                inner[comp] = ntt.add(inner[comp], ntt.pointwise_multiply(baby[i][comp], diag));
+            }
+            any = true;
+        }
+        if (!any) continue;
+        
+        if (k > 0) {
+            inner = mult.rotate_ntt(inner, galois.rotation_elt(n1 * k), galois_keys);
+        }
+        result[0] = ntt.add(result[0], inner[0]);
+        result[1] = ntt.add(result[1], inner[1]);
+    }
+    
+    ntt.inverse(result[0]);
+    ntt.inverse(result[1]);
+    return result;
+}
+
+} // namespace fhe_cpp
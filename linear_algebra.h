@@ -0,0 +1,106 @@
+/*
+ * Encrypted linear algebra
+ * Inner products in coefficient encoding (no rotations, no key switching)
+ * and matrix-vector products in slot encoding (diagonal method)
+ */
+
+#ifndef FHE_LINEAR_ALGEBRA_H
+#define FHE_LINEAR_ALGEBRA_H
+
+#include "bfv_mult.h"
+#include "galois.h"
+#include "batch_encoder.h"
+#include <vector>
+#include <functional>
+
+namespace fhe_cpp {
+
+// a(X) = sum v_i X^i, coefficients reduced into Z_t
+std::vector<ModInt> encode_coeff_vector(const std::vector<ModInt>& values, int N, ModInt t);
+
+// Reversed negacyclic encoding b(X) = w_0 - sum_{i>0} w_i X^(N-i), chosen so
+// that the constant coefficient of a(X) * b(X) mod X^N + 1 is <v, w>
+std::vector<ModInt> encode_coeff_reversed(const std::vector<ModInt>& values, int N, ModInt t);
+
+class CoeffInnerProduct {
+private:
+    const BFVMultiplier& mult;
+    ModInt q;
+    ModInt t;
+    int N;
+    
+    // Reversed encodings of the plaintext vectors, centered mod q, NTT form
+    std::vector<std::vector<ModInt>> plains_ntt;
+
+public:
+    CoeffInnerProduct(const BFVMultiplier& mult,
+                      const std::vector<std::vector<ModInt>>& vectors);
+    ~CoeffInnerProduct() = default;
+    
+    // <v, w_k> in coefficient 0 for one stored vector (other coefficients
+    // hold cross terms and should be ignored or masked)
+    std::vector<std::vector<ModInt>> inner_product(
+        const std::vector<ModInt>& c0,
+        const std::vector<ModInt>& c1,
+        size_t k
+    ) const;
+    
+    // <v, w_k> for every stored vector; the ciphertext is transformed once
+    // and each vector then costs two pointwise products and two inverse NTTs
+    std::vector<std::vector<std::vector<ModInt>>> inner_product_batch(
+        const std::vector<ModInt>& c0,
+        const std::vector<ModInt>& c1
+    ) const;
+    
+    size_t size() const { return plains_ntt.size(); }
+};
+
+// Maps N slot values (row 0, then row 1) to a plaintext polynomial
+typedef std::function<std::vector<ModInt>(const std::vector<ModInt>&)> SlotEncoder;
+
+// Plaintext n x n matrix for encrypted matrix-vector products using the
+// Halevi-Shoup diagonal method with baby-step/giant-step rotations:
+// M v = sum_k rot_{n1 k}( sum_i rot_{-n1 k}(d_{n1 k + i}) * rot_i(v) )
+// needs n1 - 1 + n2 - 1 ~ 2 sqrt(n) rotations instead of n - 1
+class DiagonalMatrix {
+private:
+    const BFVMultiplier& mult;
+    GaloisTool galois;
+    int n;      // Matrix dimension (power of two dividing N/2)
+    int n1;     // Baby steps
+    int n2;     // Giant steps
+    
+    // Pre-rotated diagonals, centered mod q, in NTT form, index n1*k + i
+    // (empty for all-zero diagonals, which are skipped)
+    std::vector<std::vector<ModInt>> diags_ntt;
+
+public:
+    // The vector must be encoded with period n in both slot rows, i.e.
+    // slot s holds v[s mod n]
+    DiagonalMatrix(const BFVMultiplier& mult,
+                   const std::vector<std::vector<ModInt>>& matrix,
+                   const SlotEncoder& encode_slots);
+    DiagonalMatrix(const BFVMultiplier& mult,
+                   const std::vector<std::vector<ModInt>>& matrix,
+                   const BatchEncoder& encoder);
+    ~DiagonalMatrix() = default;
+    
+    // Encrypted M v (slot s holds (M v)[s mod n]), computed in NTT form:
+    // baby steps are hoisted rotations of one transformed input
+    std::vector<std::vector<ModInt>> multiply(
+        const std::vector<ModInt>& c0,
+        const std::vector<ModInt>& c1,
+        const GaloisKeys& galois_keys
+    ) const;
+    
+    // Galois elements for the baby-step and giant-step rotations
+    std::vector<uint64_t> required_galois_elts() const;
+    
+    int get_n() const { return n; }
+    int get_baby_steps() const { return n1; }
+    int get_giant_steps() const { return n2; }
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_LINEAR_ALGEBRA_H
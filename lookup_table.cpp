@@ -0,0 +1,101 @@
+/*
+ * Lookup Table Implementation
+ * O(n^2) Newton interpolation, done once per table
+ */
+
+#include "lookup_table.h"
+
+namespace fhe_cpp {
+
+LookupTable::LookupTable(const std::vector<ModInt>& table, ModInt t)
+    : t(t), table(table.size()) {
+    
+    if (table.empty()) {
+        throw std::invalid_argument("Lookup table must not be empty");
+    }
+    if ((ModInt)table.size() > t) {
+        throw std::invalid_argument("Lookup table cannot have more than t entries");
+    }
+    
+    for (size_t i = 0; i < table.size(); i++) {
+        ModInt v = table[i] % t;
+        this->table[i] = v < 0 ? v + t : v;
+    }
+    
+    interpolate();
+}
+
+ModInt LookupTable::mod_mul(ModInt a, ModInt b) const {
+    __int128 result = ((__int128)a * (__int128)b) % t;
+    if (result < 0) result += t;
+    return (ModInt)result;
+}
+
+ModInt LookupTable::mod_inv(ModInt a) const {
+    // t is prime, so a^(t-2) is the inverse
+    ModInt result = 1;
+    ModInt base = a % t;
+    ModInt exp = t - 2;
+    while (exp > 0) {
+        if (exp & 1) result = mod_mul(result, base);
+        base = mod_mul(base, base);
+        exp >>= 1;
+    }
+    return result;
+}
+
+void LookupTable::interpolate() {
+    size_t n = table.size();
+    
+    // Forward differences: on the points 0..n-1 the Newton divided
+    // differences are Delta^j f(0) / j!, so only additions are needed
+    std::vector<ModInt> diff = table;
+    std::vector<ModInt> newton(n);
+    newton[0] = diff[0];
+    for (size_t j = 1; j < n; j++) {
+        for (size_t i = 0; i + j < n; i++) {
+            ModInt d = diff[i + 1] - diff[i];
+            diff[i] = d < 0 ? d + t : d;
+        }
+        newton[j] = diff[0];
+    }
+    
+    ModInt factorial = 1;
+    for (size_t j = 1; j < n; j++) {
+        factorial = mod_mul(factorial, (ModInt)j);
+        newton[j] = mod_mul(newton[j], mod_inv(factorial));
+    }
+    
+    // Expand the Newton form prod_{i<j} (x - i) into monomials with
+    // Horner's rule: p = newton[n-1]; p = p * (x - j) + newton[j]
+    coeffs.assign(n, 0);
+    coeffs[0] = newton[n - 1];
+    size_t len = 1;
+    for (size_t jj = n - 1; jj-- > 0;) {
+        ModInt neg_j = (t - (ModInt)(jj % t)) % t;
+        // Multiply by x: shift up; multiply by -j: scale and add
+        coeffs[len] = coeffs[len - 1];
+        for (size_t i = len - 1; i > 0; i--) {
+            coeffs[i] = (coeffs[i - 1] + mod_mul(coeffs[i], neg_j)) % t;
+        }
+        coeffs[0] = (mod_mul(coeffs[0], neg_j) + newton[jj]) % t;
+        len++;
+    }
+    
+    while (coeffs.size() > 1 && coeffs.back() == 0) {
+        coeffs.pop_back();
+    }
+}
+
+ModInt LookupTable::evaluate(ModInt x) const {
+    x %= t;
+    if (x < 0) x += t;
+    
+    ModInt result = 0;
+    for (size_t i = coeffs.size(); i-- > 0;) {
+        result = (mod_mul(result, x) + coeffs[i]) % t;
+    }
+    return result;
+}
+
+} // namespace fhe_cpp
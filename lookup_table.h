@@ -0,0 +1,44 @@
+/*
+ * Lookup tables over Z_t
+ * Interpolates a table once so it can be evaluated homomorphically
+ */
+
+#ifndef FHE_LOOKUP_TABLE_H
+#define FHE_LOOKUP_TABLE_H
+
+#include "ntt.h"
+#include <vector>
+
+namespace fhe_cpp {
+
+class LookupTable {
+private:
+    ModInt t;                        // Plaintext modulus (prime)
+    std::vector<ModInt> table;       // table[i] = f(i) mod t
+    std::vector<ModInt> coeffs;      // Interpolating polynomial, lowest degree first
+    
+    ModInt mod_mul(ModInt a, ModInt b) const;
+    ModInt mod_inv(ModInt a) const;
+    
+    // Newton interpolation over the consecutive points 0..n-1
+    void interpolate();
+
+public:
+    // Interpolate f over the domain {0, ..., table.size() - 1}
+    // Inputs outside the domain map to unspecified values
+    LookupTable(const std::vector<ModInt>& table, ModInt t);
+    ~LookupTable() = default;
+    
+    // Evaluate the interpolated polynomial in the clear (for testing)
+    ModInt evaluate(ModInt x) const;
+    
+    // Getters
+    const std::vector<ModInt>& get_coefficients() const { return coeffs; }
+    const std::vector<ModInt>& get_table() const { return table; }
+    size_t size() const { return table.size(); }
+    ModInt get_t() const { return t; }
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_LOOKUP_TABLE_H
@@ -0,0 +1,108 @@
+/*
+ * Modulus Switching Implementation
+ */
+
+#include "modulus_switch.h"
+#include "instrumentation.h"
+#include "trace.h"
+
+namespace fhe_cpp {
+
+std::vector<std::vector<ModInt>> mod_switch(
+    const std::vector<std::vector<ModInt>>& ct,
+    ModInt q_from,
+    ModInt q_to) {
+    FHE_TIME_OP(ModSwitch);
+    FHE_TRACE_SPAN("mod_switch", "modswitch");
+    
+    if (q_to < 2 || q_to > q_from) {
+        throw std::invalid_argument("Target modulus must lie in [2, q]");
+    }
+    
+    std::vector<std::vector<ModInt>> result;
+    result.reserve(ct.size());
+    for (const auto& comp : ct) {
+        std::vector<ModInt> out(comp.size());
+        for (size_t i = 0; i < comp.size(); i++) {
+            ModInt c = comp[i] % q_from;
+            if (c < 0) c += q_from;
+            
+            // floor((q_to * c + q_from/2) / q_from), exactly in 128 bits
+            __int128 num = (__int128)q_to * c + q_from / 2;
+            out[i] = (ModInt)(num / q_from) % q_to;
+        }
+        result.push_back(std::move(out));
+    }
+    return result;
+}
+
+int coefficient_bits(ModInt q) {
+    int bits = 0;
+    while (bits < 63 && ((ModInt)1 << bits) < q) bits++;
+    return bits;
+}
+
+std::vector<uint8_t> pack_ciphertext(const std::vector<std::vector<ModInt>>& ct, ModInt q) {
+    FHE_TRACE_SPAN("pack_ciphertext", "io");
+    int bits = coefficient_bits(q);
+    size_t count = 0;
+    for (const auto& comp : ct) count += comp.size();
+    
+    std::vector<uint8_t> data;
+    data.reserve((count * bits + 7) / 8);
+    
+    // Bit accumulator: append each value above the pending bits and
+    // flush whole bytes
+    unsigned __int128 acc = 0;
+    int pending = 0;
+    for (const auto& comp : ct) {
+        for (ModInt v : comp) {
+            ModInt r = v % q;
+            acc |= (unsigned __int128)(UModInt)(r < 0 ? r + q : r) << pending;
+            pending += bits;
+            while (pending >= 8) {
+                data.push_back((uint8_t)acc);
+                acc >>= 8;
+                pending -= 8;
+            }
+        }
+    }
+    if (pending > 0) {
+        data.push_back((uint8_t)acc);
+    }
+    return data;
+}
+
+std::vector<std::vector<ModInt>> unpack_ciphertext(
+    const std::vector<uint8_t>& data,
+    int N,
+    int num_components,
+    ModInt q) {
+    FHE_TRACE_SPAN("unpack_ciphertext", "io");
+    
+    int bits = coefficient_bits(q);
+    if (data.size() * 8 < (size_t)N * num_components * bits) {
+        throw std::invalid_argument("Packed data is too short for this shape");
+    }
+    
+    UModInt mask = ((UModInt)1 << bits) - 1;
+    std::vector<std::vector<ModInt>> ct(num_components, std::vector<ModInt>(N));
+    
+    unsigned __int128 acc = 0;
+    int pending = 0;
+    size_t next = 0;
+    for (auto& comp : ct) {
+        for (auto& v : comp) {
+            while (pending < bits) {
+                acc |= (unsigned __int128)data[next++] << pending;
+                pending += 8;
+            }
+            v = (ModInt)((UModInt)acc & mask);
+            acc >>= bits;
+            pending -= bits;
+        }
+    }
+    return ct;
+}
+
+} // namespace fhe_cpp
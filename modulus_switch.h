@@ -0,0 +1,37 @@
+/*
+ * Modulus switching and compact ciphertext serialization
+ * Scales a ciphertext from q to a smaller q' with exact rounding, so the
+ * result can be packed at ceil(log2 q') bits per coefficient
+ */
+
+#ifndef FHE_MODULUS_SWITCH_H
+#define FHE_MODULUS_SWITCH_H
+
+#include "ntt.h"
+#include <vector>
+#include <cstdint>
+
+namespace fhe_cpp {
+
+// c' = round(q_to / q_from * c) mod q_to, component-wise
+std::vector<std::vector<ModInt>> mod_switch(
+    const std::vector<std::vector<ModInt>>& ct,
+    ModInt q_from,
+    ModInt q_to);
+
+// Bits needed per coefficient mod q
+int coefficient_bits(ModInt q);
+
+// Pack every component at coefficient_bits(q) bits per coefficient,
+// little-endian bit order
+std::vector<uint8_t> pack_ciphertext(const std::vector<std::vector<ModInt>>& ct, ModInt q);
+
+std::vector<std::vector<ModInt>> unpack_ciphertext(
+    const std::vector<uint8_t>& data,
+    int N,
+    int num_components,
+    ModInt q);
+
+} // namespace fhe_cpp
+
+#endif // FHE_MODULUS_SWITCH_H
@@ -0,0 +1,77 @@
+/*
+ * Noise Model Implementation
+ */
+
+#include "noise.h"
+#include <cmath>
+#include <algorithm>
+
+namespace fhe_cpp {
+
+NoiseModel::NoiseModel(int N, ModInt q, ModInt t, double sigma, int decomp_bits)
+    : NoiseModel(N, (double)q, (double)t, (double)(q % std::max<ModInt>(t, 1)),
+                 sigma, decomp_bits) {}
+
+NoiseModel NoiseModel::from_log_q(int N, double log_q, ModInt t,
+                                  double sigma, int decomp_bits) {
+    return NoiseModel(N, std::exp2(log_q), (double)t, (double)(t - 1), sigma, decomp_bits);
+}
+
+NoiseModel::NoiseModel(int N, double q, double t, double r_t, double sigma, int decomp_bits)
+    : q(q), t(t), r_t(r_t), bound(6 * sigma), expansion(2 * std::sqrt((double)N)) {
+    
+    if (N <= 0 || t < 2 || t >= q) {
+        throw std::invalid_argument("Invalid parameters for the noise model");
+    }
+    if (decomp_bits < 0) {
+        throw std::invalid_argument("Decomposition base must be non-negative");
+    }
+    
+    // l digits of size w: e_ks = l * delta_R * (w/2) * B
+    double log_q = std::log2(q);
+    double w_bits = (decomp_bits == 0 || decomp_bits > log_q) ? log_q : decomp_bits;
+    double digits = std::ceil(log_q / w_bits);
+    key_switch = t / q * digits * expansion * std::exp2(w_bits - 1) * bound;
+}
+
+double NoiseModel::fresh() const {
+    double e = bound * (1 + 2 * expansion);
+    return t / q * e + r_t * t / q;
+}
+
+double NoiseModel::add_plain(double v) const {
+    return v + r_t * t / q;
+}
+
+double NoiseModel::multiply_plain(double v, double plain_norm) const {
+    if (plain_norm < 0) plain_norm = t / 2;
+    return v * expansion * plain_norm;
+}
+
+double NoiseModel::multiply(double v1, double v2) const {
+    // Noise terms carried through the tensor product, plus the rounding
+    // of t/q * (d0, d1, d2)
+    double carried = t * expansion * (1 + expansion) * (v1 + v2);
+    double rounding = t / q * (1 + expansion + expansion * expansion);
+    return carried + rounding;
+}
+
+double NoiseModel::mod_switch(double v, double q_to) const {
+    return v + t / q_to * (0.5 + expansion);
+}
+
+int NoiseModel::min_modulus_bits(double v, double min_budget) const {
+    int max_bits = (int)std::ceil(std::log2(q));
+    for (int bits = (int)std::ceil(std::log2(t)) + 1; bits < max_bits; bits++) {
+        if (budget(mod_switch(v, std::exp2(bits))) >= min_budget) return bits;
+    }
+    return max_bits;
+}
+
+double NoiseModel::budget(double v) const {
+    if (v <= 0) return std::log2(q) - 1;
+    double bits = -std::log2(2 * v);
+    return bits > 0 ? bits : 0;
+}
+
+} // namespace fhe_cpp
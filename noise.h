@@ -0,0 +1,69 @@
+/*
+ * Analytical noise estimates
+ * Tracks a heuristic bound on the invariant noise v of a ciphertext, where
+ * t/q * (c0 + c1*s) = m + v (mod t); decryption is correct while |v| < 1/2.
+ * Ring products are bounded with the expansion factor 2*sqrt(N)
+ */
+
+#ifndef FHE_NOISE_H
+#define FHE_NOISE_H
+
+#include "ntt.h"
+
+namespace fhe_cpp {
+
+class NoiseModel {
+private:
+    double q;           // Ciphertext modulus
+    double t;           // Plaintext modulus
+    double r_t;         // q mod t (rounding of Delta)
+    double bound;       // Error bound (6 sigma)
+    double expansion;   // delta_R = 2*sqrt(N)
+    double key_switch;  // Invariant noise added by one key switch
+    
+    NoiseModel(int N, double q, double t, double r_t, double sigma, int decomp_bits);
+
+public:
+    // decomp_bits is the key-switching decomposition base in bits;
+    // 0 means no decomposition (a single digit of size q)
+    NoiseModel(int N, ModInt q, ModInt t, double sigma = 3.2, int decomp_bits = 0);
+    ~NoiseModel() = default;
+    
+    // Model for a modulus given only by its size (may exceed 64 bits, e.g.
+    // a product of primes), assuming the worst case q mod t = t - 1
+    static NoiseModel from_log_q(int N, double log_q, ModInt t,
+                                 double sigma = 3.2, int decomp_bits = 0);
+    
+    // Public-key encryption: e_pk*u + e1 + e2*s, plus Delta rounding
+    double fresh() const;
+    
+    double add(double v1, double v2) const { return v1 + v2; }
+    double add_plain(double v) const;
+    
+    // plain_norm bounds the centered plaintext coefficients (t/2 if < 0)
+    double multiply_plain(double v, double plain_norm = -1) const;
+    
+    // Constant multiplier: no ring expansion
+    double multiply_scalar(double v, double scalar_norm) const { return v * scalar_norm; }
+    
+    // Tensor product and t/q rescaling of two ciphertexts
+    double multiply(double v1, double v2) const;
+    
+    // Relinearization and rotations both add one key switch
+    double relinearize(double v) const { return v + key_switch; }
+    double rotate(double v) const { return v + key_switch; }
+    
+    // Switching to a modulus q_to adds the rounding errors e0 + e1*s,
+    // |e_i| <= 1/2: t/q_to * (1/2 + delta_R)
+    double mod_switch(double v, double q_to) const;
+    
+    // Smallest log2(q_to) that keeps min_budget bits after mod_switch
+    int min_modulus_bits(double v, double min_budget = 1.0) const;
+    
+    // Bits of budget left for invariant noise v (0 when exhausted)
+    double budget(double v) const;
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_NOISE_H
@@ -4,6 +4,11 @@
  */
 
 #include "ntt.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include "ntt_tuning.h"
+#include "thread_pool.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
@@ -24,7 +29,24 @@ ModInt extended_gcd(ModInt a, ModInt b, ModInt& x, ModInt& y) {
     return gcd;
 }
 
-NTT::NTT(int N, ModInt q) : N(N), q(q) {
+const char* ntt_variant_name(NttVariant variant) {
+    switch (variant) {
+        case NttVariant::Auto: return "auto";
+        case NttVariant::Reference: return "reference";
+        case NttVariant::Merged: return "merged";
+        case NttVariant::MergedShoup: return "merged_shoup";
+        default: return "unknown";
+    }
+}
+
+NttVariant parse_ntt_variant(const std::string& name) {
+    for (int v = 0; v < (int)NttVariant::Count; v++) {
+        if (name == ntt_variant_name((NttVariant)v)) return (NttVariant)v;
+    }
+    throw std::invalid_argument("Unknown NTT variant: " + name);
+}
+
+NTT::NTT(int N, ModInt q, NttVariant variant) : N(N), q(q), variant(variant) {
     // Verify N is a power of 2
     if ((N & (N - 1)) != 0) {
         throw std::invalid_argument("N must be a power of 2");
@@ -58,6 +80,29 @@ NTT::NTT(int N, ModInt q) : N(N), q(q) {
         psi_powers[i] = mod_mul(psi_powers[i-1], psi);
         psi_inv_powers[i] = mod_mul(psi_inv_powers[i-1], psi_inv);
     }
+    
+    // Bit-reversed twiddles for the merged kernels
+    int log_n = 0;
+    while ((1 << log_n) < N) log_n++;
+    psi_rev.resize(N);
+    psi_inv_rev.resize(N);
+    psi_rev_shoup.resize(N);
+    psi_inv_rev_shoup.resize(N);
+    for (int i = 0; i < N; i++) {
+        int r = bit_reverse(i, log_n);
+        psi_rev[i] = (UModInt)psi_powers[r];
+        psi_inv_rev[i] = (UModInt)psi_inv_powers[r];
+        psi_rev_shoup[i] = (UModInt)(((unsigned __int128)psi_rev[i] << 64) / (UModInt)q);
+        psi_inv_rev_shoup[i] = (UModInt)(((unsigned __int128)psi_inv_rev[i] << 64) / (UModInt)q);
+    }
+    N_inv_shoup = (UModInt)(((unsigned __int128)(UModInt)N_inv << 64) / (UModInt)q);
+    
+    int bits = 0;
+    while (bits < 63 && ((ModInt)1 << bits) <= q) bits++;
+    if (this->variant == NttVariant::Auto) {
+        this->variant = NttTuner::select(N, bits);
+    }
+    parallel_batch = (size_t)NttTuner::parallel_threshold(N, bits);
 }
 
 ModInt NTT::mod_add(ModInt a, ModInt b) const {
@@ -158,10 +203,58 @@ void NTT::bit_reverse_copy(std::vector<ModInt>& a) const {
 }
 
 void NTT::forward(std::vector<ModInt>& a) const {
-    if (a.size() != N) {
+    FHE_COUNT(NttForward, 1);
+    FHE_TRACE_SPAN("ntt_forward", "ntt");
+    FHE_PERF_SCOPE(NttForward, N);
+    if (a.size() != (size_t)N) {
         throw std::invalid_argument("Input size must equal N");
     }
     
+    switch (variant) {
+        case NttVariant::Merged: forward_merged<false>(a); break;
+        case NttVariant::MergedShoup: forward_merged<true>(a); break;
+        default: forward_reference(a); break;
+    }
+}
+
+void NTT::inverse(std::vector<ModInt>& a) const {
+    FHE_COUNT(NttInverse, 1);
+    FHE_TRACE_SPAN("ntt_inverse", "ntt");
+    FHE_PERF_SCOPE(NttInverse, N);
+    if (a.size() != (size_t)N) {
+        throw std::invalid_argument("Input size must equal N");
+    }
+    
+    switch (variant) {
+        case NttVariant::Merged: inverse_merged<false>(a); break;
+        case NttVariant::MergedShoup: inverse_merged<true>(a); break;
+        default: inverse_reference(a); break;
+    }
+}
+
+void NTT::forward_batch(std::vector<std::vector<ModInt>>& polys) const {
+    if (polys.size() < parallel_batch) {
+        for (auto& p : polys) forward(p);
+        return;
+    }
+    ThreadPool::global()->parallel_for(polys.size(), [&](size_t i) { forward(polys[i]); });
+}
+
+void NTT::inverse_batch(std::vector<std::vector<ModInt>>& polys) const {
+    if (polys.size() < parallel_batch) {
+        for (auto& p : polys) inverse(p);
+        return;
+    }
+    ThreadPool::global()->parallel_for(polys.size(), [&](size_t i) { inverse(polys[i]); });
+}
+
+void NTT::forward_reference(std::vector<ModInt>& a) const {
+    // Twist by psi^i so the cyclic transform below becomes negacyclic
+    // (reduction by X^N + 1 instead of X^N - 1)
+    for (int i = 0; i < N; i++) {
+        a[i] = mod_mul(a[i], psi_powers[i]);
+    }
+    
     // Cooley-Tukey NTT algorithm
     bit_reverse_copy(a);
     
@@ -169,8 +262,8 @@ void NTT::forward(std::vector<ModInt>& a) const {
         int m = 1 << s;
         int m2 = m >> 1;
         
-        // Root of unity for this stage
-        ModInt omega = psi_powers[N / m];
+        // Primitive m-th root of unity for this stage: (psi^2)^(N/m)
+        ModInt omega = mod_exp(psi, (2 * N) / m);
         
         for (int k = 0; k < N; k += m) {
             ModInt omega_power = 1;
@@ -188,11 +281,7 @@ void NTT::forward(std::vector<ModInt>& a) const {
     }
 }
 
-void NTT::inverse(std::vector<ModInt>& a) const {
-    if (a.size() != N) {
-        throw std::invalid_argument("Input size must equal N");
-    }
-    
+void NTT::inverse_reference(std::vector<ModInt>& a) const {
     // Similar to forward, but with inverse roots
     bit_reverse_copy(a);
     
@@ -200,7 +289,7 @@ void NTT::inverse(std::vector<ModInt>& a) const {
         int m = 1 << s;
         int m2 = m >> 1;
         
-        ModInt omega = psi_inv_powers[N / m];
+        ModInt omega = mod_exp(psi_inv, (2 * N) / m);
         
         for (int k = 0; k < N; k += m) {
             ModInt omega_power = 1;
@@ -217,15 +306,100 @@ void NTT::inverse(std::vector<ModInt>& a) const {
         }
     }
     
-    // Scale by 1/N
+    // Scale by 1/N and undo the psi^i twist
     for (int i = 0; i < N; i++) {
-        a[i] = mod_mul(a[i], N_inv);
+        a[i] = mod_mul(mod_mul(a[i], N_inv), psi_inv_powers[i]);
+    }
+}
+
+namespace {
+
+// w * a mod q for a, w < q; Shoup multiplication with w_shoup =
+// floor(w * 2^64 / q) replaces the 128-bit division by a high product
+template <bool Shoup>
+inline UModInt twiddle_mul(UModInt a, UModInt w, UModInt w_shoup, UModInt q) {
+    if (Shoup) {
+        UModInt hi = (UModInt)(((unsigned __int128)a * w_shoup) >> 64);
+        UModInt r = a * w - hi * q;
+        return r >= q ? r - q : r;
+    }
+    return (UModInt)(((unsigned __int128)a * w) % q);
+}
+
+} // namespace
+
+void NTT::reduce(std::vector<ModInt>& a) const {
+    for (auto& v : a) {
+        if (v < 0 || v >= q) {
+            v %= q;
+            if (v < 0) v += q;
+        }
+    }
+}
+
+template <bool Shoup>
+void NTT::forward_merged(std::vector<ModInt>& a) const {
+    // Cooley-Tukey with the psi twist folded into bit-reversed twiddles;
+    // the output comes out bit-reversed and is permuted back at the end
+    UModInt uq = (UModInt)q;
+    reduce(a);
+    UModInt* x = reinterpret_cast<UModInt*>(a.data());
+    
+    int t = N;
+    for (int m = 1; m < N; m <<= 1) {
+        t >>= 1;
+        for (int i = 0; i < m; i++) {
+            UModInt w = psi_rev[m + i];
+            UModInt w_shoup = psi_rev_shoup[m + i];
+            UModInt* lo = x + 2 * i * t;
+            UModInt* hi = lo + t;
+            for (int j = 0; j < t; j++) {
+                UModInt u = lo[j];
+                UModInt v = twiddle_mul<Shoup>(hi[j], w, w_shoup, uq);
+                UModInt sum = u + v;
+                lo[j] = sum >= uq ? sum - uq : sum;
+                hi[j] = u >= v ? u - v : u + uq - v;
+            }
+        }
+    }
+    bit_reverse_copy(a);
+}
+
+template <bool Shoup>
+void NTT::inverse_merged(std::vector<ModInt>& a) const {
+    // Gentleman-Sande on bit-reversed input, untwisting as it goes
+    reduce(a);
+    bit_reverse_copy(a);
+    UModInt uq = (UModInt)q;
+    UModInt* x = reinterpret_cast<UModInt*>(a.data());
+    
+    int t = 1;
+    for (int m = N; m > 1; m >>= 1) {
+        int h = m >> 1;
+        for (int i = 0; i < h; i++) {
+            UModInt w = psi_inv_rev[h + i];
+            UModInt w_shoup = psi_inv_rev_shoup[h + i];
+            UModInt* lo = x + 2 * i * t;
+            UModInt* hi = lo + t;
+            for (int j = 0; j < t; j++) {
+                UModInt u = lo[j];
+                UModInt v = hi[j];
+                UModInt sum = u + v;
+                lo[j] = sum >= uq ? sum - uq : sum;
+                hi[j] = twiddle_mul<Shoup>(u >= v ? u - v : u + uq - v, w, w_shoup, uq);
+            }
+        }
+        t <<= 1;
+    }
+    
+    for (int i = 0; i < N; i++) {
+        x[i] = twiddle_mul<Shoup>(x[i], (UModInt)N_inv, N_inv_shoup, uq);
     }
 }
 
 std::vector<ModInt> NTT::multiply(const std::vector<ModInt>& a,
                                    const std::vector<ModInt>& b) const {
-    if (a.size() != N || b.size() != N) {
+    if (a.size() != (size_t)N || b.size() != (size_t)N) {
         throw std::invalid_argument("Input sizes must equal N");
     }
     
@@ -238,10 +412,7 @@ std::vector<ModInt> NTT::multiply(const std::vector<ModInt>& a,
     forward(b_ntt);
     
     // Pointwise multiplication in NTT domain
-    std::vector<ModInt> c_ntt(N);
-    for (int i = 0; i < N; i++) {
-        c_ntt[i] = mod_mul(a_ntt[i], b_ntt[i]);
-    }
+    std::vector<ModInt> c_ntt = pointwise_multiply(a_ntt, b_ntt);
     
     // Transform back
     inverse(c_ntt);
@@ -249,8 +420,25 @@ std::vector<ModInt> NTT::multiply(const std::vector<ModInt>& a,
     return c_ntt;
 }
 
+std::vector<ModInt> NTT::pointwise_multiply(const std::vector<ModInt>& a_ntt,
+                                             const std::vector<ModInt>& b_ntt) const {
+    FHE_COUNT(PointwiseMultiply, 1);
+    FHE_COUNT(PolyAllocation, 1);
+    FHE_PERF_SCOPE(Pointwise, N);
+    if (a_ntt.size() != (size_t)N || b_ntt.size() != (size_t)N) {
+        throw std::invalid_argument("Input sizes must equal N");
+    }
+    
+    std::vector<ModInt> result(N);
+    for (int i = 0; i < N; i++) {
+        result[i] = mod_mul(a_ntt[i], b_ntt[i]);
+    }
+    return result;
+}
+
 std::vector<ModInt> NTT::add(const std::vector<ModInt>& a,
                               const std::vector<ModInt>& b) const {
+    FHE_COUNT(PolyAllocation, 1);
     if (a.size() != b.size()) {
         throw std::invalid_argument("Input sizes must match");
     }
@@ -264,6 +452,7 @@ std::vector<ModInt> NTT::add(const std::vector<ModInt>& a,
 
 std::vector<ModInt> NTT::subtract(const std::vector<ModInt>& a,
                                    const std::vector<ModInt>& b) const {
+    FHE_COUNT(PolyAllocation, 1);
     if (a.size() != b.size()) {
         throw std::invalid_argument("Input sizes must match");
     }
@@ -277,6 +466,7 @@ std::vector<ModInt> NTT::subtract(const std::vector<ModInt>& a,
 
 std::vector<ModInt> NTT::scalar_mul(const std::vector<ModInt>& a,
                                      ModInt scalar) const {
+    FHE_COUNT(PolyAllocation, 1);
     std::vector<ModInt> result(a.size());
     for (size_t i = 0; i < a.size(); i++) {
         result[i] = mod_mul(a[i], scalar);
@@ -288,4 +478,74 @@ bool NTT::is_valid() const {
     return psi != 0 && psi_inv != 0 && N_inv != 0;
 }
 
+bool is_prime(ModInt n) {
+    if (n < 2) return false;
+    for (ModInt p : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}) {
+        if (n % p == 0) return n == p;
+    }
+    
+    auto mul = [n](UModInt a, UModInt b) {
+        return (UModInt)(((unsigned __int128)a * b) % (UModInt)n);
+    };
+    auto pow = [&mul](UModInt b, UModInt e) {
+        UModInt r = 1;
+        while (e > 0) {
+            if (e & 1) r = mul(r, b);
+            b = mul(b, b);
+            e >>= 1;
+        }
+        return r;
+    };
+    
+    // n - 1 = d * 2^r; these bases are deterministic below 2^64
+    UModInt d = (UModInt)n - 1;
+    int r = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        r++;
+    }
+    for (UModInt a : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}) {
+        UModInt x = pow(a, d);
+        if (x == 1 || x == (UModInt)n - 1) continue;
+        bool composite = true;
+        for (int i = 1; i < r && composite; i++) {
+            x = mul(x, x);
+            if (x == (UModInt)n - 1) composite = false;
+        }
+        if (composite) return false;
+    }
+    return true;
+}
+
+ModInt find_ntt_prime(int N, int bits) {
+    if (bits == 0) {
+        ModInt q = 2 * (ModInt)N + 1;
+        while (!is_prime(q)) {
+            q += 2 * N;
+        }
+        return q;
+    }
+    return find_ntt_primes(N, bits, 1)[0];
+}
+
+std::vector<ModInt> find_ntt_primes(int N, int bits, int count) {
+    ModInt step = 2 * (ModInt)N;
+    if (bits < 2 || bits > 62 || ((ModInt)1 << bits) <= step) {
+        throw std::invalid_argument("Prime size must satisfy 2N < 2^bits <= 2^62");
+    }
+    
+    // Largest candidate below 2^bits that is 1 (mod 2N)
+    ModInt q = ((((ModInt)1 << bits) - 1) / step) * step + 1;
+    if (q >= ((ModInt)1 << bits)) q -= step;
+    
+    std::vector<ModInt> primes;
+    for (; q > step && (int)primes.size() < count; q -= step) {
+        if (is_prime(q)) primes.push_back(q);
+    }
+    if ((int)primes.size() < count) {
+        throw std::runtime_error("Not enough NTT-friendly primes of this size");
+    }
+    return primes;
+}
+
 } // namespace fhe_cpp
@@ -10,6 +10,7 @@
 #include <vector>
 #include <cstdint>
 #include <stdexcept>
+#include <string>
 
 namespace fhe_cpp {
 
@@ -17,6 +18,21 @@ namespace fhe_cpp {
 typedef int64_t ModInt;
 typedef uint64_t UModInt;
 
+// Transform kernels; all produce identical results (natural order, index j
+// holds the evaluation at psi^(2j+1))
+enum class NttVariant : int {
+    Auto,           // Winner from the tuning profile, else MergedShoup
+    Reference,      // Twist, bit reversal, iterative Cooley-Tukey
+    Merged,         // Twiddles merged with psi, bit-reversed tables
+    MergedShoup,    // Merged, with Shoup precomputed twiddle quotients
+    Count
+};
+
+const char* ntt_variant_name(NttVariant variant);
+
+// Inverse of ntt_variant_name; throws std::invalid_argument
+NttVariant parse_ntt_variant(const std::string& name);
+
 class NTT {
 private:
     int N;                          // Polynomial degree (must be power of 2)
@@ -26,6 +42,16 @@ private:
     std::vector<ModInt> psi_powers; // Precomputed powers of psi
     std::vector<ModInt> psi_inv_powers; // Precomputed powers of psi_inv
     ModInt N_inv;                   // Inverse of N mod q
+    NttVariant variant;             // Resolved kernel (never Auto)
+    size_t parallel_batch;          // Smallest batch run on the thread pool
+    
+    // Merged kernels: psi^bitrev(i) and psi^-bitrev(i), with their Shoup
+    // quotients floor(w * 2^64 / q)
+    std::vector<UModInt> psi_rev;
+    std::vector<UModInt> psi_inv_rev;
+    std::vector<UModInt> psi_rev_shoup;
+    std::vector<UModInt> psi_inv_rev_shoup;
+    UModInt N_inv_shoup;
     
     // Modular arithmetic helpers
     ModInt mod_add(ModInt a, ModInt b) const;
@@ -34,24 +60,47 @@ private:
     ModInt mod_exp(ModInt base, ModInt exp) const;
     ModInt mod_inv(ModInt a) const;
     
+    // Search for a primitive 2N-th root of unity mod q
+    ModInt find_primitive_root();
+    
     // Bit reversal for NTT
     int bit_reverse(int x, int log_n) const;
     void bit_reverse_copy(std::vector<ModInt>& a) const;
+    
+    void forward_reference(std::vector<ModInt>& a) const;
+    void inverse_reference(std::vector<ModInt>& a) const;
+    
+    // Bring coefficients into [0, q) (the merged kernels need it)
+    void reduce(std::vector<ModInt>& a) const;
+    
+    template <bool Shoup> void forward_merged(std::vector<ModInt>& a) const;
+    template <bool Shoup> void inverse_merged(std::vector<ModInt>& a) const;
 
 public:
-    NTT(int N, ModInt q);
+    // Auto picks the kernel from the NTT tuning profile (see ntt_tuning.h)
+    NTT(int N, ModInt q, NttVariant variant = NttVariant::Auto);
     ~NTT() = default;
     
-    // Forward NTT transform
+    // Forward negacyclic NTT transform
+    // Output index j holds the evaluation at psi^(2j+1)
     void forward(std::vector<ModInt>& a) const;
     
-    // Inverse NTT transform
+    // Inverse negacyclic NTT transform
     void inverse(std::vector<ModInt>& a) const;
     
+    // Transform many polynomials in place; batches of at least the tuned
+    // threading threshold run on the global thread pool
+    void forward_batch(std::vector<std::vector<ModInt>>& polys) const;
+    void inverse_batch(std::vector<std::vector<ModInt>>& polys) const;
+    
     // Multiply two polynomials using NTT (result in standard form)
     std::vector<ModInt> multiply(const std::vector<ModInt>& a, 
                                   const std::vector<ModInt>& b) const;
     
+    // Pointwise product of two polynomials already in NTT form
+    std::vector<ModInt> pointwise_multiply(const std::vector<ModInt>& a_ntt,
+                                            const std::vector<ModInt>& b_ntt) const;
+    
     // Add two polynomials
     std::vector<ModInt> add(const std::vector<ModInt>& a,
                             const std::vector<ModInt>& b) const;
@@ -70,8 +119,20 @@ public:
     // Getters
     int get_N() const { return N; }
     ModInt get_q() const { return q; }
+    NttVariant get_variant() const { return variant; }
+    size_t get_parallel_batch() const { return parallel_batch; }
 };
 
+// Deterministic Miller-Rabin primality test for 64-bit integers
+bool is_prime(ModInt n);
+
+// Prime q = 1 (mod 2N): the smallest one when bits is 0, otherwise the
+// largest one below 2^bits (bits <= 62)
+ModInt find_ntt_prime(int N, int bits = 0);
+
+// count distinct primes q = 1 (mod 2N) below 2^bits, largest first
+std::vector<ModInt> find_ntt_primes(int N, int bits, int count);
+
 } // namespace fhe_cpp
 
 #endif // FHE_NTT_H
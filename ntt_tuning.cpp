@@ -0,0 +1,292 @@
+/*
+ * NTT Tuning Implementation
+ */
+
+#include "ntt_tuning.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+
+namespace fhe_cpp {
+
+namespace {
+
+std::mutex tuner_mutex;
+std::vector<NttTuningEntry> profile;
+std::string profile_file;
+bool loaded = false;
+int auto_tune_flag = -1;    // -1: not read from the environment yet
+
+std::string default_profile_path() {
+    const char* env = std::getenv("FHE_NTT_TUNING_FILE");
+    if (env != nullptr && *env) return env;
+    
+    const char* cache = std::getenv("XDG_CACHE_HOME");
+    std::string base;
+    if (cache != nullptr && *cache) {
+        base = cache;
+    } else {
+        const char* home = std::getenv("HOME");
+        base = std::string(home != nullptr ? home : ".") + "/.cache";
+    }
+    return base + "/fhe_cpp/ntt_tuning.tsv";
+}
+
+// One entry per line: cpu \t N \t modulus_bits \t variant \t forward_ns \t
+// inverse_ns \t parallel_batch (older profiles lack the last column)
+void load_locked() {
+    if (loaded) return;
+    loaded = true;
+    profile.clear();
+    if (profile_file.empty()) profile_file = default_profile_path();
+    
+    std::ifstream in(profile_file);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream ss(line);
+        NttTuningEntry e;
+        std::string N, bits, variant, fwd, inv, batch;
+        if (!std::getline(ss, e.cpu, '\t') || !std::getline(ss, N, '\t') ||
+            !std::getline(ss, bits, '\t') || !std::getline(ss, variant, '\t') ||
+            !std::getline(ss, fwd, '\t') || !std::getline(ss, inv, '\t')) {
+            continue;
+        }
+        try {
+            e.N = std::stoi(N);
+            e.modulus_bits = std::stoi(bits);
+            e.variant = parse_ntt_variant(variant);
+            e.forward_ns = std::stod(fwd);
+            e.inverse_ns = std::stod(inv);
+            e.parallel_batch = std::getline(ss, batch, '\t')
+                ? std::max(1, std::stoi(batch))
+                : NttTuner::default_parallel_threshold();
+        } catch (const std::exception&) {
+            continue;   // Skip malformed or unknown-variant lines
+        }
+        profile.push_back(e);
+    }
+}
+
+void save_locked() {
+    std::filesystem::path path(profile_file);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+    
+    // Write a temporary file and rename it, so concurrent readers never
+    // see a partial profile
+    std::string tmp = profile_file + ".tmp";
+    {
+        std::ofstream out(tmp);
+        if (!out) throw std::runtime_error("Cannot write NTT tuning profile: " + tmp);
+        out << "# fhe_cpp NTT tuning profile\n"
+            << "# cpu\tN\tmodulus_bits\tvariant\tforward_ns\tinverse_ns\tparallel_batch\n";
+        for (const auto& e : profile) {
+            out << e.cpu << '\t' << e.N << '\t' << e.modulus_bits << '\t'
+                << ntt_variant_name(e.variant) << '\t' << e.forward_ns << '\t'
+                << e.inverse_ns << '\t' << e.parallel_batch << '\n';
+        }
+    }
+    std::filesystem::rename(tmp, profile_file);
+}
+
+void record_locked(const NttTuningEntry& entry) {
+    for (auto& e : profile) {
+        if (e.cpu == entry.cpu && e.N == entry.N && e.modulus_bits == entry.modulus_bits) {
+            e = entry;
+            return;
+        }
+    }
+    profile.push_back(entry);
+}
+
+double median_ns(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// Median forward and inverse time of one variant, or a negative time if
+// its output differs from the reference kernel
+std::pair<double, double> time_variant(int N, ModInt q, NttVariant variant, int reps,
+                                       const std::vector<ModInt>& input,
+                                       const std::vector<ModInt>& expected) {
+    NTT ntt(N, q, variant);
+    std::vector<ModInt> a = input;
+    ntt.forward(a);
+    if (a != expected) return {-1.0, -1.0};
+    ntt.inverse(a);
+    if (a != input) return {-1.0, -1.0};
+    
+    std::vector<double> fwd, inv;
+    for (int r = 0; r < reps + 2; r++) {
+        auto start = std::chrono::steady_clock::now();
+        ntt.forward(a);
+        auto mid = std::chrono::steady_clock::now();
+        ntt.inverse(a);
+        auto end = std::chrono::steady_clock::now();
+        if (r < 2) continue;    // Warm-up
+        fwd.push_back(std::chrono::duration<double, std::nano>(mid - start).count());
+        inv.push_back(std::chrono::duration<double, std::nano>(end - mid).count());
+    }
+    return {median_ns(fwd), median_ns(inv)};
+}
+
+// Batch sizes tried for the threading threshold; a kernel that never wins
+// on the pool gets twice the largest, so realistic batches stay serial
+const int kParallelBatches[] = {2, 4, 8, 16, 32, 64};
+const int kNeverParallel = 128;
+
+// Smallest batch whose forward transforms finish sooner on the global pool
+// than in a loop on the caller
+int time_parallel_threshold(const NTT& ntt, int reps, const std::vector<ModInt>& input) {
+    auto pool = ThreadPool::global();
+    if (pool->size() <= 1) return kNeverParallel;
+    
+    for (int batch : kParallelBatches) {
+        std::vector<std::vector<ModInt>> polys(batch, input);
+        std::vector<double> serial, parallel;
+        for (int r = 0; r < reps + 1; r++) {
+            auto start = std::chrono::steady_clock::now();
+            for (auto& p : polys) ntt.forward(p);
+            auto mid = std::chrono::steady_clock::now();
+            pool->parallel_for(polys.size(), [&](size_t i) { ntt.forward(polys[i]); });
+            auto end = std::chrono::steady_clock::now();
+            if (r < 1) continue;    // Warm-up
+            serial.push_back(std::chrono::duration<double, std::nano>(mid - start).count());
+            parallel.push_back(std::chrono::duration<double, std::nano>(end - mid).count());
+        }
+        if (median_ns(parallel) < median_ns(serial)) return batch;
+    }
+    return kNeverParallel;
+}
+
+} // namespace
+
+std::string NttTuner::cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(colon + 2);
+        }
+    }
+    return "unknown";
+}
+
+void NttTuner::set_auto_tune(bool on) {
+    std::lock_guard<std::mutex> lock(tuner_mutex);
+    auto_tune_flag = on ? 1 : 0;
+}
+
+bool NttTuner::auto_tune() {
+    std::lock_guard<std::mutex> lock(tuner_mutex);
+    if (auto_tune_flag < 0) {
+        const char* env = std::getenv("FHE_NTT_AUTOTUNE");
+        auto_tune_flag = (env != nullptr && std::string(env) == "1") ? 1 : 0;
+    }
+    return auto_tune_flag == 1;
+}
+
+std::string NttTuner::profile_path() {
+    std::lock_guard<std::mutex> lock(tuner_mutex);
+    return profile_file.empty() ? default_profile_path() : profile_file;
+}
+
+void NttTuner::set_profile_path(const std::string& path) {
+    std::lock_guard<std::mutex> lock(tuner_mutex);
+    profile_file = path;
+    loaded = false;
+}
+
+std::vector<NttTuningEntry> NttTuner::entries() {
+    std::lock_guard<std::mutex> lock(tuner_mutex);
+    load_locked();
+    return profile;
+}
+
+NttVariant NttTuner::select(int N, int modulus_bits) {
+    static const std::string cpu = cpu_model();
+    {
+        std::lock_guard<std::mutex> lock(tuner_mutex);
+        load_locked();
+        for (const auto& e : profile) {
+            if (e.N == N && e.modulus_bits == modulus_bits && e.cpu == cpu) return e.variant;
+        }
+    }
+    
+    if (auto_tune()) {
+        try {
+            auto tuned = tune({N}, {modulus_bits});
+            if (!tuned.empty()) return tuned[0].variant;
+        } catch (const std::exception&) {
+            // No NTT prime of this size or unwritable profile: use the default
+        }
+    }
+    return default_variant();
+}
+
+int NttTuner::parallel_threshold(int N, int modulus_bits) {
+    static const std::string cpu = cpu_model();
+    std::lock_guard<std::mutex> lock(tuner_mutex);
+    load_locked();
+    for (const auto& e : profile) {
+        if (e.N == N && e.modulus_bits == modulus_bits && e.cpu == cpu) return e.parallel_batch;
+    }
+    return default_parallel_threshold();
+}
+
+std::vector<NttTuningEntry> NttTuner::tune(const std::vector<int>& ring_sizes,
+                                           const std::vector<int>& modulus_bits,
+                                           int reps, bool save) {
+    if (reps < 1) throw std::invalid_argument("reps must be at least 1");
+    std::string cpu = cpu_model();
+    std::vector<NttTuningEntry> results;
+    
+    for (int N : ring_sizes) {
+        for (int bits : modulus_bits) {
+            ModInt q = find_ntt_prime(N, bits);
+            
+            std::mt19937_64 rng(N * 131 + bits);
+            std::uniform_int_distribution<ModInt> dist(0, q - 1);
+            std::vector<ModInt> input(N);
+            for (auto& v : input) v = dist(rng);
+            std::vector<ModInt> expected = input;
+            NTT(N, q, NttVariant::Reference).forward(expected);
+            
+            NttTuningEntry best{cpu, N, bits, NttVariant::Reference, -1.0, -1.0,
+                                default_parallel_threshold()};
+            for (int v = (int)NttVariant::Reference; v < (int)NttVariant::Count; v++) {
+                auto times = time_variant(N, q, (NttVariant)v, reps, input, expected);
+                if (times.first < 0) continue;
+                if (best.forward_ns < 0 ||
+                    times.first + times.second < best.forward_ns + best.inverse_ns) {
+                    best.variant = (NttVariant)v;
+                    best.forward_ns = times.first;
+                    best.inverse_ns = times.second;
+                }
+            }
+            
+            // Batches are short, so a few repetitions per size suffice
+            best.parallel_batch = time_parallel_threshold(
+                NTT(N, q, best.variant), std::max(3, reps / 4), input);
+            results.push_back(best);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(tuner_mutex);
+    load_locked();
+    for (const auto& e : results) record_locked(e);
+    if (save) save_locked();
+    return results;
+}
+
+} // namespace fhe_cpp
@@ -0,0 +1,72 @@
+/*
+ * NTT kernel autotuning
+ * Times every NTT variant for a (N, modulus size) pair on this machine and
+ * keeps the winners in a per-machine profile file, keyed by CPU model so
+ * one file can be shared across a heterogeneous fleet. NTT construction
+ * with NttVariant::Auto dispatches through select()
+ *
+ * Two dimensions are tuned: the kernel and the threading threshold, the
+ * smallest batch that forward_batch / inverse_batch spread over the
+ * thread pool. The kernels are scalar code (the tree has no SIMD
+ * dependency), so there is no vector-width dimension; whatever the
+ * compiler auto-vectorizes in a kernel is part of what gets timed
+ */
+
+#ifndef FHE_NTT_TUNING_H
+#define FHE_NTT_TUNING_H
+
+#include "ntt.h"
+#include <string>
+#include <vector>
+
+namespace fhe_cpp {
+
+struct NttTuningEntry {
+    std::string cpu;
+    int N;
+    int modulus_bits;
+    NttVariant variant;     // Fastest forward + inverse
+    double forward_ns;      // Median time of the winner
+    double inverse_ns;
+    int parallel_batch;     // Smallest batch that is faster on the pool
+};
+
+class NttTuner {
+public:
+    // Profile winner for this CPU, or the compiled default (MergedShoup).
+    // With auto-tuning on, a missing pair is tuned and saved first
+    static NttVariant select(int N, int modulus_bits);
+    
+    // Profile threading threshold for this CPU, or the compiled default
+    // (any batch of two or more runs on the pool); never tunes
+    static int parallel_threshold(int N, int modulus_bits);
+    
+    // Benchmark every variant for each pair (after checking it matches the
+    // reference transform), then time the winner's batches serially and on
+    // the global pool; record the results and optionally save them
+    static std::vector<NttTuningEntry> tune(const std::vector<int>& ring_sizes,
+                                            const std::vector<int>& modulus_bits,
+                                            int reps = 20, bool save = true);
+    
+    // Off unless FHE_NTT_AUTOTUNE=1 is set in the environment
+    static void set_auto_tune(bool on);
+    static bool auto_tune();
+    
+    // FHE_NTT_TUNING_FILE, else $XDG_CACHE_HOME (or ~/.cache)/fhe_cpp/ntt_tuning.tsv
+    static std::string profile_path();
+    
+    // Use another profile file; it is (re)loaded on next use
+    static void set_profile_path(const std::string& path);
+    
+    // All entries of the loaded profile, for every CPU
+    static std::vector<NttTuningEntry> entries();
+    
+    static std::string cpu_model();
+    
+    static NttVariant default_variant() { return NttVariant::MergedShoup; }
+    static int default_parallel_threshold() { return 2; }
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_NTT_TUNING_H
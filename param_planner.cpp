@@ -0,0 +1,146 @@
+/*
+ * Parameter Planner Implementation
+ */
+
+#include "param_planner.h"
+#include "noise.h"
+#include <cmath>
+
+namespace fhe_cpp {
+
+// Ring degrees 2^10 .. 2^15 and their largest moduli (bits)
+static const int kDegrees[] = {1024, 2048, 4096, 8192, 16384, 32768};
+static const int kMaxBits128[] = {27, 54, 109, 218, 438, 881};
+static const int kMaxBits192[] = {19, 37, 75, 152, 305, 611};
+static const int kMaxBits256[] = {14, 29, 58, 118, 237, 476};
+
+// Decomposition bases tried, in bits (0: no decomposition)
+static const int kDecompBits[] = {0, 60, 50, 40, 30, 20, 16};
+
+// Largest prime in an RNS modulus
+static const int kMaxPrimeBits = 60;
+
+ParameterPlanner::ParameterPlanner(double sigma, double butterfly_ns, double mulmod_ns)
+    : sigma(sigma), butterfly_ns(butterfly_ns), mulmod_ns(mulmod_ns) {
+    if (sigma <= 0 || butterfly_ns <= 0 || mulmod_ns <= 0) {
+        throw std::invalid_argument("Planner constants must be positive");
+    }
+}
+
+int ParameterPlanner::max_modulus_bits(int N, int security) {
+    const int* table;
+    switch (security) {
+        case 128: table = kMaxBits128; break;
+        case 192: table = kMaxBits192; break;
+        case 256: table = kMaxBits256; break;
+        default:
+            throw std::invalid_argument("Security level must be 128, 192 or 256");
+    }
+    for (int i = 0; i < 6; i++) {
+        if (kDegrees[i] == N) return table[i];
+    }
+    return 0;
+}
+
+void ParameterPlanner::estimate_costs(ParameterPlan& plan, int depth, int rotations) const {
+    double N = plan.N;
+    double L = plan.moduli.size();
+    double log_n = std::log2(N);
+    double digits = plan.decomp_bits == 0
+        ? 1 : std::ceil((double)plan.modulus_bits / plan.decomp_bits);
+    
+    plan.ntt_us = L * (N / 2) * log_n * butterfly_ns / 1000;
+    plan.add_us = L * N * mulmod_ns / 2 / 1000;
+    
+    // Tensor product: 4 forward + 3 inverse NTTs, 4 pointwise products,
+    // then the t/q rescaling of the 3 components
+    plan.multiply_us = 7 * plan.ntt_us + 7 * L * N * mulmod_ns / 1000;
+    
+    // Key switch: one forward NTT per digit, 2 inverse, 2 products per digit
+    plan.relinearize_us = (digits + 2) * plan.ntt_us + 2 * digits * L * N * mulmod_ns / 1000;
+    plan.rotate_us = plan.relinearize_us;
+    
+    plan.circuit_us = depth * (plan.multiply_us + plan.relinearize_us)
+                    + rotations * plan.rotate_us;
+}
+
+ParameterPlan ParameterPlanner::plan(int depth, ModInt t, int rotations, int security,
+                                     bool batching, double min_budget) const {
+    if (depth < 0 || rotations < 0) {
+        throw std::invalid_argument("Depth and rotation count must be non-negative");
+    }
+    if (t < 2) {
+        throw std::invalid_argument("Plaintext modulus must be at least 2");
+    }
+    
+    auto budget_after = [&](const NoiseModel& nm) {
+        double v = nm.fresh();
+        for (int d = 0; d < depth; d++) {
+            v = nm.relinearize(nm.multiply(v, v));
+        }
+        for (int r = 0; r < rotations; r++) {
+            v = nm.rotate(v);
+        }
+        return nm.budget(v);
+    };
+    
+    bool found = false;
+    ParameterPlan best{};
+    int min_bits = (int)std::ceil(std::log2((double)t)) + 1;
+    
+    for (int N : kDegrees) {
+        if (batching && (t - 1) % (2 * (ModInt)N) != 0) continue;
+        int max_bits = max_modulus_bits(N, security);
+        
+        for (int decomp : kDecompBits) {
+            // Smallest modulus that leaves min_budget for this base
+            for (int bits = min_bits; bits <= max_bits; bits++) {
+                if (decomp >= bits) continue;
+                NoiseModel nm = NoiseModel::from_log_q(N, bits, t, sigma, decomp);
+                if (budget_after(nm) < min_budget) continue;
+                
+                // Split into primes of near-equal size (sizes differ by at
+                // most one bit, so the ranges and primes are distinct)
+                int L = (bits + kMaxPrimeBits - 1) / kMaxPrimeBits;
+                if (bits / L <= (int)std::log2(2.0 * N)) continue;
+                
+                ParameterPlan plan{};
+                plan.N = N;
+                plan.t = t;
+                plan.security = security;
+                plan.modulus_bits = bits;
+                plan.decomp_bits = decomp;
+                int larger = bits % L;
+                if (larger > 0) {
+                    plan.moduli = find_ntt_primes(N, bits / L + 1, larger);
+                }
+                for (ModInt p : find_ntt_primes(N, bits / L, L - larger)) {
+                    plan.moduli.push_back(p);
+                }
+                
+                double log_q = 0;
+                for (ModInt p : plan.moduli) {
+                    log_q += std::log2((double)p);
+                }
+                plan.budget_left = budget_after(
+                    NoiseModel::from_log_q(N, log_q, t, sigma, decomp));
+                if (plan.budget_left < min_budget) continue;
+                
+                estimate_costs(plan, depth, rotations);
+                if (!found || plan.circuit_us < best.circuit_us ||
+                    (plan.circuit_us == best.circuit_us && plan.ntt_us < best.ntt_us)) {
+                    best = plan;
+                    found = true;
+                }
+                break;
+            }
+        }
+    }
+    
+    if (!found) {
+        throw std::runtime_error("No supported parameters meet this depth and security level");
+    }
+    return best;
+}
+
+} // namespace fhe_cpp
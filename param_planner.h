@@ -0,0 +1,60 @@
+/*
+ * Parameter selection from a circuit profile
+ * Searches ring degrees, modulus sizes and key-switching decomposition
+ * bases for the cheapest combination that meets the security level and
+ * leaves noise budget after the circuit, according to the noise model
+ */
+
+#ifndef FHE_PARAM_PLANNER_H
+#define FHE_PARAM_PLANNER_H
+
+#include "ntt.h"
+#include <vector>
+
+namespace fhe_cpp {
+
+struct ParameterPlan {
+    int N;                      // Ring degree
+    ModInt t;                   // Plaintext modulus
+    int security;               // Classical security level (bits)
+    int modulus_bits;           // log2(q), q the product of the moduli
+    std::vector<ModInt> moduli; // NTT-friendly primes, at most 60 bits each
+    int decomp_bits;            // Key-switching base in bits (0: none)
+    double budget_left;         // Estimated bits left after the circuit
+    
+    // Estimated costs in microseconds
+    double ntt_us;
+    double add_us;
+    double multiply_us;
+    double relinearize_us;
+    double rotate_us;
+    double circuit_us;          // depth * (multiply + relinearize) + rotations * rotate
+};
+
+class ParameterPlanner {
+private:
+    double sigma;           // Error standard deviation
+    double butterfly_ns;    // Cost of one NTT butterfly (mul-mod + add + sub)
+    double mulmod_ns;       // Cost of one coefficient-wise mul-mod
+    
+    void estimate_costs(ParameterPlan& plan, int depth, int rotations) const;
+
+public:
+    ParameterPlanner(double sigma = 3.2, double butterfly_ns = 3.0, double mulmod_ns = 2.0);
+    ~ParameterPlanner() = default;
+    
+    // Largest log2(q) for ring degree N at the given security level
+    // (HomomorphicEncryption.org standard, ternary secrets); 0 if N is
+    // too small for any modulus
+    static int max_modulus_bits(int N, int security);
+    
+    // Cheapest plan for a circuit of the given multiplicative depth and
+    // number of rotations, leaving at least min_budget bits; batching
+    // requires t = 1 (mod 2N). Throws if no supported N works
+    ParameterPlan plan(int depth, ModInt t, int rotations = 0, int security = 128,
+                       bool batching = true, double min_budget = 1.0) const;
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_PARAM_PLANNER_H
@@ -0,0 +1,246 @@
+/*
+ * Performance Counter Implementation
+ */
+
+#include "perf_counters.h"
+#include <mutex>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace fhe_cpp {
+
+namespace {
+
+const int kEvents = (int)PerfEvent::Count;
+const int kKernels = (int)PerfKernel::Count;
+
+struct KernelTotals {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> coefficients{0};
+    std::atomic<uint64_t> values[kEvents];
+    std::atomic<bool> seen[kEvents];
+    
+    KernelTotals() { clear(); }
+    
+    void clear() {
+        calls.store(0, std::memory_order_relaxed);
+        coefficients.store(0, std::memory_order_relaxed);
+        for (int e = 0; e < kEvents; e++) {
+            values[e].store(0, std::memory_order_relaxed);
+            seen[e].store(false, std::memory_order_relaxed);
+        }
+    }
+};
+
+KernelTotals totals[kKernels];
+
+#ifdef __linux__
+
+uint64_t cache_config(uint64_t cache, uint64_t result) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+}
+
+// The generic perf ABI has no portable L2 event; cache misses counts
+// misses of the cache level the PMU driver maps it to (usually LLC on
+// Intel, L2 on several ARM cores) and is the closest available stand-in
+void event_attr(PerfEvent event, perf_event_attr& attr) {
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (event) {
+        case PerfEvent::Cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfEvent::Instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfEvent::L1DMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case PerfEvent::L2Misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PerfEvent::LLCMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_config(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case PerfEvent::BranchMisses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            break;
+    }
+}
+
+// Counters of the calling thread; perf_event_open with pid 0 follows only
+// this thread, so each thread that runs a profiled kernel opens its own
+struct ThreadCounters {
+    int fds[kEvents];
+    
+    ThreadCounters() {
+        for (int e = 0; e < kEvents; e++) {
+            perf_event_attr attr;
+            event_attr((PerfEvent)e, attr);
+            fds[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (fds[e] >= 0) {
+                ioctl(fds[e], PERF_EVENT_IOC_RESET, 0);
+                ioctl(fds[e], PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+    
+    ~ThreadCounters() {
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+    
+    bool any() const {
+        for (int fd : fds) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+};
+
+ThreadCounters& thread_counters() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+#endif
+
+} // namespace
+
+std::atomic<bool> PerfCounters::active(false);
+
+bool PerfCounters::supported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PerfCounters::set_enabled(bool on) {
+#ifdef __linux__
+    if (!on) {
+        active.store(false, std::memory_order_relaxed);
+        return false;
+    }
+    bool available = thread_counters().any();
+    active.store(available, std::memory_order_relaxed);
+    return available;
+#else
+    (void)on;
+    return false;
+#endif
+}
+
+PerfReading PerfCounters::read() {
+    PerfReading r{};
+#ifdef __linux__
+    ThreadCounters& tc = thread_counters();
+    for (int e = 0; e < kEvents; e++) {
+        if (tc.fds[e] < 0) continue;
+        
+        // value, time enabled, time running; scale up when the PMU was
+        // multiplexed between more events than it has counters
+        uint64_t buf[3];
+        if (::read(tc.fds[e], buf, sizeof(buf)) != (ssize_t)sizeof(buf) || buf[2] == 0) {
+            continue;
+        }
+        r.valid[e] = true;
+        r.values[e] = buf[2] < buf[1]
+            ? (uint64_t)((double)buf[0] * buf[1] / buf[2])
+            : buf[0];
+    }
+#endif
+    return r;
+}
+
+void PerfCounters::record(PerfKernel kernel, const PerfReading& begin,
+                          const PerfReading& end, uint64_t coefficients) {
+    KernelTotals& k = totals[(int)kernel];
+    k.calls.fetch_add(1, std::memory_order_relaxed);
+    k.coefficients.fetch_add(coefficients, std::memory_order_relaxed);
+    for (int e = 0; e < kEvents; e++) {
+        if (!begin.valid[e] || !end.valid[e] || end.values[e] < begin.values[e]) continue;
+        k.values[e].fetch_add(end.values[e] - begin.values[e], std::memory_order_relaxed);
+        k.seen[e].store(true, std::memory_order_relaxed);
+    }
+}
+
+std::map<std::string, PerfKernelStats> PerfCounters::snapshot() {
+    std::map<std::string, PerfKernelStats> result;
+    for (int kernel = 0; kernel < kKernels; kernel++) {
+        const KernelTotals& k = totals[kernel];
+        PerfKernelStats s{};
+        s.calls = k.calls.load(std::memory_order_relaxed);
+        if (s.calls == 0) continue;
+        s.coefficients = k.coefficients.load(std::memory_order_relaxed);
+        
+        for (int e = 0; e < kEvents; e++) {
+            if (!k.seen[e].load(std::memory_order_relaxed)) continue;
+            uint64_t v = k.values[e].load(std::memory_order_relaxed);
+            s.events[name((PerfEvent)e)] = v;
+            if (e != (int)PerfEvent::Cycles && e != (int)PerfEvent::Instructions &&
+                s.coefficients > 0) {
+                s.per_coefficient[name((PerfEvent)e)] = (double)v / s.coefficients;
+            }
+        }
+        
+        auto cycles = s.events.find(name(PerfEvent::Cycles));
+        auto instructions = s.events.find(name(PerfEvent::Instructions));
+        if (cycles != s.events.end() && instructions != s.events.end() && cycles->second > 0) {
+            s.ipc = (double)instructions->second / cycles->second;
+        }
+        if (cycles != s.events.end() && s.coefficients > 0) {
+            s.per_coefficient[cycles->first] = (double)cycles->second / s.coefficients;
+        }
+        result[name((PerfKernel)kernel)] = s;
+    }
+    return result;
+}
+
+void PerfCounters::reset() {
+    for (auto& k : totals) k.clear();
+}
+
+const char* PerfCounters::name(PerfEvent event) {
+    switch (event) {
+        case PerfEvent::Cycles: return "cycles";
+        case PerfEvent::Instructions: return "instructions";
+        case PerfEvent::L1DMisses: return "l1d_misses";
+        case PerfEvent::L2Misses: return "l2_misses";
+        case PerfEvent::LLCMisses: return "llc_misses";
+        case PerfEvent::BranchMisses: return "branch_misses";
+        default: return "unknown";
+    }
+}
+
+const char* PerfCounters::name(PerfKernel kernel) {
+    switch (kernel) {
+        case PerfKernel::NttForward: return "ntt_forward";
+        case PerfKernel::NttInverse: return "ntt_inverse";
+        case PerfKernel::Pointwise: return "pointwise";
+        case PerfKernel::KeySwitch: return "key_switch";
+        default: return "unknown";
+    }
+}
+
+} // namespace fhe_cpp
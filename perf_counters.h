@@ -0,0 +1,110 @@
+/*
+ * Hardware performance counters (Linux perf_event_open)
+ * Cycles, instructions, cache and branch misses around the NTT, pointwise
+ * and key-switching kernels, reported as IPC and misses per coefficient.
+ * Compiled in with FHE_ENABLE_INSTRUMENTATION and switched on at runtime;
+ * events the kernel or hardware refuse (containers, perf_event_paranoid,
+ * VMs) are reported as unavailable rather than failing
+ */
+
+#ifndef FHE_PERF_COUNTERS_H
+#define FHE_PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace fhe_cpp {
+
+enum class PerfEvent : int {
+    Cycles,
+    Instructions,
+    L1DMisses,          // L1 data cache read misses
+    L2Misses,           // Approximated by generic cache misses (see cpp)
+    LLCMisses,          // Last-level cache read misses
+    BranchMisses,
+    Count
+};
+
+// Profiled kernels
+enum class PerfKernel : int {
+    NttForward,
+    NttInverse,
+    Pointwise,
+    KeySwitch,
+    Count
+};
+
+// Raw counter values of one thread, scaled for multiplexing
+struct PerfReading {
+    bool valid[(int)PerfEvent::Count];
+    uint64_t values[(int)PerfEvent::Count];
+};
+
+struct PerfKernelStats {
+    uint64_t calls;
+    uint64_t coefficients;
+    std::map<std::string, uint64_t> events;     // Only available events
+    double ipc;                                 // 0 when cycles/instructions unavailable
+    std::map<std::string, double> per_coefficient;
+};
+
+class PerfCounters {
+private:
+    static std::atomic<bool> active;
+
+public:
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+    
+    // Returns whether at least one event could be opened on this thread
+    static bool set_enabled(bool on);
+    
+    // Whether this build can use perf_event_open at all
+    static bool supported();
+    
+    // Current counter values of the calling thread (opens them on first use)
+    static PerfReading read();
+    
+    static void record(PerfKernel kernel, const PerfReading& begin,
+                       const PerfReading& end, uint64_t coefficients);
+    
+    static std::map<std::string, PerfKernelStats> snapshot();
+    static void reset();
+    
+    static const char* name(PerfEvent event);
+    static const char* name(PerfKernel kernel);
+};
+
+// Attributes the counter deltas over a scope to kernel
+class PerfScope {
+private:
+    PerfKernel kernel;
+    uint64_t coefficients;
+    bool on;
+    PerfReading begin;
+
+public:
+    PerfScope(PerfKernel kernel, uint64_t coefficients)
+        : kernel(kernel), coefficients(coefficients), on(PerfCounters::enabled()) {
+        if (on) begin = PerfCounters::read();
+    }
+    
+    ~PerfScope() {
+        if (on) PerfCounters::record(kernel, begin, PerfCounters::read(), coefficients);
+    }
+    
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+};
+
+} // namespace fhe_cpp
+
+#ifdef FHE_ENABLE_INSTRUMENTATION
+#define FHE_PERF_SCOPE(kernel, coefficients) \
+    ::fhe_cpp::PerfScope fhe_perf_scope_(::fhe_cpp::PerfKernel::kernel, (coefficients))
+#else
+#define FHE_PERF_SCOPE(kernel, coefficients) do {} while (0)
+#endif
+
+#endif // FHE_PERF_COUNTERS_H
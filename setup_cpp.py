@@ -29,7 +29,9 @@ class CMakeBuild(build_ext):
         cmake_args = [
             f'-DCMAKE_LIBRARY_OUTPUT_DIRECTORY={extdir}',
             f'-DPYTHON_EXECUTABLE={sys.executable}',
-            '-DCMAKE_BUILD_TYPE=Release'
+            '-DCMAKE_BUILD_TYPE=Release',
+            '-DFHE_REQUIRE_PYBIND11=ON',
+            '-DFHE_BUILD_BENCHMARKS=OFF'
         ]
         
         build_args = ['--config', 'Release', '--', '-j4']
@@ -0,0 +1,149 @@
+/*
+ * Encrypted String Matching Implementation
+ */
+
+#include "string_match.h"
+#include "noise.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace fhe_cpp {
+
+namespace {
+
+// table[i] = 1 iff i - (range - 1) == 0, for differences in (-range, range)
+std::vector<ModInt> zero_test_table(ModInt char_range) {
+    std::vector<ModInt> table(2 * char_range - 1, 0);
+    table[char_range - 1] = 1;
+    return table;
+}
+
+int next_power_of_two(int n) {
+    int p = 1;
+    while (p < n) p *= 2;
+    return p;
+}
+
+} // namespace
+
+StringMatcher::StringMatcher(const BFVMultiplier& mult, int string_len, ModInt char_range)
+    : mult(mult), string_len(string_len), stride(next_power_of_two(string_len)),
+      char_range(char_range), zero_test(zero_test_table(char_range), mult.get_t()) {
+    
+    if (string_len < 1) {
+        throw std::invalid_argument("string_len must be at least 1");
+    }
+    if (stride > mult.get_ntt().get_N() / 2) {
+        throw std::invalid_argument("Strings must fit in one slot row");
+    }
+    
+    // The zero test has degree 2R - 2 (depth ceil(log2(2R - 2))) and each
+    // fold step is one more product; reject parameters whose modulus
+    // cannot hold that depth for fresh inputs
+    const NTT& ntt = mult.get_ntt();
+    NoiseModel noise(ntt.get_N(), ntt.get_q(), mult.get_t(), 3.2,
+                     mult.get_gadget().digit_bits());
+    int depth = (int)std::ceil(std::log2((double)std::max<ModInt>(2 * char_range - 2, 2)));
+    double v = noise.add(noise.fresh(), noise.fresh());
+    for (int d = 0; d < depth; d++) {
+        v = noise.relinearize(noise.multiply(v, v));
+    }
+    for (int step = 1; step < stride; step *= 2) {
+        v = noise.relinearize(noise.multiply(v, noise.rotate(v)));
+        depth++;
+    }
+    if (noise.budget(v) < 1.0) {
+        throw std::invalid_argument(
+            "char_range " + std::to_string(char_range) + " and string_len " +
+            std::to_string(string_len) + " need multiplicative depth " + std::to_string(depth) +
+            ", beyond the noise budget of the " +
+            std::to_string((int)std::ceil(std::log2((double)ntt.get_q()))) + "-bit modulus");
+    }
+}
+
+std::vector<ModInt> StringMatcher::prefix_mask(const BatchEncoder& encoder,
+                                               int prefix_len) const {
+    int N = mult.get_ntt().get_N();
+    if (encoder.slot_count() != N) {
+        throw std::invalid_argument("Encoder degree must match the multiplier");
+    }
+    if (prefix_len < 0 || prefix_len > string_len) {
+        throw std::invalid_argument("Prefix length must lie in [0, string_len]");
+    }
+    
+    std::vector<ModInt> slots(N, 0);
+    for (int s = 0; s < N; s++) {
+        if (s % stride < prefix_len) slots[s] = 1;
+    }
+    return encoder.encode(slots);
+}
+
+std::vector<uint64_t> StringMatcher::required_galois_elts() const {
+    GaloisTool galois(mult.get_ntt().get_N(), mult.get_ntt().get_q());
+    std::vector<uint64_t> elts;
+    for (int step = 1; step < stride; step *= 2) {
+        elts.push_back(galois.rotation_elt(step));
+    }
+    return elts;
+}
+
+std::vector<std::vector<ModInt>> StringMatcher::fold_positions(
+    const std::vector<std::vector<ModInt>>& diff,
+    const std::vector<std::vector<ModInt>>& relin_key,
+    const GaloisKeys& galois_keys) const {
+    
+    // Slot-wise indicator: 1 where the characters agree
+    auto shifted = mult.add_scalar(diff, char_range - 1);
+    auto eq = mult.lookup(shifted[0], shifted[1], zero_test, relin_key);
+    
+    // Rotate-and-multiply: after log2(stride) steps slot k*stride holds
+    // the product over positions [k*stride, (k+1)*stride). Padding slots
+    // must hold equal values (zeros) in both inputs so they contribute 1
+    for (uint64_t elt : required_galois_elts()) {
+        auto rotated = mult.apply_galois(eq[0], eq[1], elt, galois_keys);
+        eq = mult.multiply_relinearize(eq, rotated, relin_key);
+    }
+    return eq;
+}
+
+std::vector<std::vector<ModInt>> StringMatcher::equal(
+    const std::vector<std::vector<ModInt>>& ct_a,
+    const std::vector<std::vector<ModInt>>& ct_b,
+    const std::vector<std::vector<ModInt>>& relin_key,
+    const GaloisKeys& galois_keys) const {
+    
+    if (ct_a.size() != 2 || ct_b.size() != 2) {
+        throw std::invalid_argument("Can only compare size-2 ciphertexts");
+    }
+    
+    const NTT& ntt = mult.get_ntt();
+    std::vector<std::vector<ModInt>> diff = {
+        ntt.subtract(ct_a[0], ct_b[0]),
+        ntt.subtract(ct_a[1], ct_b[1])
+    };
+    return fold_positions(diff, relin_key, galois_keys);
+}
+
+std::vector<std::vector<ModInt>> StringMatcher::prefix_match(
+    const std::vector<std::vector<ModInt>>& ct_a,
+    const std::vector<std::vector<ModInt>>& ct_b,
+    const std::vector<ModInt>& position_mask,
+    const std::vector<std::vector<ModInt>>& relin_key,
+    const GaloisKeys& galois_keys) const {
+    
+    if (ct_a.size() != 2 || ct_b.size() != 2) {
+        throw std::invalid_argument("Can only compare size-2 ciphertexts");
+    }
+    
+    // Zeroing the difference outside the mask makes those positions
+    // compare equal, so only the masked positions decide the match
+    const NTT& ntt = mult.get_ntt();
+    std::vector<std::vector<ModInt>> diff = {
+        ntt.subtract(ct_a[0], ct_b[0]),
+        ntt.subtract(ct_a[1], ct_b[1])
+    };
+    return fold_positions(mult.multiply_plain(diff, position_mask), relin_key, galois_keys);
+}
+
+} // namespace fhe_cpp
@@ -0,0 +1,72 @@
+/*
+ * Encrypted string equality and prefix matching
+ * Strings are packed one character per slot, at a power-of-two stride,
+ * so each ciphertext carries N / stride strings
+ */
+
+#ifndef FHE_STRING_MATCH_H
+#define FHE_STRING_MATCH_H
+
+#include "bfv_mult.h"
+#include "lookup_table.h"
+#include "galois.h"
+#include "batch_encoder.h"
+#include <vector>
+
+namespace fhe_cpp {
+
+class StringMatcher {
+private:
+    const BFVMultiplier& mult;
+    int string_len;     // Characters compared per string
+    int stride;         // Slots per string (power of two >= string_len)
+    ModInt char_range;  // Characters lie in [0, char_range)
+    
+    // Zero test on character differences: table[d + char_range - 1] = (d == 0)
+    LookupTable zero_test;
+    
+    // Slot-wise equality indicators folded across each string's positions
+    std::vector<std::vector<ModInt>> fold_positions(
+        const std::vector<std::vector<ModInt>>& diff,
+        const std::vector<std::vector<ModInt>>& relin_key,
+        const GaloisKeys& galois_keys) const;
+
+public:
+    // Throws if the noise model leaves no budget after the zero test and
+    // the fold for fresh inputs (e.g. char_range = 256 needs depth 9)
+    StringMatcher(const BFVMultiplier& mult, int string_len, ModInt char_range = 256);
+    ~StringMatcher() = default;
+    
+    // Slot k*stride of the result holds 1 if string k of a equals string k
+    // of b and 0 otherwise; other slots are unspecified
+    std::vector<std::vector<ModInt>> equal(
+        const std::vector<std::vector<ModInt>>& ct_a,
+        const std::vector<std::vector<ModInt>>& ct_b,
+        const std::vector<std::vector<ModInt>>& relin_key,
+        const GaloisKeys& galois_keys) const;
+    
+    // Same as equal, but only the positions where the slot-encoded 0/1
+    // plaintext position_mask is 1 are compared (e.g. the first p
+    // characters of every string for a prefix match)
+    std::vector<std::vector<ModInt>> prefix_match(
+        const std::vector<std::vector<ModInt>>& ct_a,
+        const std::vector<std::vector<ModInt>>& ct_b,
+        const std::vector<ModInt>& position_mask,
+        const std::vector<std::vector<ModInt>>& relin_key,
+        const GaloisKeys& galois_keys) const;
+    
+    // Slot-encoded position mask selecting the first prefix_len characters
+    // of every string, for prefix_match
+    std::vector<ModInt> prefix_mask(const BatchEncoder& encoder, int prefix_len) const;
+    
+    // Galois elements the rotate-and-multiply fold needs keys for
+    std::vector<uint64_t> required_galois_elts() const;
+    
+    int get_stride() const { return stride; }
+    int get_string_len() const { return string_len; }
+    int strings_per_ciphertext() const { return mult.get_ntt().get_N() / stride; }
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_STRING_MATCH_H
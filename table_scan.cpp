@@ -0,0 +1,194 @@
+/*
+ * Encrypted Table Scan Implementation
+ */
+
+#include "table_scan.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <mutex>
+
+namespace fhe_cpp {
+
+TableScanner::TableScanner(const BFVMultiplier& mult, int num_threads, size_t block_rows)
+    : mult(mult), N(mult.get_ntt().get_N()),
+      block_rows(std::max<size_t>(block_rows, 1)),
+      own_pool(num_threads > 0 ? std::make_shared<ThreadPool>(num_threads) : nullptr) {
+}
+
+size_t TableScanner::add_row(const std::vector<std::vector<ModInt>>& key,
+                             const std::vector<std::vector<ModInt>>& payload,
+                             int64_t bucket) {
+    if (key.size() != 2 || payload.size() != 2) {
+        throw std::invalid_argument("Rows must hold size-2 ciphertexts");
+    }
+    for (const auto* ct : {&key, &payload}) {
+        for (const auto& comp : *ct) {
+            if (comp.size() != (size_t)N) {
+                throw std::invalid_argument("All ciphertext components must have size N");
+            }
+        }
+    }
+    
+    std::vector<std::vector<ModInt>> payload_ntt = payload;
+    for (auto& comp : payload_ntt) {
+        mult.get_ntt().forward(comp);
+    }
+    
+    keys.push_back(key);
+    payloads.push_back(payload);
+    payloads_ntt.push_back(std::move(payload_ntt));
+    
+    size_t row = keys.size() - 1;
+    if (bucket >= 0) {
+        bucket_rows[bucket].push_back(row);
+    }
+    return row;
+}
+
+std::vector<size_t> TableScanner::rows_in_bucket(int64_t bucket) const {
+    auto it = bucket_rows.find(bucket);
+    if (it == bucket_rows.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+void TableScanner::exact_match_batch(
+    const std::vector<std::vector<std::vector<ModInt>>>& targets,
+    const RowSink& sink) const {
+    FHE_TIME_OP(TableScan);
+    
+    const NTT& ntt = mult.get_ntt();
+    for (const auto& target : targets) {
+        if (target.size() != 2) {
+            throw std::invalid_argument("Targets must be size-2 ciphertexts");
+        }
+    }
+    std::mutex sink_lock;
+    
+    // Row-major within each block: a row is loaded once and reused for
+    // every query; the block's differences are handed to the sink and
+    // dropped before the worker moves on
+    pool()->parallel_for(num_blocks(), [&](size_t block) {
+        size_t begin = block * block_rows;
+        size_t end = std::min(keys.size(), begin + block_rows);
+        std::vector<std::vector<std::vector<std::vector<ModInt>>>> diffs(end - begin);
+        for (size_t row = begin; row < end; row++) {
+            const auto& key = keys[row];
+            auto& row_diffs = diffs[row - begin];
+            row_diffs.reserve(targets.size());
+            for (const auto& target : targets) {
+                row_diffs.push_back({
+                    ntt.subtract(key[0], target[0]),
+                    ntt.subtract(key[1], target[1])
+                });
+            }
+        }
+        
+        std::lock_guard<std::mutex> lock(sink_lock);
+        for (size_t row = begin; row < end; row++) {
+            sink(row, diffs[row - begin]);
+        }
+    });
+}
+
+std::vector<std::vector<std::pair<size_t, std::vector<std::vector<ModInt>>>>>
+TableScanner::exact_match_indexed(
+    const std::vector<std::vector<std::vector<ModInt>>>& targets,
+    const std::vector<int64_t>& buckets) const {
+    FHE_TIME_OP(TableScan);
+    
+    const NTT& ntt = mult.get_ntt();
+    if (targets.size() != buckets.size()) {
+        throw std::invalid_argument("Need exactly one bucket per target");
+    }
+    
+    // Only the rows of each query's bucket are evaluated; the comparison
+    // itself stays fully encrypted
+    std::vector<std::vector<std::pair<size_t, std::vector<std::vector<ModInt>>>>> result(
+        targets.size());
+    std::vector<std::pair<size_t, size_t>> work;  // (query, position in result)
+    for (size_t qi = 0; qi < targets.size(); qi++) {
+        if (targets[qi].size() != 2) {
+            throw std::invalid_argument("Targets must be size-2 ciphertexts");
+        }
+        auto it = bucket_rows.find(buckets[qi]);
+        if (it == bucket_rows.end()) {
+            continue;
+        }
+        for (size_t row : it->second) {
+            result[qi].emplace_back(row, std::vector<std::vector<ModInt>>());
+            work.emplace_back(qi, result[qi].size() - 1);
+        }
+    }
+    
+    size_t blocks = (work.size() + block_rows - 1) / block_rows;
+    pool()->parallel_for(blocks, [&](size_t block) {
+        size_t end = std::min(work.size(), (block + 1) * block_rows);
+        for (size_t w = block * block_rows; w < end; w++) {
+            auto& entry = result[work[w].first][work[w].second];
+            const auto& key = keys[entry.first];
+            const auto& target = targets[work[w].first];
+            entry.second = {
+                ntt.subtract(key[0], target[0]),
+                ntt.subtract(key[1], target[1])
+            };
+        }
+    });
+    return result;
+}
+
+std::vector<std::vector<std::vector<ModInt>>> TableScanner::sum_batch(
+    const std::vector<std::vector<std::vector<std::vector<ModInt>>>>& masks,
+    const std::vector<std::vector<ModInt>>& relin_key) const {
+    FHE_TIME_OP(TableScan);
+    
+    const NTT& ntt = mult.get_ntt();
+    for (const auto& query_masks : masks) {
+        if (query_masks.size() != keys.size()) {
+            throw std::invalid_argument("Need exactly one mask per row for every query");
+        }
+    }
+    
+    std::vector<std::vector<std::vector<ModInt>>> sums(
+        masks.size(), std::vector<std::vector<ModInt>>(3, std::vector<ModInt>(N, 0)));
+    std::vector<std::mutex> sum_locks(masks.size());
+    
+    pool()->parallel_for(num_blocks(), [&](size_t block) {
+        size_t end = std::min(keys.size(), (block + 1) * block_rows);
+        
+        // Block-local partial sums, merged once per block
+        std::vector<std::vector<std::vector<ModInt>>> partial(
+            masks.size(), std::vector<std::vector<ModInt>>(3, std::vector<ModInt>(N, 0)));
+        for (size_t row = block * block_rows; row < end; row++) {
+            for (size_t qi = 0; qi < masks.size(); qi++) {
+                const auto& mask = masks[qi][row];
+                if (mask.size() != 2) {
+                    throw std::invalid_argument("Masks must be size-2 ciphertexts");
+                }
+                
+                std::vector<std::vector<ModInt>> mask_ntt = mask;
+                for (auto& comp : mask_ntt) {
+                    ntt.forward(comp);
+                }
+                partial[qi] = mult.add_ciphertexts(
+                    partial[qi], mult.multiply_ciphertexts_ntt(mask, mask_ntt, payloads[row],
+                                                             payloads_ntt[row]));
+            }
+        }
+        
+        for (size_t qi = 0; qi < masks.size(); qi++) {
+            std::lock_guard<std::mutex> lock(sum_locks[qi]);
+            sums[qi] = mult.add_ciphertexts(sums[qi], partial[qi]);
+        }
+    });
+    
+    std::vector<std::vector<std::vector<ModInt>>> result;
+    result.reserve(sums.size());
+    for (const auto& sum : sums) {
+        result.push_back(mult.relinearize(sum[0], sum[1], sum[2], relin_key));
+    }
+    return result;
+}
+
+} // namespace fhe_cpp
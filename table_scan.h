@@ -0,0 +1,92 @@
+/*
+ * Encrypted table scan
+ * Streams the encrypted rows once and evaluates a whole batch of
+ * queries against each row while it is hot in cache
+ */
+
+#ifndef FHE_TABLE_SCAN_H
+#define FHE_TABLE_SCAN_H
+
+#include "bfv_mult.h"
+#include "thread_pool.h"
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+
+namespace fhe_cpp {
+
+class TableScanner {
+public:
+    // Receives one row's differences, diffs[query] = key_row - target_query
+    using RowSink = std::function<void(size_t row,
+                                       std::vector<std::vector<std::vector<ModInt>>>& diffs)>;
+
+private:
+    const BFVMultiplier& mult;
+    int N;
+    
+    // Rows are scanned in blocks of block_rows, scheduled on the global
+    // pool unless the scanner was given a private one
+    size_t block_rows;
+    std::shared_ptr<ThreadPool> own_pool;
+    std::shared_ptr<ThreadPool> pool() const { return own_pool ? own_pool : ThreadPool::global(); }
+    
+    size_t num_blocks() const { return (keys.size() + block_rows - 1) / block_rows; }
+    
+    // Row store: the key column (e.g. date) and the payload column
+    // (e.g. email), with the payload's NTT form computed at load time
+    std::vector<std::vector<std::vector<ModInt>>> keys;
+    std::vector<std::vector<std::vector<ModInt>>> payloads;
+    std::vector<std::vector<std::vector<ModInt>>> payloads_ntt;
+    
+    // Optional index: client-assigned bucket tag -> rows carrying it
+    std::unordered_map<int64_t, std::vector<size_t>> bucket_rows;
+
+public:
+    // num_threads = 0 shares the process-wide pool; a positive count
+    // gives the scanner its own pool of that size
+    explicit TableScanner(const BFVMultiplier& mult, int num_threads = 0,
+                          size_t block_rows = 8);
+    ~TableScanner() = default;
+    
+    // Append a row; returns its row index
+    // bucket is the client's keyed-hash tag of the key (-1 = not indexed)
+    size_t add_row(const std::vector<std::vector<ModInt>>& key,
+                   const std::vector<std::vector<ModInt>>& payload,
+                   int64_t bucket = -1);
+    
+    // Exact match for many targets in one pass, streamed to sink row by
+    // row (differences are zero on a match). Sink calls are serialized
+    // but arrive in block completion order; only the block being scanned
+    // is held per worker, never the whole [query][row] result
+    void exact_match_batch(
+        const std::vector<std::vector<std::vector<ModInt>>>& targets,
+        const RowSink& sink
+    ) const;
+    
+    // Exact match restricted to the rows tagged with each query's bucket
+    // result[query] = (row, key_row - target_query) for rows in its bucket
+    std::vector<std::vector<std::pair<size_t, std::vector<std::vector<ModInt>>>>>
+    exact_match_indexed(
+        const std::vector<std::vector<std::vector<ModInt>>>& targets,
+        const std::vector<int64_t>& buckets
+    ) const;
+    
+    // SUM aggregate per query: sum over rows of masks[query][row] * payload,
+    // relinearized once per query
+    std::vector<std::vector<std::vector<ModInt>>> sum_batch(
+        const std::vector<std::vector<std::vector<std::vector<ModInt>>>>& masks,
+        const std::vector<std::vector<ModInt>>& relin_key
+    ) const;
+    
+    size_t num_rows() const { return keys.size(); }
+    std::vector<size_t> rows_in_bucket(int64_t bucket) const;
+    int num_threads() const { return pool()->size(); }
+    const std::vector<std::vector<ModInt>>& get_payload(size_t row) const { return payloads.at(row); }
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_TABLE_SCAN_H
@@ -40,7 +40,7 @@ def test_initialization():
     print("=" * 60)
     
     try:
-        fhe = BFVSchemeAccelerated(N=4096, t=65537, q_bits=50)
+        fhe = BFVSchemeAccelerated(N=4096, t=65537, q_bits=50, ntt_bits=60)
         info = fhe.get_backend_info()
         
         print(f"✓ Scheme initialized")
@@ -87,6 +87,7 @@ def test_basic_operations(fhe):
     
     assert diff_result == -100 or diff_result == fhe.t - 100, f"Subtraction failed: {diff_result}"
     print(f"✓ Subtraction: 100 - 200 = {diff_result}")
+    return True
 
 
 def test_multiplication(fhe):
@@ -160,6 +161,10 @@ def test_performance(fhe):
     # Benchmark multiplication
     num_iterations = 5
     
+    instrumented = hasattr(fhe, 'enable_instrumentation') and fhe.enable_instrumentation()
+    if instrumented:
+        fhe.instrumentation_snapshot(reset=True)
+    
     print(f"Running {num_iterations} multiplication operations...")
     start = time.time()
     
@@ -175,6 +180,16 @@ def test_performance(fhe):
     print(f"Average time per multiplication: {avg_time:.3f}s")
     print(f"Throughput: {1/avg_time:.2f} mult/sec")
     
+    if instrumented:
+        snap = fhe.instrumentation_snapshot()
+        fhe.enable_instrumentation(False)
+        for name, stats in sorted(snap['ops'].items()):
+            print(f"  {name:<20} n={stats['count']:<4} "
+                  f"p50={stats['p50_ns'] / 1e6:.3f}ms p99={stats['p99_ns'] / 1e6:.3f}ms")
+        counters = snap['counters']
+        print(f"  NTTs: {counters['ntt_forward']} forward, {counters['ntt_inverse']} inverse; "
+              f"key switches: {counters['key_switch']}")
+    
     if CPP_AVAILABLE and info['backend'].startswith('C++'):
         print("✓ Using fast C++ backend")
         if avg_time < 0.5:
@@ -183,6 +198,7 @@ def test_performance(fhe):
             print("⚠ Performance is slower than expected")
     else:
         print("⚠ Using Python fallback (slower)")
+    return True
 
 
 def test_exact_match_scenario(fhe):
@@ -214,8 +230,334 @@ def test_exact_match_scenario(fhe):
     return False
 
 
+def test_lookup_table(fhe):
+    """Test lookup table interpolation over Z_t"""
+    print("\n" + "=" * 60)
+    print("TEST 7: Lookup Table Interpolation")
+    print("=" * 60)
+    
+    if not CPP_AVAILABLE:
+        print("⚠ Skipped (requires C++ backend)")
+        return True
+    
+    import fhe_fast_mult
+    table = [7, 3, 65000, 0, 42, 12345, 1]
+    lut = fhe_fast_mult.LookupTable(np.array(table, dtype=np.int64), fhe.t)
+    
+    for x, expected in enumerate(table):
+        result = lut.evaluate(x)
+        if result != expected:
+            print(f"✗ table[{x}] = {result} (expected {expected})")
+            return False
+    
+    print(f"✓ Interpolated {lut.size()} entries "
+          f"(degree {len(lut.coefficients()) - 1})")
+    
+    # Encrypted lookups; small t leaves noise budget for the evaluation
+    enc = BFVSchemeAccelerated(N=1024, t=17, ntt_bits=60)
+    enc.key_generation()
+    enc.generate_relin_key()
+    small = [7, 3, 12, 0, 5]
+    
+    for x, expected in enumerate(small):
+        ct = enc.lookup(enc.encrypt(enc.encode(x)), small)
+        result = enc.decode(enc.decrypt(ct)) % enc.t
+        if result != expected:
+            print(f"✗ Encrypted table[{x}] = {result} (expected {expected})")
+            return False
+    
+    print(f"✓ Encrypted lookups match all {len(small)} entries")
+    return True
+
+
+def test_batch_encoding(fhe):
+    """Test SIMD slot encoding: round trip, slot-wise products, encrypted ops"""
+    print("\n" + "=" * 60)
+    print("TEST 8: Batch Encoding")
+    print("=" * 60)
+    
+    if not CPP_AVAILABLE:
+        print("⚠ Skipped (requires C++ backend)")
+        return True
+    
+    import fhe_fast_mult
+    N = 64
+    encoder = fhe_fast_mult.BatchEncoder(N, fhe.t)
+    ntt = fhe_fast_mult.NTT(N, fhe.t)
+    
+    a = np.random.randint(0, fhe.t, size=N).astype(np.int64)
+    b = np.random.randint(0, fhe.t, size=N).astype(np.int64)
+    pa, pb = encoder.encode_batch([a, b])
+    
+    if not np.array_equal(encoder.decode(pa), a):
+        print("✗ Decode(encode(a)) != a")
+        return False
+    
+    # Polynomial product mod t is the slot-wise product
+    product = encoder.decode(ntt.multiply(pa, pb))
+    if not np.array_equal(product, (a * b) % fhe.t):
+        print("✗ Polynomial product is not slot-wise")
+        return False
+    
+    print(f"✓ {encoder.slot_count()} slots, slot-wise products match")
+    
+    # Encrypted slot arithmetic: encode, encrypt, operate, decrypt, decode
+    enc = BFVSchemeAccelerated(N=1024, t=65537, ntt_bits=60)
+    enc.key_generation()
+    enc.generate_relin_key()
+    t = enc.t
+    x = np.random.randint(0, t, size=enc.N).astype(np.int64)
+    y = np.random.randint(0, t, size=enc.N).astype(np.int64)
+    px, py = enc.encode_batch([x, y])
+    cx, cy = enc.encrypt(px), enc.encrypt(py)
+    
+    results = {
+        'add': (enc.add(cx, cy), (x + y) % t),
+        'multiply': (enc.relinearize(enc.multiply(cx, cy)), (x * y) % t),
+        'multiply_plain': (enc.multiply_plain(cx, py), (x * y) % t),
+    }
+    decoded = enc.decode_batch([enc.decrypt(ct) for ct, _ in results.values()])
+    for (name, (_, expected)), slots in zip(results.items(), decoded):
+        if not np.array_equal(np.array(slots) % t, expected):
+            print(f"✗ Encrypted slot-wise {name} does not decrypt to the expected slots")
+            return False
+    
+    print(f"✓ Encrypted slot-wise add, multiply and multiply_plain match over {enc.N} slots")
+    return True
+
+
+def test_polynomial_evaluation():
+    """Decrypt homomorphic polynomial evaluations and compare in the clear"""
+    print("\n" + "=" * 60)
+    print("TEST 9: Polynomial Evaluation")
+    print("=" * 60)
+    
+    if not CPP_AVAILABLE:
+        print("⚠ Skipped (requires C++ backend)")
+        return True
+    
+    # Small t leaves noise budget for the depth-2 evaluation
+    fhe = BFVSchemeAccelerated(N=1024, t=17, ntt_bits=60)
+    fhe.key_generation()
+    fhe.generate_relin_key()
+    coeffs = [3, 2, 5, 1, 0, 7]
+    
+    for m in [0, 1, 4, 9, 16]:
+        ct = fhe.evaluate_polynomial(fhe.encrypt(fhe.encode(m)), coeffs)
+        result = fhe.decode(fhe.decrypt(ct)) % fhe.t
+        expected = sum(c * m ** i for i, c in enumerate(coeffs)) % fhe.t
+        if result != expected:
+            print(f"✗ p({m}) = {result} (expected {expected})")
+            return False
+    
+    print(f"✓ Degree-{len(coeffs) - 1} polynomial matches at 5 points")
+    return True
+
+
+def test_rotations():
+    """Decrypt slot rotations and rotate-and-sum results"""
+    print("\n" + "=" * 60)
+    print("TEST 10: Rotations and Slot Sums")
+    print("=" * 60)
+    
+    if not CPP_AVAILABLE:
+        print("⚠ Skipped (requires C++ backend)")
+        return True
+    
+    # A small ring and t leave noise budget to fold a product over all slots
+    N, t = 256, 7681
+    fhe = BFVSchemeAccelerated(N=N, t=t, ntt_bits=60)
+    fhe.key_generation()
+    fhe.generate_relin_key()
+    fhe.generate_galois_keys()
+    
+    values = np.random.randint(0, t, size=N).astype(np.int64)
+    mask = np.random.randint(0, 2, size=N).astype(np.int64)
+    ct = fhe.encrypt(fhe.encode(values))
+    
+    # Left rotation by one within each row of N/2 slots
+    lz = fhe.lazy()
+    (rotated,) = lz.evaluate(lz.rotate(ct, fhe.cpp_galois.rotation_elt(1)))
+    expected = np.concatenate([np.roll(row, -1) for row in values.reshape(2, N // 2)])
+    if not np.array_equal(fhe.decode(fhe.decrypt(rotated), N) % t, expected):
+        print("✗ Rotation by one slot does not decrypt to the rotated values")
+        return False
+    
+    total = fhe.decode(fhe.decrypt(fhe.sum_slots(ct)), N) % t
+    if not np.all(total == values.sum() % t):
+        print("✗ sum_slots does not decrypt to the slot total")
+        return False
+    
+    masked = fhe.masked_sum(ct, fhe.encrypt(fhe.encode(mask)))
+    if not np.all(fhe.decode(fhe.decrypt(masked), N) % t == (values * mask).sum() % t):
+        print("✗ masked_sum does not decrypt to the masked total")
+        return False
+    
+    print(f"✓ Rotation, sum_slots and masked_sum match over {N} slots")
+    return True
+
+
+def test_planned_scheme():
+    """A scheme built from a parameter plan uses the plan's parameters"""
+    print("\n" + "=" * 60)
+    print("TEST 11: Planned Parameters")
+    print("=" * 60)
+    
+    if not CPP_AVAILABLE:
+        print("⚠ Skipped (requires C++ backend)")
+        return True
+    
+    from custom_fhe.bfv_accelerated import plan_parameters
+    
+    rotations = 3
+    plan = plan_parameters(0, rotations=rotations)
+    fhe = BFVSchemeAccelerated.from_plan(plan)
+    if fhe.q != plan.moduli[0] or fhe.cpp_mult.decomp_bits() != plan.decomp_bits:
+        print(f"✗ Scheme has q={fhe.q}, decomp_bits={fhe.cpp_mult.decomp_bits()} "
+              f"(plan: q={plan.moduli[0]}, decomp_bits={plan.decomp_bits})")
+        return False
+    
+    fhe.key_generation()
+    elt = fhe.cpp_galois.rotation_elt(1)
+    fhe.generate_galois_keys([elt])
+    
+    values = np.random.randint(0, fhe.t, size=plan.N).astype(np.int64)
+    lz = fhe.lazy()
+    node = lz.input(fhe.encrypt(fhe.encode(values)))
+    for _ in range(rotations):
+        node = lz.rotate(node, elt)
+    (ct,) = lz.evaluate(node)
+    
+    expected = np.concatenate([np.roll(row, -rotations)
+                               for row in values.reshape(2, plan.N // 2)])
+    if not np.array_equal(fhe.decode(fhe.decrypt(ct), plan.N) % fhe.t, expected):
+        print("✗ Planned rotations do not decrypt to the rotated values")
+        return False
+    
+    print(f"✓ N={plan.N}, {plan.modulus_bits}-bit q, {plan.decomp_bits}-bit digits: "
+          f"{rotations} rotations decrypt")
+    return True
+
+
+def test_noise_estimates():
+    """Tracked noise estimates against the exact budget"""
+    print("\n" + "=" * 60)
+    print("TEST 12: Noise Estimates")
+    print("=" * 60)
+    
+    if not CPP_AVAILABLE:
+        print("⚠ Skipped (requires C++ backend)")
+        return True
+    
+    fhe = BFVSchemeAccelerated(N=1024, t=257, ntt_bits=60)
+    fhe.key_generation()
+    fhe.generate_relin_key()
+    elt = fhe.cpp_galois.rotation_elt(1)
+    fhe.generate_galois_keys([elt])
+    
+    ct = fhe.encrypt(fhe.encode(3))
+    product = fhe.relinearize(fhe.multiply(ct, ct))
+    lz = fhe.lazy()
+    (rotated,) = lz.evaluate(lz.rotate(ct, elt))
+    
+    for name, c in [("fresh", ct), ("multiply+relinearize", product), ("rotate", rotated)]:
+        estimate = fhe.estimated_noise_budget(c)
+        measured = fhe.noise_budget(c)
+        print(f"  {name}: estimated {estimate:.1f} bits, measured {measured} bits")
+        if estimate is None or not 0 < estimate <= measured + 1 or measured - estimate > 8:
+            print(f"✗ {name} estimate is not a close lower bound")
+            return False
+    
+    print("✓ Estimates are conservative and within 8 bits")
+    return True
+
+
+def test_async_api():
+    """Awaitable operations agree with the blocking ones"""
+    print("\n" + "=" * 60)
+    print("TEST 13: Async API")
+    print("=" * 60)
+    
+    if not CPP_AVAILABLE:
+        print("⚠ Skipped (requires C++ backend)")
+        return True
+    
+    import asyncio
+    
+    fhe = BFVSchemeAccelerated(N=1024, t=65537, ntt_bits=60)
+    fhe.key_generation()
+    fhe.generate_relin_key()
+    t = fhe.t
+    
+    x = np.random.randint(0, t, size=fhe.N).astype(np.int64)
+    y = np.random.randint(0, t, size=fhe.N).astype(np.int64)
+    px, py = fhe.encode_batch([x, y])
+    cx, cy = fhe.encrypt(px), fhe.encrypt(py)
+    
+    keys = [20260205, 20260225, 20260301, 20260225]
+    rows = [{'date': fhe.encrypt(fhe.encode(k)), 'email': fhe.encrypt(fhe.encode(i + 1))}
+            for i, k in enumerate(keys)]
+    scanner = fhe.create_table_scanner(rows)
+    targets = [fhe.encrypt(fhe.encode(v)) for v in (20260225, 20260999)]
+    
+    def same(a, b):
+        return [[int(v) for v in c] for c in a.get_components()] == \
+            [[int(v) for v in c] for c in b.get_components()]
+    
+    async def run():
+        # Independent operations in flight together
+        product, diffs, plains = await asyncio.gather(
+            fhe.multiply_async(cx, cy),
+            fhe.exact_match_batch_async(scanner, targets),
+            fhe.decrypt_batch_async([cx, cy]))
+        relin = await fhe.relinearize_async(product)
+        single = await fhe.decrypt_async(relin)
+        
+        # Native failures reach the awaiting coroutine
+        rejected = False
+        try:
+            await fhe.exact_match_batch_async(scanner, [product])
+        except ValueError:
+            rejected = True
+        return product, relin, single, plains, diffs, rejected
+    
+    product, relin, single, plains, diffs, rejected = asyncio.run(run())
+    
+    if not same(product, fhe.multiply(cx, cy)) or not same(relin, fhe.relinearize(product)):
+        print("✗ multiply_async / relinearize_async differ from the blocking calls")
+        return False
+    print("✓ multiply_async and relinearize_async match")
+    
+    expected = [fhe.decrypt(ct) for ct in (cx, cy, relin)]
+    if not all(np.array_equal(a.poly, b.poly) for a, b in zip(plains + [single], expected)):
+        print("✗ decrypt_async / decrypt_batch_async differ from decrypt")
+        return False
+    if not np.array_equal(np.array(fhe.decode_batch([single])[0]) % t, (x * y) % t):
+        print("✗ Awaited product does not decrypt to the slot-wise product")
+        return False
+    print("✓ decrypt_async and decrypt_batch_async match")
+    
+    blocking = fhe.exact_match_batch(scanner, targets)
+    if len(diffs) != len(targets) or any(
+            len(d) != len(keys) or not all(same(a, b) for a, b in zip(d, s))
+            for d, s in zip(diffs, blocking)):
+        print("✗ exact_match_batch_async differs from exact_match_batch")
+        return False
+    matched = [[i for i, ct in enumerate(d) if fhe.decode(fhe.decrypt(ct)) == 0] for d in diffs]
+    if matched != [[1, 3], []]:
+        print(f"✗ Awaited scan matched rows {matched}")
+        return False
+    print("✓ exact_match_batch_async matches rows [1, 3]")
+    
+    if not rejected:
+        print("✗ A size-3 target was not rejected through the future")
+        return False
+    print("✓ Native errors are raised from the awaited future")
+    return True
+
+
 def run_all_tests():
-    """Run complete test suite"""
+    """Run complete test suite; returns True when every test passed"""
     print("\n" + "=" * 70)
     print(" C++ ACCELERATED FHE - COMPREHENSIVE TEST SUITE")
     print("=" * 70)
@@ -227,48 +569,57 @@ def run_all_tests():
     fhe = test_initialization()
     if fhe is None:
         print("\n✗ Cannot proceed without successful initialization")
-        return
+        return False
     
-    try:
-        # Test 3: Basic operations
-        test_basic_operations(fhe)
-        
-        # Test 4: Multiplication (THE BIG TEST)
-        mult_success = test_multiplication(fhe)
-        
-        # Test 5: Performance
-        test_performance(fhe)
-        
-        # Test 6: Original use case
-        match_success = test_exact_match_scenario(fhe)
-        
-        # Summary
-        print("\n" + "=" * 70)
-        print("TEST SUMMARY")
-        print("=" * 70)
-        
-        if mult_success:
-            print("✓ MULTIPLICATION WORKS! 🎉")
-        else:
-            print("⚠ Multiplication had some issues")
-        
-        if match_success:
-            print("✓ Exact match scenario works")
-        
-        print("\n" + "=" * 70)
-        
-        if mult_success:
-            print("\n🎉 SUCCESS! You now have working FHE multiplication!")
-            if CPP_AVAILABLE:
-                print("✓ Using fast C++ NTT backend")
-            else:
-                print("⚠ Using Python fallback (consider building C++ for speed)")
-        
-    except Exception as e:
-        print(f"\n✗ Test suite failed with error: {e}")
-        import traceback
-        traceback.print_exc()
+    tests = [
+        ("Basic operations", lambda: test_basic_operations(fhe)),
+        ("Multiplication", lambda: test_multiplication(fhe)),
+        ("Performance", lambda: test_performance(fhe)),
+        ("Exact match scenario", lambda: test_exact_match_scenario(fhe)),
+        ("Lookup tables", lambda: test_lookup_table(fhe)),
+        ("Batch encoding", lambda: test_batch_encoding(fhe)),
+        ("Polynomial evaluation", test_polynomial_evaluation),
+        ("Rotations", test_rotations),
+        ("Planned parameters", test_planned_scheme),
+        ("Noise estimates", test_noise_estimates),
+        ("Async API", test_async_api),
+    ]
+    
+    results = []
+    for name, run in tests:
+        try:
+            ok = bool(run())
+        except Exception as e:
+            import traceback
+            print(f"\n✗ {name} raised: {e}")
+            traceback.print_exc()
+            ok = False
+        results.append((name, ok))
+    
+    # Summary
+    print("\n" + "=" * 70)
+    print("TEST SUMMARY")
+    print("=" * 70)
+    
+    for name, ok in results:
+        print(f"{'✓' if ok else '✗'} {name}")
+    
+    failed = sum(1 for _, ok in results if not ok)
+    print(f"\n{len(results) - failed} passed, {failed} failed")
+    
+    info = fhe.get_backend_info()
+    if info['backend'].startswith('C++'):
+        print("✓ Using fast C++ NTT backend")
+    else:
+        print("⚠ Using Python fallback (consider building C++ for speed)")
+    
+    print("=" * 70)
+    return failed == 0
 
 
 if __name__ == "__main__":
-    run_all_tests()
+    # --require-cpp: a missing extension is a failure, not a skip
+    if '--require-cpp' in sys.argv and not CPP_AVAILABLE:
+        print("Error: fhe_fast_mult could not be imported")
+        sys.exit(1)
+    sys.exit(0 if run_all_tests() else 1)
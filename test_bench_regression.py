@@ -0,0 +1,224 @@
+"""
+Test Suite for the Benchmark Regression Harness
+Comparisons over synthetic fhe_bench results, the compare command's exit
+status and reports, and (with --bench PATH) a stored run of the real suite
+
+Usage:
+    python test_bench_regression.py [--bench PATH]
+"""
+
+import json
+import os
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+import bench_regression
+
+CPU = "Synthetic CPU @ 1.00GHz"
+
+
+def bench(name, samples, N=1024, bits=60, threads=1):
+    return {'name': name, 'N': N, 'modulus_bits': bits, 'threads': threads,
+            'samples_ns': list(samples)}
+
+
+def result(rev, benchmarks, cpu=CPU):
+    return {'revision': rev, 'context': {'cpu_model': cpu}, 'benchmarks': benchmarks}
+
+
+def synthetic_pair():
+    """Baseline and candidate with one regression, one improvement, one unchanged"""
+    steady = [1000 + (i % 5) for i in range(20)]
+    baseline = result('base', [
+        bench('multiply', steady),
+        bench('relinearize', steady),
+        bench('ntt_forward', steady),
+        bench('rotate', steady),
+    ])
+    candidate = result('cand', [
+        bench('multiply', [1300 + (i % 5) for i in range(20)]),
+        bench('relinearize', [700 + (i % 5) for i in range(20)]),
+        bench('ntt_forward', [1001 + (i % 5) for i in range(20)]),
+        bench('rotate', steady, N=4096),            # No baseline for this key
+    ])
+    return baseline, candidate
+
+
+def store_pair(store, baseline, candidate):
+    for r in (baseline, candidate):
+        path = bench_regression.result_path(store, r['context']['cpu_model'], r['revision'])
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        with open(path, 'w') as f:
+            json.dump(r, f)
+
+
+def test_statistics():
+    """Median and bootstrap interval"""
+    print("=" * 60)
+    print("TEST 1: Statistics")
+    print("=" * 60)
+    
+    ok = bench_regression.median([3, 1, 2]) == 2
+    ok &= bench_regression.median([4, 1, 3, 2]) == 2.5
+    
+    base = [100.0] * 10
+    lo, hi = bench_regression.bootstrap_ratio_ci(base, [150.0] * 10)
+    ok &= abs(lo - 0.5) < 1e-12 and abs(hi - 0.5) < 1e-12
+    
+    # Deterministic for a fixed seed, and the interval contains the point change
+    cand = [110.0 + i for i in range(10)]
+    noisy = [95.0 + i for i in range(10)]
+    first = bench_regression.bootstrap_ratio_ci(noisy, cand, seed=3)
+    ok &= first == bench_regression.bootstrap_ratio_ci(noisy, cand, seed=3)
+    change = bench_regression.median(cand) / bench_regression.median(noisy) - 1
+    ok &= first[0] <= change <= first[1]
+    
+    print(f"{'✓' if ok else '✗'} median / bootstrap CI")
+    print()
+    return ok
+
+
+def test_compare():
+    """Verdicts of a synthetic comparison"""
+    print("=" * 60)
+    print("TEST 2: Comparison Verdicts")
+    print("=" * 60)
+    
+    baseline, candidate = synthetic_pair()
+    report = bench_regression.compare(baseline, candidate, iterations=500)
+    verdicts = {r['name']: r['verdict'] for r in report['results']}
+    print(f"Verdicts: {verdicts}")
+    
+    ok = verdicts == {'multiply': 'regression', 'relinearize': 'improvement',
+                      'ntt_forward': 'unchanged'}
+    multiply = next(r for r in report['results'] if r['name'] == 'multiply')
+    ok &= abs(multiply['change'] - 0.3) < 0.01
+    ok &= multiply['ci_low'] > 0.05 and multiply['baseline_reps'] == 20
+    
+    # A wide threshold turns the regression into noise
+    loose = bench_regression.compare(baseline, candidate, threshold=0.5, iterations=500)
+    ok &= all(r['verdict'] == 'unchanged' for r in loose['results'])
+    
+    text = bench_regression.markdown_report(report)
+    ok &= "| multiply | 1024 | 60 | 1 |" in text and "REGRESSION" in text
+    ok &= "1 regressions, 1 improvements, 1 unchanged" in text
+    ok &= "Warning" not in text
+    
+    other_cpu = dict(baseline, context={'cpu_model': 'Other CPU'})
+    ok &= "**Warning:** baseline was recorded on Other CPU" in \
+        bench_regression.markdown_report(bench_regression.compare(other_cpu, candidate,
+                                                                  iterations=100))
+    
+    print(f"{'✓' if ok else '✗'} regression / improvement / unchanged")
+    print()
+    return ok
+
+
+def test_compare_command():
+    """compare against stored results: reports and exit status"""
+    print("=" * 60)
+    print("TEST 3: compare Command")
+    print("=" * 60)
+    
+    baseline, candidate = synthetic_pair()
+    with tempfile.TemporaryDirectory() as tmp:
+        store = os.path.join(tmp, 'store')
+        store_pair(store, baseline, candidate)
+        md = os.path.join(tmp, 'report.md')
+        js = os.path.join(tmp, 'report.json')
+        
+        args = ['--store', store, 'compare', '--baseline', 'base', '--candidate', 'cand',
+                '--iterations', '500']
+        ok = bench_regression.main(args) == 0
+        ok &= bench_regression.main(args + ['--fail-on-regression', '--markdown', md,
+                                            '--json', js]) == 1
+        with open(md) as f:
+            ok &= "REGRESSION" in f.read()
+        with open(js) as f:
+            report = json.load(f)
+        ok &= report['baseline'] == 'base' and report['candidate'] == 'cand'
+        ok &= sum(r['verdict'] == 'regression' for r in report['results']) == 1
+        
+        # Swapped, the improvement is the regression that fails the run
+        ok &= bench_regression.main(['--store', store, 'compare', '--baseline', 'cand',
+                                     '--candidate', 'base', '--iterations', '500',
+                                     '--fail-on-regression']) == 1
+        
+        try:
+            bench_regression.main(['--store', store, 'compare', '--baseline', 'missing',
+                                   '--candidate', 'cand'])
+            ok = False
+        except FileNotFoundError:
+            pass
+    
+    print(f"{'✓' if ok else '✗'} exit status and reports")
+    print()
+    return ok
+
+
+def test_stored_run(bench):
+    """run stores the real suite's output, and compare reads it back"""
+    print("=" * 60)
+    print("TEST 4: Stored fhe_bench Run")
+    print("=" * 60)
+    
+    with tempfile.TemporaryDirectory() as tmp:
+        store = os.path.join(tmp, 'store')
+        for rev in ('first', 'second'):
+            if bench_regression.main(['--store', store, 'run', '--bench', bench,
+                                      '--revision', rev, '--', '--smoke']) != 0:
+                return False
+        
+        stored = bench_regression.load_result(store, 'first')
+        ok = stored['revision'] == 'first' and stored['bench_args'] == ['--smoke']
+        ok &= len(stored['benchmarks']) > 0
+        ok &= all(len(b['samples_ns']) == stored['context']['reps']
+                  for b in stored['benchmarks'])
+        
+        second = bench_regression.load_result(store, 'second', stored['context']['cpu_model'])
+        report = bench_regression.compare(stored, second, iterations=200)
+        ok &= len(report['results']) == len(second['benchmarks'])
+        ok &= bench_regression.main(['--store', store, 'compare', '--baseline', 'first',
+                                     '--candidate', 'second', '--iterations', '200']) == 0
+    
+    print(f"{'✓' if ok else '✗'} run / compare round trip")
+    print()
+    return ok
+
+
+def run_all_tests(bench=None):
+    """Run complete test suite; returns True when every test passed"""
+    tests = [
+        ("Statistics", test_statistics),
+        ("Comparison verdicts", test_compare),
+        ("compare command", test_compare_command),
+    ]
+    if bench:
+        tests.append(("Stored fhe_bench run", lambda: test_stored_run(bench)))
+    
+    results = []
+    for name, run in tests:
+        try:
+            ok = bool(run())
+        except Exception as e:
+            import traceback
+            print(f"\n✗ {name} raised: {e}")
+            traceback.print_exc()
+            ok = False
+        results.append((name, ok))
+    
+    passed = sum(1 for _, ok in results if ok)
+    failed = len(results) - passed
+    for name, ok in results:
+        print(f"{'✓' if ok else '✗'} {name}")
+    print(f"\n{passed} passed, {failed} failed")
+    return failed == 0
+
+
+if __name__ == "__main__":
+    bench_path = None
+    if '--bench' in sys.argv:
+        bench_path = sys.argv[sys.argv.index('--bench') + 1]
+    sys.exit(0 if run_all_tests(bench_path) else 1)
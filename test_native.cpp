@@ -0,0 +1,1145 @@
+/*
+ * Native test suite (fhe_test)
+ * Every check runs the real scheme end to end: keys from KeyGenerator,
+ * encryption with Encryptor, the operation under test, then Decryptor,
+ * compared against the same computation in the clear.
+ *
+ * Usage: fhe_test [name-substring ...]
+ * Exits non-zero when any selected test fails.
+ */
+
+#include "ntt.h"
+#include "ntt_tuning.h"
+#include "gadget.h"
+#include "bfv_mult.h"
+#include "batch_encoder.h"
+#include "lookup_table.h"
+#include "encryptor.h"
+#include "decryptor.h"
+#include "galois.h"
+#include "linear_algebra.h"
+#include "string_match.h"
+#include "table_scan.h"
+#include "thread_pool.h"
+#include "param_planner.h"
+#include "noise.h"
+#include "modulus_switch.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace fhe_cpp;
+
+namespace {
+
+typedef std::vector<std::vector<ModInt>> Ciphertext;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::printf("  check failed (line %d): %s\n", __LINE__, #cond); \
+            return false; \
+        } \
+    } while (0)
+
+// Keys, encryptor, decryptor and evaluator for one parameter set
+struct Context {
+    NTT ntt;
+    ModInt t;
+    KeyGenerator keygen;
+    Encryptor encryptor;
+    Decryptor decryptor;
+    BFVMultiplier mult;
+    Ciphertext relin_key;
+    
+    Context(int N, ModInt t, int bits = 60, int decomp_bits = DEFAULT_DECOMP_BITS)
+        : ntt(N, find_ntt_prime(N, bits)), t(t),
+          keygen(ntt, 3.2, 1),
+          encryptor(ntt, t, keygen.public_key(), 3.2, 2),
+          decryptor(ntt, t, keygen.secret_key()),
+          mult(N, ntt.get_q(), t, decomp_bits),
+          relin_key(keygen.relin_key(decomp_bits)) {}
+    
+    int N() const { return ntt.get_N(); }
+    
+    // Coefficient encoding of a constant (every slot of the product ring)
+    Ciphertext encrypt_constant(ModInt m) {
+        std::vector<ModInt> plain(N(), 0);
+        plain[0] = ((m % t) + t) % t;
+        return encryptor.encrypt(plain);
+    }
+    
+    ModInt decrypt_constant(const Ciphertext& ct) const {
+        return decryptor.decrypt(ct)[0];
+    }
+};
+
+std::vector<ModInt> random_values(int count, ModInt bound, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<ModInt> values(count);
+    for (auto& v : values) {
+        v = (ModInt)(rng() % (uint64_t)bound);
+    }
+    return values;
+}
+
+// ============================================================================
+// Thread pool
+// ============================================================================
+
+bool test_thread_pool() {
+    ThreadPool pool(4, false);
+    
+    // Every index runs exactly once, including counts below the worker
+    // count and nested calls (which run inline on the worker)
+    for (size_t count : {1, 3, 4, 1000}) {
+        std::vector<std::atomic<int>> hits(count);
+        pool.parallel_for(count, [&](size_t i) {
+            hits[i]++;
+            pool.parallel_for(2, [&](size_t) {});
+        });
+        for (const auto& h : hits) CHECK(h.load() == 1);
+    }
+    
+    // The first exception reaches the caller once all iterations finished
+    std::atomic<int> ran(0);
+    bool rethrown = false;
+    try {
+        pool.parallel_for(64, [&](size_t i) {
+            ran++;
+            if (i == 17) throw std::runtime_error("iteration failed");
+        });
+    } catch (const std::runtime_error&) {
+        rethrown = true;
+    }
+    CHECK(rethrown);
+    CHECK(ran.load() == 64);
+    
+    // submit: many small tasks from outside the pool all run, and a
+    // task's exception is delivered through its future
+    std::atomic<int> done(0);
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 2000; i++) {
+        futures.push_back(pool.submit([&done] { done++; }));
+    }
+    for (auto& f : futures) f.get();
+    CHECK(done.load() == 2000);
+    
+    auto failing = pool.submit([] { throw std::invalid_argument("task failed"); });
+    bool delivered = false;
+    try {
+        failing.get();
+    } catch (const std::invalid_argument&) {
+        delivered = true;
+    }
+    CHECK(delivered);
+    
+    // The pool stays usable after failures
+    std::vector<std::atomic<int>> again(100);
+    pool.parallel_for(again.size(), [&](size_t i) { again[i]++; });
+    for (const auto& h : again) CHECK(h.load() == 1);
+    
+    // A worker of one pool calling into another dispatches to the other
+    // pool's workers instead of running inline, and its submits land in
+    // the other pool's queues
+    ThreadPool other(2, false);
+    pool.reset_stats();
+    std::vector<std::atomic<int>> crossed(50);
+    std::atomic<int> submitted(0);
+    pool.submit([&] {
+        other.parallel_for(crossed.size(), [&](size_t i) { crossed[i]++; });
+        other.submit([&submitted] { submitted++; }).get();
+    }).get();
+    for (const auto& h : crossed) CHECK(h.load() == 1);
+    CHECK(submitted.load() == 1);
+    CHECK(other.stats().parallel_for_calls == 1 && other.stats().inline_calls == 0);
+    CHECK(pool.stats().parallel_for_calls == 0);
+    return true;
+}
+
+bool test_global_pool_release() {
+    // The last reference to a replaced global pool is dropped by one of
+    // its own workers; the pool is joined from another thread
+    auto old = ThreadPool::global();
+    std::weak_ptr<ThreadPool> weak = old;
+    std::promise<void> replaced;
+    std::shared_future<void> gate = replaced.get_future().share();
+    auto done = old->submit([pool = old, gate]() mutable {
+        gate.wait();
+        pool.reset();
+    });
+    old.reset();
+    
+    ThreadPool::configure_global(2, false);
+    replaced.set_value();
+    done.get();
+    CHECK(weak.expired());
+    CHECK(ThreadPool::global()->size() == 2);
+    
+    // Reconfiguring from a worker of the global pool releases that pool
+    // on its own worker as well
+    auto current = ThreadPool::global();
+    current->submit([] { ThreadPool::configure_global(0, false); }).get();
+    CHECK(ThreadPool::global() != current);
+    current.reset();
+    return true;
+}
+
+// ============================================================================
+// NTT tuning
+// ============================================================================
+
+bool test_ntt_tuning() {
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("fhe_test_tuning_" + std::to_string(std::random_device()()) + ".tsv")).string();
+    int N = 64;
+    ModInt q = find_ntt_prime(N, 30);
+    
+    // A profile from before the threading column gets the default threshold
+    {
+        std::ofstream out(path);
+        out << NttTuner::cpu_model() << "\t" << N << "\t30\tmerged\t1.0\t1.0\n";
+    }
+    NttTuner::set_profile_path(path);
+    CHECK(NttTuner::select(N, 30) == NttVariant::Merged);
+    CHECK(NttTuner::parallel_threshold(N, 30) == NttTuner::default_parallel_threshold());
+    
+    // Tuning records both dimensions, and new transforms pick them up
+    auto tuned = NttTuner::tune({N}, {30}, 3, true);
+    CHECK(tuned.size() == 1 && tuned[0].parallel_batch >= 1);
+    NttTuner::set_profile_path(path);   // Reload from disk
+    NTT ntt(N, q);
+    CHECK(ntt.get_variant() == tuned[0].variant);
+    CHECK(ntt.get_parallel_batch() == (size_t)tuned[0].parallel_batch);
+    
+    // Serial and pool batches agree with single transforms
+    for (size_t count : {(size_t)1, ntt.get_parallel_batch(), ntt.get_parallel_batch() + 3}) {
+        std::vector<std::vector<ModInt>> polys;
+        for (size_t i = 0; i < count; i++) polys.push_back(random_values(N, q, 70 + i));
+        auto expected = polys;
+        for (auto& p : expected) ntt.forward(p);
+        ntt.forward_batch(polys);
+        CHECK(polys == expected);
+        ntt.inverse_batch(polys);
+        for (auto& p : expected) ntt.inverse(p);
+        CHECK(polys == expected);
+    }
+    
+    std::filesystem::remove(path);
+    NttTuner::set_profile_path("");
+    return true;
+}
+
+// ============================================================================
+// Multiplication and relinearization
+// ============================================================================
+
+bool test_gadget_recompose() {
+    int N = 64;
+    ModInt q = find_ntt_prime(N, 60);
+    
+    for (int bits : {0, 12, 16, 30}) {
+        GadgetDecomposition gadget(N, q, bits);
+        std::vector<ModInt> poly = random_values(N, q, bits + 1);
+        auto digits = gadget.decompose(poly);
+        CHECK((int)digits.size() == gadget.num_digits());
+        
+        ModInt bound = bits == 0 ? q / 2 : ((ModInt)1 << (gadget.digit_bits() - 1)) + 1;
+        for (int i = 0; i < N; i++) {
+            ModInt sum = 0;
+            for (int j = 0; j < gadget.num_digits(); j++) {
+                ModInt d = digits[j][i];
+                ModInt centered = d > q / 2 ? d - q : d;
+                CHECK(centered <= bound && centered >= -bound);
+                sum = (ModInt)(((__int128)sum + (__int128)d * gadget.power(j)) % q);
+            }
+            CHECK(sum == poly[i]);
+        }
+    }
+    return true;
+}
+
+bool test_multiply_relinearize_slots() {
+    int N = 1024;
+    ModInt t = 65537;
+    Context ctx(N, t);
+    BatchEncoder encoder(N, t);
+    
+    std::vector<ModInt> a = random_values(N, t, 11);
+    std::vector<ModInt> b = random_values(N, t, 12);
+    Ciphertext ct_a = ctx.encryptor.encrypt(encoder.encode(a));
+    Ciphertext ct_b = ctx.encryptor.encrypt(encoder.encode(b));
+    
+    Ciphertext product = ctx.mult.multiply_relinearize(ct_a, ct_b, ctx.relin_key);
+    CHECK(product.size() == 2);
+    CHECK(ctx.decryptor.invariant_noise_budget(product) > 0);
+    
+    std::vector<ModInt> slots = encoder.decode(ctx.decryptor.decrypt(product));
+    for (int i = 0; i < N; i++) {
+        CHECK(slots[i] == (ModInt)((__int128)a[i] * b[i] % t));
+    }
+    
+    // The size-3 product decrypts to the same message before relinearization
+    Ciphertext d = ctx.mult.multiply_ciphertexts(ct_a[0], ct_a[1], ct_b[0], ct_b[1]);
+    CHECK(encoder.decode(ctx.decryptor.decrypt(d)) == slots);
+    return true;
+}
+
+bool test_slot_arithmetic() {
+    int N = 1024;
+    ModInt t = 65537;
+    Context ctx(N, t);
+    BatchEncoder encoder(N, t);
+    
+    std::vector<ModInt> a = random_values(N, t, 13);
+    std::vector<ModInt> b = random_values(N, t, 14);
+    auto plains = encoder.encode_batch({a, b});
+    CHECK(encoder.decode_batch(plains) == (std::vector<std::vector<ModInt>>{a, b}));
+    
+    Ciphertext ct_a = ctx.encryptor.encrypt(plains[0]);
+    Ciphertext ct_b = ctx.encryptor.encrypt(plains[1]);
+    std::vector<Ciphertext> results = {
+        ctx.mult.add_ciphertexts(ct_a, ct_b),
+        ctx.mult.multiply_plain(ct_a, plains[1]),
+        ctx.mult.multiply_scalar(ct_a, 3),
+        ctx.mult.add_scalar(ct_a, 5),
+    };
+    std::vector<std::vector<ModInt>> decrypted;
+    for (const auto& ct : results) {
+        decrypted.push_back(ctx.decryptor.decrypt(ct));
+    }
+    auto slots = encoder.decode_batch(decrypted);
+    
+    for (int i = 0; i < N; i++) {
+        CHECK(slots[0][i] == (a[i] + b[i]) % t);
+        CHECK(slots[1][i] == (ModInt)((__int128)a[i] * b[i] % t));
+        CHECK(slots[2][i] == 3 * a[i] % t);
+        CHECK(slots[3][i] == (a[i] + 5) % t);
+    }
+    return true;
+}
+
+bool test_decrypt_batch() {
+    // Full-width random plaintexts at a 60-bit modulus check the exact
+    // t/q rounding on every coefficient
+    int N = 1024;
+    ModInt t = 65537;
+    Context ctx(N, t);
+    
+    std::vector<std::vector<ModInt>> plains;
+    std::vector<Ciphertext> cts;
+    for (int i = 0; i < 9; i++) {
+        plains.push_back(random_values(N, t, 90 + i));
+        cts.push_back(ctx.encryptor.encrypt(plains.back()));
+    }
+    
+    // Size-3 entries: the product with an encryption of 1
+    Ciphertext one = ctx.encrypt_constant(1);
+    for (int i = 0; i < 3; i++) {
+        cts.push_back(ctx.mult.multiply_ciphertexts(cts[i][0], cts[i][1], one[0], one[1]));
+        plains.push_back(plains[i]);
+    }
+    
+    auto decrypted = ctx.decryptor.decrypt_batch(cts);
+    CHECK(decrypted == plains);
+    for (size_t i = 0; i < cts.size(); i++) {
+        CHECK(ctx.decryptor.decrypt(cts[i]) == plains[i]);
+    }
+    CHECK(ctx.decryptor.decrypt_batch({}).empty());
+    
+    bool rejected = false;
+    try {
+        ctx.decryptor.decrypt_batch({cts[0], {cts[0][0]}});
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+    return true;
+}
+
+bool test_relinearize_digit_sizes() {
+    int N = 1024;
+    ModInt t = 65537;
+    BatchEncoder encoder(N, t);
+    std::vector<ModInt> a = random_values(N, t, 21);
+    std::vector<ModInt> b = random_values(N, t, 22);
+    
+    for (int bits : {12, 20}) {
+        Context ctx(N, t, 60, bits);
+        CHECK((int)ctx.relin_key.size() == 2 * ctx.mult.get_gadget().num_digits());
+        
+        Ciphertext ct_a = ctx.encryptor.encrypt(encoder.encode(a));
+        Ciphertext ct_b = ctx.encryptor.encrypt(encoder.encode(b));
+        Ciphertext product = ctx.mult.multiply_relinearize(ct_a, ct_b, ctx.relin_key);
+        
+        std::vector<ModInt> slots = encoder.decode(ctx.decryptor.decrypt(product));
+        for (int i = 0; i < N; i++) {
+            CHECK(slots[i] == (ModInt)((__int128)a[i] * b[i] % t));
+        }
+    }
+    return true;
+}
+
+bool test_evaluate_polynomial() {
+    // Small t leaves room for the depth-2 Paterson-Stockmeyer evaluation
+    ModInt t = 17;
+    Context ctx(1024, t);
+    std::vector<ModInt> coeffs = {3, 2, 5, 1, 0, 7};
+    
+    for (ModInt m : {0, 1, 4, 9, 16}) {
+        Ciphertext ct = ctx.encrypt_constant(m);
+        Ciphertext result = ctx.mult.evaluate_polynomial(ct[0], ct[1], coeffs, ctx.relin_key);
+        CHECK(result.size() == 2);
+        
+        ModInt expected = 0;
+        for (size_t i = coeffs.size(); i-- > 0;) {
+            expected = (expected * m + coeffs[i]) % t;
+        }
+        CHECK(ctx.decrypt_constant(result) == expected);
+    }
+    
+    // Four products (m^2, m^3, m^4 and the giant step) but three key
+    // switches: m^3 and the block combine are summed before relinearizing
+    if (Instrumentation::compiled_in()) {
+        Ciphertext ct = ctx.encrypt_constant(2);
+        Instrumentation::reset();
+        Instrumentation::set_enabled(true);
+        ctx.mult.evaluate_polynomial(ct[0], ct[1], coeffs, ctx.relin_key);
+        Instrumentation::set_enabled(false);
+        auto snap = Instrumentation::snapshot();
+        CHECK(snap.ops["multiply"].count == 4);
+        CHECK(snap.ops["relinearize"].count == 3);
+        Instrumentation::reset();
+    }
+    
+    // Degree 8: three blocks, giant steps m^4 and m^8
+    std::vector<ModInt> full(9);
+    for (size_t i = 0; i < full.size(); i++) {
+        full[i] = (ModInt)(i * i + 3) % t;
+    }
+    for (ModInt m : {0, 5, 16}) {
+        Ciphertext ct = ctx.encrypt_constant(m);
+        Ciphertext result = ctx.mult.evaluate_polynomial(ct[0], ct[1], full, ctx.relin_key);
+        ModInt expected = 0;
+        for (size_t i = full.size(); i-- > 0;) {
+            expected = (expected * m + full[i]) % t;
+        }
+        CHECK(ctx.decrypt_constant(result) == expected);
+    }
+    return true;
+}
+
+bool test_lookup() {
+    ModInt t = 17;
+    Context ctx(1024, t);
+    std::vector<ModInt> table = {7, 3, 12, 0, 5};
+    LookupTable lut(table, t);
+    
+    for (ModInt x = 0; x < (ModInt)table.size(); x++) {
+        Ciphertext ct = ctx.encrypt_constant(x);
+        Ciphertext result = ctx.mult.lookup(ct[0], ct[1], lut, ctx.relin_key);
+        CHECK(result.size() == 2);
+        CHECK(ctx.decrypt_constant(result) == table[x]);
+    }
+    return true;
+}
+
+// ============================================================================
+// Rotations
+// ============================================================================
+
+// Slot i of row r after a left rotation by step within each row
+std::vector<ModInt> rotate_rows(const std::vector<ModInt>& slots, int step) {
+    int half = (int)slots.size() / 2;
+    std::vector<ModInt> out(slots.size());
+    for (int r = 0; r < 2; r++) {
+        for (int i = 0; i < half; i++) {
+            out[r * half + i] = slots[r * half + (i + step) % half];
+        }
+    }
+    return out;
+}
+
+bool test_rotate_hoisted() {
+    int N = 1024;
+    ModInt t = 65537;
+    Context ctx(N, t);
+    BatchEncoder encoder(N, t);
+    GaloisTool galois(N, ctx.ntt.get_q());
+    
+    std::vector<int> steps = {1, 5, N / 2 - 1};
+    std::vector<uint64_t> elts;
+    for (int step : steps) {
+        elts.push_back(galois.rotation_elt(step));
+    }
+    elts.push_back(galois.column_swap_elt());
+    GaloisKeys keys(ctx.ntt, ctx.keygen.galois_keys(elts));
+    
+    std::vector<ModInt> values = random_values(N, t, 31);
+    Ciphertext ct = ctx.encryptor.encrypt(encoder.encode(values));
+    auto rotated = ctx.mult.rotate_hoisted(ct[0], ct[1], elts, keys);
+    CHECK(rotated.size() == elts.size());
+    
+    for (size_t k = 0; k < steps.size(); k++) {
+        CHECK(ctx.decryptor.invariant_noise_budget(rotated[k]) > 0);
+        CHECK(encoder.decode(ctx.decryptor.decrypt(rotated[k])) == rotate_rows(values, steps[k]));
+    }
+    
+    std::vector<ModInt> swapped(values.begin() + N / 2, values.end());
+    swapped.insert(swapped.end(), values.begin(), values.begin() + N / 2);
+    CHECK(encoder.decode(ctx.decryptor.decrypt(rotated.back())) == swapped);
+    
+    // A single rotation takes the same path
+    auto single = ctx.mult.apply_galois(ct[0], ct[1], elts[1], keys);
+    CHECK(encoder.decode(ctx.decryptor.decrypt(single)) == rotate_rows(values, steps[1]));
+    return true;
+}
+
+bool test_sum_slots() {
+    // masked_sum folds a product over every slot, which a single 60-bit
+    // modulus only supports for a smaller ring and t
+    int N = 256;
+    ModInt t = 7681;
+    Context ctx(N, t);
+    BatchEncoder encoder(N, t);
+    GaloisTool galois(N, ctx.ntt.get_q());
+    GaloisKeys keys(ctx.ntt, ctx.keygen.galois_keys(galois.sum_slots_elts()));
+    
+    std::vector<ModInt> values = random_values(N, t, 41);
+    std::vector<ModInt> mask = random_values(N, 2, 42);
+    ModInt total = 0;
+    ModInt masked_total = 0;
+    for (int i = 0; i < N; i++) {
+        total = (total + values[i]) % t;
+        masked_total = (masked_total + values[i] * mask[i]) % t;
+    }
+    
+    Ciphertext ct = ctx.encryptor.encrypt(encoder.encode(values));
+    Ciphertext sum = ctx.mult.sum_slots(ct[0], ct[1], keys);
+    CHECK(encoder.decode(ctx.decryptor.decrypt(sum)) == std::vector<ModInt>(N, total));
+    
+    Ciphertext ct_mask = ctx.encryptor.encrypt(encoder.encode(mask));
+    Ciphertext masked = ctx.mult.masked_sum(ct, ct_mask, ctx.relin_key, keys);
+    CHECK(encoder.decode(ctx.decryptor.decrypt(masked)) == std::vector<ModInt>(N, masked_total));
+    return true;
+}
+
+// ============================================================================
+// Strings
+// ============================================================================
+
+bool test_string_match() {
+    // The zero test and each fold step cost a multiplication; a single
+    // 60-bit modulus leaves room for one of each with a small ring, t and
+    // alphabet (2-character binary strings)
+    int N = 64;
+    ModInt t = 257;
+    Context ctx(N, t);
+    BatchEncoder encoder(N, t);
+    StringMatcher matcher(ctx.mult, 2, 2);
+    GaloisKeys keys(ctx.ntt, ctx.keygen.galois_keys(matcher.required_galois_elts()));
+    
+    int stride = matcher.get_stride();
+    int count = matcher.strings_per_ciphertext();
+    std::vector<ModInt> a = random_values(N, 2, 51);
+    std::vector<ModInt> b = random_values(N, 2, 52);
+    for (int k = 0; k < count; k++) {
+        int agree = k % 3 == 0 ? stride : k % 3 == 1 ? 1 : 0;   // Equal, prefix-1, random
+        for (int i = 0; i < agree; i++) {
+            b[k * stride + i] = a[k * stride + i];
+        }
+    }
+    
+    Ciphertext ct_a = ctx.encryptor.encrypt(encoder.encode(a));
+    Ciphertext ct_b = ctx.encryptor.encrypt(encoder.encode(b));
+    auto equal = encoder.decode(ctx.decryptor.decrypt(
+        matcher.equal(ct_a, ct_b, ctx.relin_key, keys)));
+    auto prefix = encoder.decode(ctx.decryptor.decrypt(
+        matcher.prefix_match(ct_a, ct_b, matcher.prefix_mask(encoder, 1), ctx.relin_key, keys)));
+    
+    for (int k = 0; k < count; k++) {
+        auto first = a.begin() + k * stride;
+        bool same = std::equal(first, first + stride, b.begin() + k * stride);
+        bool same_prefix = a[k * stride] == b[k * stride];
+        CHECK(equal[k * stride] == (ModInt)same);
+        CHECK(prefix[k * stride] == (ModInt)same_prefix);
+    }
+    return true;
+}
+
+bool test_string_match_limits() {
+    // A real-size ring with the batching prime t = 12289: one 60-bit
+    // modulus holds the depth-1 zero test of binary characters, but not
+    // the 256-character default or a fold over longer strings
+    int N = 2048;
+    ModInt t = 12289;
+    Context ctx(N, t);
+    BatchEncoder encoder(N, t);
+    
+    for (auto shape : {std::make_pair(8, (ModInt)256), std::make_pair(1, (ModInt)256),
+                       std::make_pair(2, (ModInt)2)}) {
+        bool rejected = false;
+        try {
+            StringMatcher(ctx.mult, shape.first, shape.second);
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        CHECK(rejected);
+    }
+    
+    StringMatcher matcher(ctx.mult, 1, 2);
+    CHECK(matcher.required_galois_elts().empty());
+    GaloisKeys keys(ctx.ntt, ctx.keygen.galois_keys(matcher.required_galois_elts()));
+    
+    std::vector<ModInt> a = random_values(N, 2, 53);
+    std::vector<ModInt> b = random_values(N, 2, 54);
+    Ciphertext ct_a = ctx.encryptor.encrypt(encoder.encode(a));
+    Ciphertext ct_b = ctx.encryptor.encrypt(encoder.encode(b));
+    Ciphertext result = matcher.equal(ct_a, ct_b, ctx.relin_key, keys);
+    CHECK(ctx.decryptor.invariant_noise_budget(result) > 0);
+    
+    auto equal = encoder.decode(ctx.decryptor.decrypt(result));
+    for (int i = 0; i < N; i++) {
+        CHECK(equal[i] == (ModInt)(a[i] == b[i]));
+    }
+    return true;
+}
+
+// ============================================================================
+// Linear algebra
+// ============================================================================
+
+bool test_matvec() {
+    // One plaintext product per diagonal; N=256, t=7681 keeps the budget
+    // well clear of the plaintext-size noise growth
+    int N = 256;
+    ModInt t = 7681;
+    int n = 16;
+    Context ctx(N, t);
+    BatchEncoder encoder(N, t);
+    
+    std::vector<std::vector<ModInt>> matrix(n);
+    for (int i = 0; i < n; i++) {
+        matrix[i] = random_values(n, t, 60 + i);
+    }
+    for (int i = 0; i < n; i++) {
+        matrix[i][(i + 3) % n] = 0;     // Zero diagonals are skipped
+    }
+    std::vector<ModInt> v = random_values(n, t, 59);
+    
+    DiagonalMatrix dm(ctx.mult, matrix, encoder);
+    CHECK(dm.get_baby_steps() * dm.get_giant_steps() >= n);
+    GaloisKeys keys(ctx.ntt, ctx.keygen.galois_keys(dm.required_galois_elts()));
+    
+    std::vector<ModInt> slots(N);
+    for (int s = 0; s < N; s++) slots[s] = v[s % n];
+    Ciphertext ct = ctx.encryptor.encrypt(encoder.encode(slots));
+    auto result = encoder.decode(ctx.decryptor.decrypt(dm.multiply(ct[0], ct[1], keys)));
+    
+    for (int s = 0; s < N; s++) {
+        const auto& row = matrix[s % n];
+        ModInt expected = 0;
+        for (int j = 0; j < n; j++) {
+            expected = (expected + row[j] * v[j]) % t;
+        }
+        CHECK(result[s] == expected);
+    }
+    return true;
+}
+
+bool test_inner_product() {
+    int N = 1024;
+    ModInt t = 65537;
+    Context ctx(N, t);
+    
+    int len = 300;
+    std::vector<ModInt> v = random_values(len, t, 81);
+    std::vector<std::vector<ModInt>> vectors;
+    for (int k = 0; k < 3; k++) {
+        vectors.push_back(random_values(len, t, 82 + k));
+    }
+    
+    CoeffInnerProduct ip(ctx.mult, vectors);
+    CHECK(ip.size() == vectors.size());
+    Ciphertext ct = ctx.encryptor.encrypt(encode_coeff_vector(v, N, t));
+    auto batch = ip.inner_product_batch(ct[0], ct[1]);
+    CHECK(batch.size() == vectors.size());
+    
+    for (size_t k = 0; k < vectors.size(); k++) {
+        ModInt expected = 0;
+        for (int i = 0; i < len; i++) {
+            expected = (ModInt)((expected + (__int128)v[i] * vectors[k][i]) % t);
+        }
+        CHECK(ctx.decrypt_constant(ip.inner_product(ct[0], ct[1], k)) == expected);
+        CHECK(ctx.decrypt_constant(batch[k]) == expected);
+    }
+    return true;
+}
+
+// ============================================================================
+// Parameters
+// ============================================================================
+
+bool test_noise_estimates() {
+    // The model must not overstate the budget, and with the key-switching
+    // base the evaluator uses it stays within a few bits of the measurement
+    ModInt t = 257;
+    int N = 1024;
+    for (int bits : {16, 30}) {
+        Context ctx(N, t, 60, bits);
+        NoiseModel model(N, ctx.ntt.get_q(), t, 3.2, bits);
+        GaloisTool galois(N, ctx.ntt.get_q());
+        uint64_t elt = galois.rotation_elt(1);
+        GaloisKeys keys(ctx.ntt, ctx.keygen.galois_keys({elt}, bits));
+        
+        Ciphertext ct = ctx.encrypt_constant(3);
+        Ciphertext product = ctx.mult.multiply_relinearize(ct, ct, ctx.relin_key);
+        Ciphertext rotated = ctx.mult.apply_galois(ct[0], ct[1], elt, keys);
+        
+        double fresh = model.fresh();
+        std::pair<double, int> cases[] = {
+            {model.budget(fresh), ctx.decryptor.invariant_noise_budget(ct)},
+            {model.budget(model.relinearize(model.multiply(fresh, fresh))),
+             ctx.decryptor.invariant_noise_budget(product)},
+            {model.budget(model.rotate(fresh)), ctx.decryptor.invariant_noise_budget(rotated)},
+        };
+        for (const auto& [estimate, measured] : cases) {
+            CHECK(estimate > 0);
+            CHECK(estimate <= measured + 1);
+            CHECK(measured - estimate <= 8);
+        }
+    }
+    return true;
+}
+
+bool test_planned_parameters() {
+    // The plan's modulus and decomposition base must be what the keys and
+    // evaluator use, or its budget estimate does not apply
+    ModInt t = 65537;
+    int rotations = 3;
+    ParameterPlan plan = ParameterPlanner().plan(0, t, rotations);
+    CHECK(plan.moduli.size() == 1);
+    CHECK(plan.decomp_bits > 0);
+    
+    Context ctx(plan.N, t, plan.modulus_bits, plan.decomp_bits);
+    CHECK(ctx.ntt.get_q() == plan.moduli[0]);
+    CHECK(ctx.mult.get_gadget().digit_bits() == plan.decomp_bits);
+    
+    BatchEncoder encoder(plan.N, t);
+    GaloisTool galois(plan.N, ctx.ntt.get_q());
+    uint64_t elt = galois.rotation_elt(1);
+    GaloisKeys keys(ctx.ntt, ctx.keygen.galois_keys({elt}, plan.decomp_bits));
+    
+    std::vector<ModInt> values = random_values(plan.N, t, 51);
+    Ciphertext ct = ctx.encryptor.encrypt(encoder.encode(values));
+    for (int i = 0; i < rotations; i++) {
+        ct = ctx.mult.apply_galois(ct[0], ct[1], elt, keys);
+    }
+    CHECK(ctx.decryptor.invariant_noise_budget(ct) >= (int)plan.budget_left);
+    CHECK(encoder.decode(ctx.decryptor.decrypt(ct)) == rotate_rows(values, rotations));
+    return true;
+}
+
+bool test_mod_switch_pack() {
+    int N = 1024;
+    ModInt t = 257;
+    Context ctx(N, t);
+    ModInt q = ctx.ntt.get_q();
+    ModInt q_small = find_ntt_prime(N, 30);
+    
+    std::vector<ModInt> plain = random_values(N, t, 95);
+    Ciphertext ct = ctx.encryptor.encrypt(plain);
+    Ciphertext switched = mod_switch(ct, q, q_small);
+    CHECK(switched.size() == 2);
+    for (const auto& comp : switched) {
+        CHECK(std::all_of(comp.begin(), comp.end(),
+                          [&](ModInt c) { return c >= 0 && c < q_small; }));
+    }
+    
+    // Decrypt under q_small with the same (centered) secret key
+    NTT ntt_small(N, q_small);
+    std::vector<ModInt> sk = ctx.keygen.secret_key();
+    for (auto& c : sk) {
+        ModInt centered = c > q / 2 ? c - q : c;
+        c = (centered % q_small + q_small) % q_small;
+    }
+    Decryptor small(ntt_small, t, sk);
+    CHECK(small.invariant_noise_budget(switched) > 0);
+    CHECK(small.decrypt(switched) == plain);
+    
+    // Packing round trips at both moduli, at coefficient_bits per value
+    auto round_trips = [&](const Ciphertext& c, ModInt modulus) {
+        auto packed = pack_ciphertext(c, modulus);
+        size_t bits = (size_t)coefficient_bits(modulus) * N * c.size();
+        return packed.size() == (bits + 7) / 8 &&
+               unpack_ciphertext(packed, N, (int)c.size(), modulus) == c;
+    };
+    CHECK(round_trips(ct, q));
+    CHECK(round_trips(switched, q_small));
+    CHECK(coefficient_bits(q_small) == 30);
+    return true;
+}
+
+// ============================================================================
+// Query results
+// ============================================================================
+
+bool test_table_scan_stream() {
+    ModInt t = 65537;
+    Context ctx(1024, t);
+    TableScanner scanner(ctx.mult, 3, 2);
+    
+    int rows = 11;
+    for (int row = 0; row < rows; row++) {
+        Ciphertext ct = ctx.encrypt_constant(row % 5);
+        CHECK(scanner.add_row(ct, ct) == (size_t)row);
+    }
+    
+    // Malformed payloads are rejected before anything is stored
+    Ciphertext key = ctx.encrypt_constant(1);
+    Ciphertext short_payload = key;
+    short_payload[1].resize(ctx.N() / 2);
+    bool rejected = false;
+    try {
+        scanner.add_row(key, short_payload);
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+    CHECK(scanner.num_rows() == (size_t)rows);
+    
+    std::vector<ModInt> targets = {2, 4};
+    std::vector<Ciphertext> target_cts;
+    for (ModInt v : targets) target_cts.push_back(ctx.encrypt_constant(v));
+    
+    std::vector<int> seen(rows, 0);
+    bool all_correct = true;
+    scanner.exact_match_batch(target_cts, [&](size_t row, std::vector<Ciphertext>& diffs) {
+        seen[row]++;
+        if (diffs.size() != targets.size()) {
+            all_correct = false;
+            return;
+        }
+        for (size_t qi = 0; qi < targets.size(); qi++) {
+            ModInt expected = ((ModInt)(row % 5) - targets[qi] + t) % t;
+            if (ctx.decrypt_constant(diffs[qi]) != expected) all_correct = false;
+        }
+    });
+    CHECK(all_correct);
+    CHECK(std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; }));
+    return true;
+}
+
+bool test_table_scan_parallel() {
+    // Aggregates are exact modular sums, so a pooled scan must match a
+    // single block on the caller bit for bit, and decrypt to the sums
+    ModInt t = 257;
+    Context ctx(1024, t);
+    TableScanner pooled(ctx.mult, 3, 2);
+    TableScanner serial(ctx.mult, 1, 1000);
+    CHECK(pooled.num_threads() == 3);
+    
+    int rows = 10;
+    std::vector<std::vector<Ciphertext>> masks(2);
+    std::vector<ModInt> expected_sum(2, 0);
+    for (int row = 0; row < rows; row++) {
+        Ciphertext key = ctx.encrypt_constant(row);
+        Ciphertext payload = ctx.encrypt_constant(row + 1);
+        pooled.add_row(key, payload);
+        serial.add_row(key, payload);
+        for (int qi = 0; qi < 2; qi++) {
+            bool hit = row % (qi + 2) == 0;
+            masks[qi].push_back(ctx.encrypt_constant(hit));
+            if (hit) {
+                expected_sum[qi] = (expected_sum[qi] + row + 1) % t;
+            }
+        }
+    }
+    
+    auto sums = pooled.sum_batch(masks, ctx.relin_key);
+    CHECK(sums == serial.sum_batch(masks, ctx.relin_key));
+    for (int qi = 0; qi < 2; qi++) {
+        CHECK(ctx.decrypt_constant(sums[qi]) == expected_sum[qi]);
+    }
+    
+    return true;
+}
+
+bool test_indexed_lookup() {
+    ModInt t = 65537;
+    Context ctx(1024, t);
+    TableScanner scanner(ctx.mult, 2, 2);
+    
+    // Client-side bucket tags: here key mod 3, one row left unindexed
+    int rows = 12;
+    std::vector<ModInt> keys;
+    for (int row = 0; row < rows; row++) {
+        keys.push_back(100 + row);
+        Ciphertext ct = ctx.encrypt_constant(keys.back());
+        scanner.add_row(ct, ct, row == 5 ? -1 : keys.back() % 3);
+    }
+    CHECK(scanner.rows_in_bucket(7).empty());
+    
+    std::vector<ModInt> targets = {104, 109, 999};
+    std::vector<Ciphertext> target_cts;
+    std::vector<int64_t> buckets;
+    for (ModInt v : targets) {
+        target_cts.push_back(ctx.encrypt_constant(v));
+        buckets.push_back(v % 3);
+    }
+    buckets[2] = 7;     // A bucket no row carries
+    
+    auto result = scanner.exact_match_indexed(target_cts, buckets);
+    CHECK(result.size() == targets.size());
+    CHECK(result[2].empty());
+    for (size_t qi = 0; qi < 2; qi++) {
+        std::vector<size_t> expected_rows;
+        for (int row = 0; row < rows; row++) {
+            if (row != 5 && keys[row] % 3 == targets[qi] % 3) expected_rows.push_back(row);
+        }
+        CHECK(scanner.rows_in_bucket(buckets[qi]) == expected_rows);
+        CHECK(result[qi].size() == expected_rows.size());
+        
+        size_t zeros = 0;
+        for (size_t k = 0; k < result[qi].size(); k++) {
+            size_t row = result[qi][k].first;
+            CHECK(row == expected_rows[k]);
+            ModInt diff = ctx.decrypt_constant(result[qi][k].second);
+            CHECK(diff == (keys[row] - targets[qi] + t) % t);
+            if (diff == 0) zeros++;
+        }
+        CHECK(zeros == 1);
+    }
+    
+    bool rejected = false;
+    try {
+        scanner.exact_match_indexed(target_cts, {0});
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+    return true;
+}
+
+// ============================================================================
+// Instrumentation
+// ============================================================================
+
+bool test_trace_spans() {
+    int N = 1024;
+    ModInt t = 65537;
+    Context ctx(N, t);
+    Ciphertext a = ctx.encrypt_constant(3);
+    Ciphertext b = ctx.encrypt_constant(5);
+    
+    Tracer::clear();
+    Tracer::start();
+    CHECK(Tracer::enabled());
+    Ciphertext product = ctx.mult.multiply_relinearize(a, b, ctx.relin_key);
+    Tracer::stop();
+    CHECK(!Tracer::enabled());
+    CHECK(ctx.decrypt_constant(product) == 15);
+    
+    uint64_t recorded = Tracer::recorded();
+    std::string json = Tracer::chrome_trace_json();
+    CHECK(json.rfind("{\"traceEvents\":[", 0) == 0);
+    CHECK(json.find("],\"displayTimeUnit\":\"ns\"}") == json.size() - 25);
+#ifdef FHE_ENABLE_INSTRUMENTATION
+    CHECK(recorded > 0);
+    for (const char* span : {"multiply", "tensor_product", "rescale", "relinearize",
+                             "gadget_decompose", "ntt_forward", "ntt_inverse"}) {
+        CHECK(json.find(std::string("{\"name\":\"") + span + "\"") != std::string::npos);
+    }
+#endif
+
+    // Nothing is recorded once stopped
+    ctx.mult.multiply_relinearize(a, b, ctx.relin_key);
+    CHECK(Tracer::recorded() == recorded);
+    
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("fhe_test_trace_" + std::to_string(std::random_device()()) + ".json")).string();
+    Tracer::write_chrome_trace(path);
+    std::ifstream file(path);
+    std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::filesystem::remove(path);
+    CHECK(written == json);
+    
+    bool rejected = false;
+    try {
+        Tracer::write_chrome_trace(path + ".missing/trace.json");
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+    
+    // Events past the per-thread capacity are dropped and counted; names are escaped
+    Tracer::start(2);
+    Tracer::clear();
+    const char* name = Tracer::intern("step \"quoted\"");
+    CHECK(name == Tracer::intern("step \"quoted\""));
+    for (int i = 0; i < 5; i++) {
+        uint64_t now = Tracer::now_ns();
+        Tracer::record(name, "test", now, now + 1500);
+    }
+    Tracer::stop();
+    CHECK(Tracer::recorded() == 2);
+    CHECK(Tracer::dropped() == 3);
+    json = Tracer::chrome_trace_json();
+    CHECK(json.find("\"name\":\"step \\\"quoted\\\"\",\"cat\":\"test\",\"ph\":\"X\"") != std::string::npos);
+    CHECK(json.find("\"dur\":1.500}") != std::string::npos);
+    
+    Tracer::clear();
+    CHECK(Tracer::recorded() == 0 && Tracer::dropped() == 0);
+    return true;
+}
+
+bool test_perf_counters() {
+    // Attribution of synthetic readings: only events valid at both ends
+    // and not running backwards are summed
+    PerfCounters::reset();
+    PerfReading begin{};
+    PerfReading end{};
+    auto set = [](PerfReading& r, PerfEvent e, uint64_t v) {
+        r.valid[(int)e] = true;
+        r.values[(int)e] = v;
+    };
+    set(begin, PerfEvent::Cycles, 1000);
+    set(end, PerfEvent::Cycles, 3000);
+    set(begin, PerfEvent::Instructions, 500);
+    set(end, PerfEvent::Instructions, 4500);
+    set(begin, PerfEvent::L1DMisses, 10);
+    set(end, PerfEvent::L1DMisses, 74);
+    set(begin, PerfEvent::LLCMisses, 50);
+    set(end, PerfEvent::LLCMisses, 40);
+    set(begin, PerfEvent::BranchMisses, 7);
+    PerfCounters::record(PerfKernel::Pointwise, begin, end, 32);
+    PerfCounters::record(PerfKernel::Pointwise, begin, end, 32);
+    
+    auto stats = PerfCounters::snapshot();
+    CHECK(stats.size() == 1 && stats.count("pointwise") == 1);
+    const PerfKernelStats& s = stats["pointwise"];
+    CHECK(s.calls == 2 && s.coefficients == 64);
+    CHECK(s.events.size() == 3);
+    CHECK(s.events.at("cycles") == 4000);
+    CHECK(s.events.at("instructions") == 8000);
+    CHECK(s.events.at("l1d_misses") == 128);
+    CHECK(s.ipc == 2.0);
+    CHECK(s.per_coefficient.size() == 2);
+    CHECK(s.per_coefficient.at("cycles") == 62.5);
+    CHECK(s.per_coefficient.at("l1d_misses") == 2.0);
+    PerfCounters::reset();
+    CHECK(PerfCounters::snapshot().empty());
+    
+    // Live counters around a multiplication; containers and VMs often
+    // refuse every event, in which case nothing is profiled
+    int N = 1024;
+    Context ctx(N, 65537);
+    Ciphertext a = ctx.encrypt_constant(3);
+    Ciphertext b = ctx.encrypt_constant(5);
+    bool available = PerfCounters::set_enabled(true);
+    CHECK(PerfCounters::enabled() == available);
+    Ciphertext product = ctx.mult.multiply_relinearize(a, b, ctx.relin_key);
+    PerfCounters::set_enabled(false);
+    CHECK(!PerfCounters::enabled());
+    CHECK(ctx.decrypt_constant(product) == 15);
+    
+    stats = PerfCounters::snapshot();
+#ifdef FHE_ENABLE_INSTRUMENTATION
+    if (available) {
+        CHECK(stats.count("ntt_forward") == 1 && stats.count("key_switch") == 1);
+        for (const char* kernel : {"ntt_forward", "ntt_inverse"}) {
+            if (stats.count(kernel) == 0) continue;
+            CHECK(stats[kernel].calls > 0);
+            CHECK(stats[kernel].coefficients == stats[kernel].calls * (uint64_t)N);
+        }
+        CHECK(stats["key_switch"].calls == 1);
+        CHECK(stats["key_switch"].coefficients == 2 * (uint64_t)N);
+    } else {
+        CHECK(stats.empty());
+    }
+#else
+    CHECK(stats.empty());
+#endif
+
+    // Disabled: kernels are not attributed
+    PerfCounters::reset();
+    ctx.mult.multiply_relinearize(a, b, ctx.relin_key);
+    CHECK(PerfCounters::snapshot().empty());
+    return true;
+}
+
+struct TestCase {
+    const char* name;
+    bool (*run)();
+};
+
+const TestCase kTests[] = {
+    {"thread_pool", test_thread_pool},
+    {"global_pool_release", test_global_pool_release},
+    {"ntt_tuning", test_ntt_tuning},
+    {"gadget_recompose", test_gadget_recompose},
+    {"multiply_relinearize_slots", test_multiply_relinearize_slots},
+    {"slot_arithmetic", test_slot_arithmetic},
+    {"decrypt_batch", test_decrypt_batch},
+    {"relinearize_digit_sizes", test_relinearize_digit_sizes},
+    {"evaluate_polynomial", test_evaluate_polynomial},
+    {"lookup", test_lookup},
+    {"rotate_hoisted", test_rotate_hoisted},
+    {"sum_slots", test_sum_slots},
+    {"string_match", test_string_match},
+    {"string_match_limits", test_string_match_limits},
+    {"matvec", test_matvec},
+    {"inner_product", test_inner_product},
+    {"noise_estimates", test_noise_estimates},
+    {"planned_parameters", test_planned_parameters},
+    {"mod_switch_pack", test_mod_switch_pack},
+    {"table_scan_stream", test_table_scan_stream},
+    {"table_scan_parallel", test_table_scan_parallel},
+    {"indexed_lookup", test_indexed_lookup},
+    {"trace_spans", test_trace_spans},
+    {"perf_counters", test_perf_counters},
+};
+
+bool selected(const char* name, int argc, char** argv) {
+    if (argc < 2) return true;
+    for (int i = 1; i < argc; i++) {
+        if (std::strstr(name, argv[i]) != nullptr) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int passed = 0;
+    int failed = 0;
+    
+    for (const auto& test : kTests) {
+        if (!selected(test.name, argc, argv)) continue;
+        
+        bool ok = false;
+        try {
+            ok = test.run();
+        } catch (const std::exception& e) {
+            std::printf("  exception: %s\n", e.what());
+        }
+        std::printf("[%s] %s\n", ok ? " OK " : "FAIL", test.name);
+        (ok ? passed : failed)++;
+    }
+    
+    std::printf("\n%d passed, %d failed\n", passed, failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+"""
+Test Suite for the Exact-Match Workload Benchmark
+Runs fhe_workload over tables spanning several ciphertexts (the last one
+partial) and checks the reported matches, sizes and phases in its JSON
+
+Usage:
+    python test_workload.py --workload PATH
+"""
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def run_workload(workload, args):
+    """Run fhe_workload; returns (exit status, parsed JSON or None)"""
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, 'workload.json')
+        status = subprocess.call([workload] + list(args) + ['--json', out, '--out-dir', tmp],
+                                 stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        if not os.path.exists(out):
+            return status, None
+        with open(out) as f:
+            return status, json.load(f)
+
+
+def test_matches(workload):
+    """Every query finds its rows across ciphertext boundaries"""
+    print("=" * 60)
+    print("TEST 1: Matches")
+    print("=" * 60)
+    
+    N = 1024
+    queries = 6
+    rows = [2500, 300]
+    threads = [1, 3]
+    status, result = run_workload(workload, [
+        '--rows', ','.join(map(str, rows)), '--threads', ','.join(map(str, threads)),
+        '--queries', str(queries), '--N', str(N), '--bits', '40', '--seed', '7'])
+    if status != 0 or result is None:
+        print(f"✗ fhe_workload exited with {status}")
+        return False
+    
+    ok = result['config']['N'] == N and result['config']['queries'] == queries
+    ok &= [(r['rows'], r['threads']) for r in result['runs']] == \
+        [(n, t) for n in rows for t in threads]
+    for r in result['runs']:
+        print(f"rows={r['rows']} threads={r['threads']}: {r['matches']} matches, "
+              f"{r['mismatches']} mismatches")
+        ok &= r['ciphertexts'] == (r['rows'] + N - 1) // N
+        ok &= r['mismatches'] == 0
+        # Every other target is drawn from the table, so it matches at least once
+        ok &= r['matches'] >= (queries + 1) // 2
+    
+    # The data depends on the seed only, not on the thread count
+    by_rows = {}
+    for r in result['runs']:
+        by_rows.setdefault(r['rows'], set()).add(r['matches'])
+    ok &= all(len(m) == 1 for m in by_rows.values())
+    
+    print(f"{'✓' if ok else '✗'} matches")
+    print()
+    return ok
+
+
+def test_report(workload):
+    """Sizes and per-phase latencies of a run"""
+    print("=" * 60)
+    print("TEST 2: Report")
+    print("=" * 60)
+    
+    status, result = run_workload(workload, ['--rows', '1500', '--threads', '2',
+                                             '--queries', '5', '--N', '1024', '--bits', '40'])
+    if status != 0 or result is None:
+        print(f"✗ fhe_workload exited with {status}")
+        return False
+    
+    r = result['runs'][0]
+    b = r['bytes']
+    ok = b['disk'] == b['table'] > 0
+    ok &= b['query'] * r['ciphertexts'] == b['table']
+    # Responses are mod-switched down before they are packed
+    ok &= r['response_bits'] < result['config']['modulus_bits']
+    ok &= 0 < b['response'] < b['table']
+    for name in ('query', 'decrypt'):
+        p = r['phases'][name]
+        ok &= 0 < p['p50_ms'] <= p['p90_ms'] <= p['p99_ms'] <= p['max_ms']
+    ok &= r['phases']['encrypt']['rows_per_sec'] > 0
+    ok &= r['peak_rss_kb'] > 0
+    
+    print(f"{'✓' if ok else '✗'} sizes and phases")
+    print()
+    return ok
+
+
+def test_rejected_arguments(workload):
+    """Bad arguments fail without a report"""
+    print("=" * 60)
+    print("TEST 3: Rejected Arguments")
+    print("=" * 60)
+    
+    ok = True
+    for args in (['--queries', '0'], ['--unknown'], ['--N', '1024', '--bits', '40', '--rows']):
+        status, result = run_workload(workload, args)
+        ok &= status != 0 and result is None
+    
+    print(f"{'✓' if ok else '✗'} rejected")
+    print()
+    return ok
+
+
+def run_all_tests(workload):
+    """Run complete test suite; returns True when every test passed"""
+    tests = [
+        ("Matches", test_matches),
+        ("Report", test_report),
+        ("Rejected arguments", test_rejected_arguments),
+    ]
+    
+    results = []
+    for name, run in tests:
+        try:
+            ok = bool(run(workload))
+        except Exception as e:
+            import traceback
+            print(f"\n✗ {name} raised: {e}")
+            traceback.print_exc()
+            ok = False
+        results.append((name, ok))
+    
+    passed = sum(1 for _, ok in results if ok)
+    failed = len(results) - passed
+    for name, ok in results:
+        print(f"{'✓' if ok else '✗'} {name}")
+    print(f"\n{passed} passed, {failed} failed")
+    return failed == 0
+
+
+if __name__ == "__main__":
+    if '--workload' not in sys.argv:
+        print(__doc__)
+        sys.exit(2)
+    sys.exit(0 if run_all_tests(sys.argv[sys.argv.index('--workload') + 1]) else 1)
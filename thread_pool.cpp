@@ -0,0 +1,363 @@
+/*
+ * Work-Stealing Thread Pool Implementation
+ */
+
+#include "thread_pool.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace fhe_cpp {
+
+// Pool and index of the worker running on this thread, so nested
+// parallel_for calls on the same pool run inline instead of blocking a
+// worker on tasks queued behind it; calls into other pools dispatch
+static thread_local const ThreadPool* current_pool = nullptr;
+static thread_local int worker_id = -1;
+
+namespace {
+
+// The last reference to a global pool may be dropped by a task running
+// on that pool (e.g. async work that outlived configure_global), and a
+// pool cannot join its own worker: that deletion moves to a new thread
+struct GlobalPoolDeleter {
+    void operator()(ThreadPool* pool) const {
+        if (current_pool == pool) {
+            std::thread([pool] { delete pool; }).detach();
+        } else {
+            delete pool;
+        }
+    }
+};
+
+std::mutex global_mutex;
+std::shared_ptr<ThreadPool> global_pool;
+
+// Parse a sysfs CPU list such as "0-3,8-11"
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        int lo = std::stoi(range.substr(0, dash));
+        int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+        for (int c = lo; c <= hi; c++) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+} // namespace
+
+std::vector<std::vector<int>> ThreadPool::numa_topology() {
+    std::vector<int> allowed;
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &mask)) allowed.push_back(c);
+        }
+    }
+#endif
+    if (allowed.empty()) {
+        int cores = std::max(1, (int)std::thread::hardware_concurrency());
+        for (int c = 0; c < cores; c++) allowed.push_back(c);
+    }
+    
+    std::vector<std::pair<int, std::vector<int>>> nodes;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+            !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            continue;
+        }
+        std::ifstream in(entry.path() / "cpulist");
+        std::string list;
+        std::getline(in, list);
+        std::vector<int> cpus;
+        try {
+            cpus = parse_cpu_list(list);
+        } catch (const std::exception&) {
+            continue;
+        }
+        std::vector<int> usable;
+        for (int c : cpus) {
+            if (std::binary_search(allowed.begin(), allowed.end(), c)) usable.push_back(c);
+        }
+        if (!usable.empty()) nodes.emplace_back(std::stoi(name.substr(4)), usable);
+    }
+    
+    std::vector<std::vector<int>> topology;
+    if (nodes.empty()) {
+        topology.push_back(allowed);    // No NUMA information: one node
+    } else {
+        std::sort(nodes.begin(), nodes.end());
+        for (auto& node : nodes) topology.push_back(std::move(node.second));
+    }
+    return topology;
+}
+
+ThreadPool::ThreadPool(int num_threads, bool pin_threads)
+    : num_nodes(1), pending(0), next_queue(0), stop(false), parallel_for_calls(0), inline_calls(0),
+      tasks_executed(0), tasks_stolen(0), remote_steals(0) {
+    std::vector<std::vector<int>> topology = numa_topology();
+    std::vector<int> cpus, cpu_node;
+    for (size_t n = 0; n < topology.size(); n++) {
+        for (int c : topology[n]) {
+            cpus.push_back(c);
+            cpu_node.push_back((int)n);
+        }
+    }
+    num_nodes = (int)topology.size();
+    if (num_threads <= 0) {
+        num_threads = (int)cpus.size();
+    }
+    
+    // Spread workers evenly over the CPU list, which is grouped by node,
+    // so each worker's contiguous parallel_for range stays node-local
+    std::vector<int> worker_cpu(num_threads);
+    worker_node.resize(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+        size_t idx = num_threads <= (int)cpus.size()
+            ? (size_t)i * cpus.size() / num_threads
+            : (size_t)i % cpus.size();
+        worker_cpu[i] = cpus[idx];
+        worker_node[i] = cpu_node[idx];
+    }
+    
+    steal_order.resize(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+        for (int pass = 0; pass < 2; pass++) {
+            for (int k = 1; k < num_threads; k++) {
+                int victim = (i + k) % num_threads;
+                if ((worker_node[victim] == worker_node[i]) == (pass == 0)) {
+                    steal_order[i].push_back(victim);
+                }
+            }
+        }
+    }
+    
+    for (int i = 0; i < num_threads; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (int i = 0; i < num_threads; i++) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i, pin_threads ? worker_cpu[i] : -1);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stop = true;
+    }
+    wake_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::worker_loop(int id, int cpu) {
+    current_pool = this;
+    worker_id = id;
+    
+#ifdef __linux__
+    if (cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+    }
+#else
+    (void)cpu;
+#endif
+    
+    while (true) {
+        std::function<void()> task;
+        if (try_pop(id, task) || try_steal(id, task)) {
+            task();
+            tasks_executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake_cv.wait(lock, [this] { return stop || pending.load() > 0; });
+        if (stop && pending.load() == 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::try_pop(int id, std::function<void()>& task) {
+    WorkerQueue& queue = *queues[id];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    pending--;
+    return true;
+}
+
+bool ThreadPool::try_steal(int id, std::function<void()>& task) {
+    for (int v : steal_order[id]) {
+        WorkerQueue& victim = *queues[v];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending--;
+            tasks_stolen.fetch_add(1, std::memory_order_relaxed);
+            if (worker_node[v] != worker_node[id]) {
+                remote_steals.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::push(int id, std::function<void()> task) {
+    // Count the task before it becomes visible: a worker may pop it as
+    // soon as the queue lock is released, and its decrement must not run
+    // ahead of this increment
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        pending++;
+    }
+    std::lock_guard<std::mutex> lock(queues[id]->mutex);
+    queues[id]->tasks.push_back(std::move(task));
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task) {
+    int id = current_pool == this
+        ? worker_id
+        : (int)(next_queue.fetch_add(1, std::memory_order_relaxed) % workers.size());
+    
+    // std::function needs a copyable callable, so the packaged task is shared
+    auto packaged = std::make_shared<std::packaged_task<void()>>(std::move(task));
+    std::future<void> done = packaged->get_future();
+    push(id, [packaged] { (*packaged)(); });
+    wake_cv.notify_one();
+    return done;
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || workers.size() <= 1 || current_pool == this) {
+        inline_calls.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+    
+    parallel_for_calls.fetch_add(1, std::memory_order_relaxed);
+    
+    struct State {
+        std::mutex mutex;
+        std::condition_variable done_cv;
+        size_t remaining;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->remaining = count;
+    
+    // Seed worker w with the contiguous range [w*count/W, (w+1)*count/W)
+    // in reverse, so its own pops walk the range in order
+    size_t num_workers = workers.size();
+    for (size_t w = 0; w < num_workers; w++) {
+        size_t begin = w * count / num_workers;
+        size_t end = (w + 1) * count / num_workers;
+        for (size_t i = end; i-- > begin;) {
+            push((int)w, [state, &fn, i] {
+                try {
+                    fn(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (!state->error) state->error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (--state->remaining == 0) {
+                    state->done_cv.notify_all();
+                }
+            });
+        }
+    }
+    wake_cv.notify_all();
+    
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done_cv.wait(lock, [&state] { return state->remaining == 0; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+ThreadPoolStats ThreadPool::stats() const {
+    ThreadPoolStats s;
+    s.workers = size();
+    s.numa_nodes = num_nodes;
+    s.parallel_for_calls = parallel_for_calls.load();
+    s.inline_calls = inline_calls.load();
+    s.tasks_executed = tasks_executed.load();
+    s.tasks_stolen = tasks_stolen.load();
+    s.remote_steals = remote_steals.load();
+    return s;
+}
+
+void ThreadPool::reset_stats() {
+    parallel_for_calls = 0;
+    inline_calls = 0;
+    tasks_executed = 0;
+    tasks_stolen = 0;
+    remote_steals = 0;
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::global() {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    if (!global_pool) {
+        const char* threads = std::getenv("FHE_NUM_THREADS");
+        const char* pin = std::getenv("FHE_PIN_THREADS");
+        global_pool = std::shared_ptr<ThreadPool>(
+            new ThreadPool(threads != nullptr ? std::atoi(threads) : 0,
+                           pin == nullptr || std::string(pin) != "0"),
+            GlobalPoolDeleter());
+    }
+    return global_pool;
+}
+
+void ThreadPool::configure_global(int num_threads, bool pin_threads) {
+    if (num_threads < 0) {
+        throw std::invalid_argument("num_threads must be non-negative");
+    }
+    std::shared_ptr<ThreadPool> pool(new ThreadPool(num_threads, pin_threads),
+                                     GlobalPoolDeleter());
+    std::shared_ptr<ThreadPool> old;
+    {
+        std::lock_guard<std::mutex> lock(global_mutex);
+        old = std::move(global_pool);
+        global_pool = std::move(pool);
+    }
+    // old is released outside the lock; callers still holding it finish
+    // their work before its workers are joined, and if the last of them
+    // is one of its own workers (including this thread) the join happens
+    // on a separate thread
+}
+
+} // namespace fhe_cpp
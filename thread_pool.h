@@ -0,0 +1,113 @@
+/*
+ * Work-stealing thread pool
+ * Each worker owns a deque; idle workers steal from the others, trying
+ * workers on their own NUMA node before remote ones
+ *
+ * ThreadPool::global() is the process-wide scheduler every parallel
+ * path of the backend submits to; parallel_for calls made from inside
+ * one of the pool's own workers run inline, so nested parallel paths
+ * never oversubscribe
+ */
+
+#ifndef FHE_THREAD_POOL_H
+#define FHE_THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <cstdint>
+
+namespace fhe_cpp {
+
+struct ThreadPoolStats {
+    int workers;
+    int numa_nodes;
+    uint64_t parallel_for_calls;    // Calls dispatched to the workers
+    uint64_t inline_calls;          // Calls run on the caller (nested or tiny)
+    uint64_t tasks_executed;
+    uint64_t tasks_stolen;          // Tasks run by a worker other than their owner
+    uint64_t remote_steals;         // Steals across NUMA nodes
+};
+
+class ThreadPool {
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    
+    // NUMA placement: node of each worker, and per worker the other
+    // workers in steal order (same node first)
+    std::vector<int> worker_node;
+    std::vector<std::vector<int>> steal_order;
+    int num_nodes;
+    
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    std::atomic<size_t> pending;    // Tasks being queued or queued but not yet taken
+    std::atomic<size_t> next_queue; // Round-robin target for external submits
+    bool stop;
+    
+    std::atomic<uint64_t> parallel_for_calls;
+    std::atomic<uint64_t> inline_calls;
+    std::atomic<uint64_t> tasks_executed;
+    std::atomic<uint64_t> tasks_stolen;
+    std::atomic<uint64_t> remote_steals;
+    
+    void worker_loop(int id, int cpu);
+    
+    // Owner takes from the back (most recently pushed, still in cache),
+    // thieves take from the front (oldest, largest remaining range)
+    bool try_pop(int id, std::function<void()>& task);
+    bool try_steal(int id, std::function<void()>& task);
+    
+    void push(int id, std::function<void()> task);
+
+public:
+    // num_threads = 0 uses one worker per CPU this process may run on
+    // With pin_threads, workers fill NUMA nodes in order, one per core
+    explicit ThreadPool(int num_threads = 0, bool pin_threads = true);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    // Run fn(i) for i in [0, count) and wait for all of them
+    // Iterations start on contiguous per-worker ranges; the first
+    // exception thrown by any iteration is rethrown here
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn);
+    
+    // Queue one task and return immediately; the future becomes ready when
+    // the task has run and rethrows anything it threw from get()
+    // From a worker the task goes to that worker's queue, otherwise
+    // queues are filled round-robin
+    std::future<void> submit(std::function<void()> task);
+    
+    int size() const { return (int)workers.size(); }
+    int numa_nodes() const { return num_nodes; }
+    ThreadPoolStats stats() const;
+    void reset_stats();
+    
+    // Process-wide pool, created on first use with FHE_NUM_THREADS workers
+    // (default: all CPUs), pinned unless FHE_PIN_THREADS=0
+    // Callers hold the returned pointer for the duration of their work,
+    // so configure_global can swap the pool while others still use it
+    static std::shared_ptr<ThreadPool> global();
+    static void configure_global(int num_threads, bool pin_threads = true);
+    
+    // CPUs of each NUMA node, restricted to this process's affinity mask
+    static std::vector<std::vector<int>> numa_topology();
+};
+
+} // namespace fhe_cpp
+
+#endif // FHE_THREAD_POOL_H
@@ -0,0 +1,177 @@
+/*
+ * Tracer Implementation
+ */
+
+#include "trace.h"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace fhe_cpp {
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+// Written only by its owning thread; readers see [0, size) after an
+// acquire load, and the storage is never reallocated while recording
+struct ThreadBuffer {
+    int tid;
+    std::vector<TraceEvent> events;
+    std::atomic<size_t> size{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+size_t capacity = 1 << 16;
+std::atomic<uint64_t> generation(0);   // Bumped by start(): buffers are re-sized
+std::set<std::string> interned;
+
+thread_local ThreadBuffer* local_buffer = nullptr;
+thread_local uint64_t local_generation = 0;
+
+ThreadBuffer* buffer_for_this_thread() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    if (local_buffer == nullptr) {
+        registry.push_back(std::make_unique<ThreadBuffer>());
+        local_buffer = registry.back().get();
+        local_buffer->tid = (int)registry.size();
+    }
+    if (local_generation != generation.load()) {
+        local_buffer->events.assign(capacity, TraceEvent{});
+        local_buffer->size.store(0, std::memory_order_relaxed);
+        local_generation = generation.load();
+    }
+    return local_buffer;
+}
+
+void append_escaped(std::ostringstream& out, const char* s) {
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') out << '\\';
+        out << *s;
+    }
+}
+
+} // namespace
+
+std::atomic<bool> Tracer::active(false);
+
+void Tracer::start(size_t max_events_per_thread) {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        capacity = max_events_per_thread;
+        generation.fetch_add(1);
+    }
+    active.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop() {
+    active.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& buf : registry) {
+        buf->size.store(0, std::memory_order_relaxed);
+        buf->dropped.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t Tracer::now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char* name, const char* category,
+                    uint64_t start_ns, uint64_t end_ns) {
+    ThreadBuffer* buf = local_buffer;
+    if (buf == nullptr || local_generation != generation.load(std::memory_order_relaxed)) {
+        buf = buffer_for_this_thread();
+    }
+    
+    size_t n = buf->size.load(std::memory_order_relaxed);
+    if (n >= buf->events.size()) {
+        buf->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buf->events[n] = TraceEvent{name, category, start_ns, end_ns};
+    buf->size.store(n + 1, std::memory_order_release);
+}
+
+const char* Tracer::intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    return interned.insert(name).first->c_str();
+}
+
+std::string Tracer::chrome_trace_json() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    
+    std::ostringstream out;
+    out.precision(3);
+    out << std::fixed << "{\"traceEvents\":[";
+    bool first = true;
+    
+    for (const auto& buf : registry) {
+        if (!first) out << ",";
+        first = false;
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buf->tid
+            << ",\"args\":{\"name\":\"thread-" << buf->tid << "\"}}";
+        
+        size_t n = buf->size.load(std::memory_order_acquire);
+        for (size_t i = 0; i < n; i++) {
+            const TraceEvent& e = buf->events[i];
+            out << ",{\"name\":\"";
+            append_escaped(out, e.name);
+            out << "\",\"cat\":\"";
+            append_escaped(out, e.category);
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buf->tid
+                << ",\"ts\":" << e.start_ns / 1000.0
+                << ",\"dur\":" << (e.end_ns - e.start_ns) / 1000.0 << "}";
+        }
+    }
+    out << "],\"displayTimeUnit\":\"ns\"}";
+    return out.str();
+}
+
+void Tracer::write_chrome_trace(const std::string& path) {
+    std::string json = chrome_trace_json();
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open trace file: " + path);
+    }
+    file << json;
+    if (!file) {
+        throw std::runtime_error("Failed writing trace file: " + path);
+    }
+}
+
+uint64_t Tracer::recorded() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    uint64_t total = 0;
+    for (const auto& buf : registry) {
+        total += buf->size.load(std::memory_order_acquire);
+    }
+    return total;
+}
+
+uint64_t Tracer::dropped() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    uint64_t total = 0;
+    for (const auto& buf : registry) {
+        total += buf->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+} // namespace fhe_cpp
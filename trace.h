@@ -0,0 +1,82 @@
+/*
+ * Event tracing in Chrome trace format (chrome://tracing, Perfetto)
+ * Spans are appended to per-thread buffers without locking and written out
+ * as JSON on demand. Compiled in with FHE_ENABLE_INSTRUMENTATION and
+ * recorded only between Tracer::start() and Tracer::stop()
+ */
+
+#ifndef FHE_TRACE_H
+#define FHE_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace fhe_cpp {
+
+class Tracer {
+private:
+    static std::atomic<bool> active;
+
+public:
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+    
+    // Begin recording; each thread keeps up to max_events_per_thread spans
+    // and drops (and counts) the rest
+    static void start(size_t max_events_per_thread = 1 << 16);
+    static void stop();
+    
+    // Discard recorded spans; call while no spans are being recorded
+    static void clear();
+    
+    // Monotonic clock used for span timestamps
+    static uint64_t now_ns();
+    
+    // name and category must outlive the tracer (string literals or intern())
+    static void record(const char* name, const char* category,
+                       uint64_t start_ns, uint64_t end_ns);
+    
+    // Stable copy of a dynamic name (e.g. spans recorded from Python)
+    static const char* intern(const std::string& name);
+    
+    static std::string chrome_trace_json();
+    
+    // Throws std::runtime_error if the file cannot be written
+    static void write_chrome_trace(const std::string& path);
+    
+    static uint64_t recorded();
+    static uint64_t dropped();
+};
+
+// Records its own lifetime as a complete ("X") event
+class TraceSpan {
+private:
+    const char* name;
+    const char* category;
+    uint64_t start;
+    bool on;
+
+public:
+    TraceSpan(const char* name, const char* category)
+        : name(name), category(category), start(0), on(Tracer::enabled()) {
+        if (on) start = Tracer::now_ns();
+    }
+    
+    ~TraceSpan() {
+        if (on) Tracer::record(name, category, start, Tracer::now_ns());
+    }
+    
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+} // namespace fhe_cpp
+
+#ifdef FHE_ENABLE_INSTRUMENTATION
+#define FHE_TRACE_SPAN(name, category) ::fhe_cpp::TraceSpan fhe_trace_span_(name, category)
+#else
+#define FHE_TRACE_SPAN(name, category) do {} while (0)
+#endif
+
+#endif // FHE_TRACE_H
@@ -0,0 +1,70 @@
+/*
+ * NTT autotuning tool (fhe_tune)
+ * Benchmarks every NTT variant for each (N, modulus size) pair on this
+ * machine, plus the batch size from which batched transforms pay off on
+ * the thread pool, and saves the results to the tuning profile that NTT
+ * construction reads
+ *
+ * Usage: fhe_tune [--N 1024,2048,4096,8192,16384] [--bits 30,40,50,60]
+ *                 [--reps 20] [--file PATH] [--dry-run]
+ */
+
+#include "ntt_tuning.h"
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace fhe_cpp;
+
+namespace {
+
+std::vector<int> parse_list(const std::string& arg) {
+    std::vector<int> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<int> ring_sizes = {1024, 2048, 4096, 8192, 16384};
+    std::vector<int> modulus_bits = {30, 40, 50, 60};
+    int reps = 20;
+    bool save = true;
+    
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--N") ring_sizes = parse_list(value());
+            else if (arg == "--bits") modulus_bits = parse_list(value());
+            else if (arg == "--reps") reps = std::stoi(value());
+            else if (arg == "--file") NttTuner::set_profile_path(value());
+            else if (arg == "--dry-run") save = false;
+            else throw std::invalid_argument("Unknown argument: " + arg);
+        }
+        
+        std::printf("Tuning NTT kernels on %s\n", NttTuner::cpu_model().c_str());
+        for (const auto& e : NttTuner::tune(ring_sizes, modulus_bits, reps, save)) {
+            std::printf("N=%-6d bits=%-3d %-14s forward %10.1f us  inverse %10.1f us  "
+                        "parallel from %d\n",
+                        e.N, e.modulus_bits, ntt_variant_name(e.variant),
+                        e.forward_ns / 1000.0, e.inverse_ns / 1000.0, e.parallel_batch);
+        }
+        if (save) {
+            std::printf("Saved to %s\n", NttTuner::profile_path().c_str());
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "fhe_tune: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,379 @@
+/*
+ * End-to-end exact-match workload benchmark (fhe_workload)
+ * Synthesizes a key column of configurable size, packs N rows per
+ * ciphertext with batching and runs the client/server exact-match flow
+ * through the native engine:
+ *
+ *   encrypt  client encodes and encrypts the table
+ *   upload   table packed to bytes (wire / disk) and unpacked by the server
+ *   query    server subtracts the encrypted target from every ciphertext,
+ *            switches the result to the smallest safe modulus and packs it
+ *   decrypt  client unpacks, decrypts and decodes; zero slots are matches
+ *
+ * For every (rows, threads) point it reports per-phase throughput, per-query
+ * latency percentiles, peak RSS and bytes on the wire and on disk, and
+ * checks the matches against the generated data.
+ *
+ * Usage: fhe_workload [--rows 1000,10000,100000,1000000] [--threads 1,8]
+ *                     [--queries 16] [--N 4096] [--bits 50] [--seed 1]
+ *                     [--out-dir DIR] [--json out.json] [--smoke]
+ */
+
+#include "ntt.h"
+#include "bfv_mult.h"
+#include "batch_encoder.h"
+#include "encryptor.h"
+#include "decryptor.h"
+#include "modulus_switch.h"
+#include "noise.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fhe_cpp;
+
+namespace {
+
+typedef std::vector<std::vector<ModInt>> Ciphertext;
+
+struct Options {
+    std::vector<size_t> rows = {1000, 10000, 100000, 1000000};
+    std::vector<int> threads;
+    int queries = 16;
+    int N = 4096;
+    int bits = 50;
+    ModInt t = 65537;
+    uint64_t seed = 1;
+    std::string out_dir;
+    std::string json_path;
+};
+
+struct Phase {
+    double seconds = 0;
+    std::vector<double> latencies_ms;   // Per query (query/decrypt phases)
+};
+
+struct Run {
+    size_t rows;
+    int threads;
+    size_t ciphertexts;
+    int response_bits;
+    Phase encrypt, upload, query, decrypt;
+    size_t table_bytes = 0;             // Packed table (upload)
+    size_t disk_bytes = 0;              // Table file, when --out-dir is set
+    size_t query_bytes = 0;             // One packed query ciphertext
+    size_t response_bytes = 0;          // Packed response of one query
+    long peak_rss_kb = 0;
+    size_t matches = 0;
+    size_t mismatches = 0;              // Slots disagreeing with the data
+};
+
+std::vector<size_t> parse_sizes(const std::string& arg) {
+    std::vector<size_t> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        values.push_back((size_t)std::stoull(item));
+    }
+    return values;
+}
+
+Options parse_args(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+            return argv[++i];
+        };
+        if (arg == "--rows") opt.rows = parse_sizes(value());
+        else if (arg == "--threads") {
+            opt.threads.clear();
+            for (size_t n : parse_sizes(value())) opt.threads.push_back((int)n);
+        }
+        else if (arg == "--queries") opt.queries = std::stoi(value());
+        else if (arg == "--N") opt.N = std::stoi(value());
+        else if (arg == "--bits") opt.bits = std::stoi(value());
+        else if (arg == "--seed") opt.seed = std::stoull(value());
+        else if (arg == "--out-dir") opt.out_dir = value();
+        else if (arg == "--json") opt.json_path = value();
+        else if (arg == "--smoke") {
+            opt.rows = {1000};
+            opt.threads = {1, 2};
+            opt.queries = 2;
+            opt.N = 1024;
+            opt.bits = 40;
+        } else {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+    if (opt.threads.empty()) {
+        // 1, 2, 4, ... and all cores
+        int cores = std::max(1, (int)std::thread::hardware_concurrency());
+        for (int n = 1; n < cores; n *= 2) opt.threads.push_back(n);
+        opt.threads.push_back(cores);
+    }
+    if (opt.queries < 1) throw std::invalid_argument("--queries must be at least 1");
+    return opt;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    double pos = p * (v.size() - 1);
+    size_t lo = (size_t)pos;
+    size_t hi = std::min(lo + 1, v.size() - 1);
+    return v[lo] + (v[hi] - v[lo]) * (pos - lo);
+}
+
+// Peak resident set since the last reset_peak_rss(), from VmHWM
+long peak_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) return std::stol(line.substr(6));
+    }
+    return 0;
+}
+
+void reset_peak_rss() {
+    std::ofstream clear("/proc/self/clear_refs");
+    if (clear) clear << "5";
+}
+
+Run run_point(const Options& opt, size_t rows, int threads) {
+    const int N = opt.N;
+    const ModInt t = opt.t;
+    ModInt q = find_ntt_prime(N, opt.bits);
+    BFVMultiplier mult(N, q, t);
+    const NTT& ntt = mult.get_ntt();
+    BatchEncoder encoder(N, t);
+    ThreadPool pool(threads);
+    
+    reset_peak_rss();
+    
+    Run run;
+    run.rows = rows;
+    run.threads = threads;
+    run.ciphertexts = (rows + N - 1) / N;
+    
+    // Synthetic data: keys drawn from a range about the size of the table,
+    // so most targets match a few rows; half the targets are present keys
+    std::mt19937_64 rng(opt.seed);
+    ModInt key_space = std::min<ModInt>(t - 1, std::max<ModInt>(16, (ModInt)rows));
+    std::uniform_int_distribution<ModInt> key_dist(0, key_space - 1);
+    std::vector<ModInt> keys(rows);
+    for (auto& k : keys) k = key_dist(rng);
+    std::vector<ModInt> targets(opt.queries);
+    for (int i = 0; i < opt.queries; i++) {
+        targets[i] = (i % 2 == 0) ? keys[rng() % rows] : key_dist(rng);
+    }
+    
+    KeyGenerator keygen(ntt, 3.2, opt.seed);
+    auto pk = keygen.public_key();
+    std::vector<std::unique_ptr<Encryptor>> encryptors;
+    for (int w = 0; w < pool.size(); w++) {
+        encryptors.push_back(std::make_unique<Encryptor>(ntt, t, pk, 3.2, opt.seed + 1 + w));
+    }
+    
+    // Responses go back at the smallest modulus the noise model allows
+    NoiseModel noise(N, q, t, 3.2, DEFAULT_DECOMP_BITS);
+    run.response_bits = noise.min_modulus_bits(noise.add(noise.fresh(), noise.fresh()));
+    ModInt q_resp = find_ntt_prime(N, run.response_bits);
+    NTT ntt_resp(N, q_resp);
+    std::vector<ModInt> sk_centered = keygen.secret_key();
+    for (auto& s : sk_centered) {
+        if (s > q / 2) s -= q;
+    }
+    Decryptor decryptor(ntt_resp, t, sk_centered);
+    
+    // encrypt: encryptors own their RNG, so each of the pool's tasks takes
+    // one encryptor and a strided share of the ciphertexts
+    std::vector<Ciphertext> table(run.ciphertexts);
+    size_t workers = (size_t)pool.size();
+    auto start = std::chrono::steady_clock::now();
+    pool.parallel_for(workers, [&](size_t w) {
+        for (size_t c = w; c < run.ciphertexts; c += workers) {
+            size_t begin = c * N;
+            size_t end = std::min(rows, begin + N);
+            std::vector<ModInt> slots(keys.begin() + begin, keys.begin() + end);
+            table[c] = encryptors[w]->encrypt(encoder.encode(slots));
+        }
+    });
+    run.encrypt.seconds = seconds_since(start);
+    
+    // upload: pack on the client, optionally persist, unpack on the server
+    start = std::chrono::steady_clock::now();
+    std::vector<std::vector<uint8_t>> packed(run.ciphertexts);
+    pool.parallel_for(run.ciphertexts, [&](size_t c) {
+        packed[c] = pack_ciphertext(table[c], q);
+    });
+    for (const auto& p : packed) run.table_bytes += p.size();
+    if (!opt.out_dir.empty()) {
+        std::string path = opt.out_dir + "/table_" + std::to_string(rows) + ".bin";
+        std::ofstream file(path, std::ios::binary);
+        for (const auto& p : packed) {
+            file.write(reinterpret_cast<const char*>(p.data()), (std::streamsize)p.size());
+        }
+        file.close();
+        std::ifstream size_check(path, std::ios::binary | std::ios::ate);
+        run.disk_bytes = (size_t)size_check.tellg();
+    }
+    std::vector<Ciphertext> server_table(run.ciphertexts);
+    pool.parallel_for(run.ciphertexts, [&](size_t c) {
+        server_table[c] = unpack_ciphertext(packed[c], N, 2, q);
+    });
+    run.upload.seconds = seconds_since(start);
+    packed.clear();
+    packed.shrink_to_fit();
+    table.clear();
+    table.shrink_to_fit();
+    
+    // Encrypted queries (client side, not timed as a phase)
+    std::vector<Ciphertext> query_cts;
+    for (ModInt target : targets) {
+        std::vector<ModInt> slots(N, target);
+        query_cts.push_back(encryptors[0]->encrypt(encoder.encode(slots)));
+    }
+    run.query_bytes = pack_ciphertext(query_cts[0], q).size();
+    
+    // query (server) then decrypt (client), one query at a time so the
+    // per-query latency is what a single request would see
+    for (int qi = 0; qi < opt.queries; qi++) {
+        auto q_start = std::chrono::steady_clock::now();
+        std::vector<std::vector<uint8_t>> response(run.ciphertexts);
+        pool.parallel_for(run.ciphertexts, [&](size_t c) {
+            Ciphertext diff = {ntt.subtract(server_table[c][0], query_cts[qi][0]),
+                               ntt.subtract(server_table[c][1], query_cts[qi][1])};
+            response[c] = pack_ciphertext(mod_switch(diff, q, q_resp), q_resp);
+        });
+        double q_secs = seconds_since(q_start);
+        run.query.seconds += q_secs;
+        run.query.latencies_ms.push_back(q_secs * 1e3);
+        if (qi == 0) {
+            for (const auto& r : response) run.response_bytes += r.size();
+        }
+        
+        auto d_start = std::chrono::steady_clock::now();
+        std::vector<size_t> found(run.ciphertexts, 0);
+        std::vector<size_t> wrong(run.ciphertexts, 0);
+        pool.parallel_for(run.ciphertexts, [&](size_t c) {
+            auto slots = encoder.decode(decryptor.decrypt(unpack_ciphertext(response[c], N, 2, q_resp)));
+            size_t begin = c * N;
+            for (size_t s = 0; s < (size_t)N && begin + s < rows; s++) {
+                bool match = slots[s] == 0;
+                found[c] += match;
+                wrong[c] += match != (keys[begin + s] == targets[qi]);
+            }
+        });
+        double d_secs = seconds_since(d_start);
+        run.decrypt.seconds += d_secs;
+        run.decrypt.latencies_ms.push_back(d_secs * 1e3);
+        for (size_t c = 0; c < run.ciphertexts; c++) {
+            run.matches += found[c];
+            run.mismatches += wrong[c];
+        }
+    }
+    
+    run.peak_rss_kb = peak_rss_kb();
+    return run;
+}
+
+void print_run(const Run& r, int queries) {
+    std::printf("rows=%-8zu threads=%-3d cts=%-5zu | encrypt %9.0f rows/s | upload %7.1f MB/s | "
+                "query p50 %8.2f ms p99 %8.2f ms (%9.0f rows/s) | decrypt p50 %8.2f ms | "
+                "rss %6.1f MB | table %7.2f MB | response %6.2f MB | %s\n",
+                r.rows, r.threads, r.ciphertexts,
+                r.rows / r.encrypt.seconds,
+                r.table_bytes / 1e6 / r.upload.seconds,
+                percentile(r.query.latencies_ms, 0.5), percentile(r.query.latencies_ms, 0.99),
+                r.rows * (double)queries / r.query.seconds,
+                percentile(r.decrypt.latencies_ms, 0.5),
+                r.peak_rss_kb / 1024.0, r.table_bytes / 1e6, r.response_bytes / 1e6,
+                r.mismatches == 0 ? "ok" : "MISMATCH");
+}
+
+void write_phase(std::ofstream& out, const char* name, const Phase& p, double units,
+                 const char* unit_name, bool last) {
+    out << "        \"" << name << "\": {\"seconds\": " << p.seconds
+        << ", \"" << unit_name << "_per_sec\": " << (p.seconds > 0 ? units / p.seconds : 0.0);
+    if (!p.latencies_ms.empty()) {
+        out << ", \"p50_ms\": " << percentile(p.latencies_ms, 0.5)
+            << ", \"p90_ms\": " << percentile(p.latencies_ms, 0.9)
+            << ", \"p99_ms\": " << percentile(p.latencies_ms, 0.99)
+            << ", \"max_ms\": " << *std::max_element(p.latencies_ms.begin(), p.latencies_ms.end());
+    }
+    out << "}" << (last ? "" : ",") << "\n";
+}
+
+void write_json(const Options& opt, const std::vector<Run>& runs, const std::string& path) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot open " + path);
+    out << "{\n  \"config\": {\"N\": " << opt.N << ", \"modulus_bits\": " << opt.bits
+        << ", \"t\": " << opt.t << ", \"queries\": " << opt.queries
+        << ", \"seed\": " << opt.seed
+        << ", \"num_cpus\": " << std::thread::hardware_concurrency() << "},\n  \"runs\": [\n";
+    for (size_t i = 0; i < runs.size(); i++) {
+        const Run& r = runs[i];
+        double scanned = (double)r.rows * opt.queries;
+        out << "    {\n      \"rows\": " << r.rows << ", \"threads\": " << r.threads
+            << ", \"ciphertexts\": " << r.ciphertexts
+            << ", \"response_bits\": " << r.response_bits << ",\n      \"phases\": {\n";
+        write_phase(out, "encrypt", r.encrypt, (double)r.rows, "rows", false);
+        write_phase(out, "upload", r.upload, (double)r.table_bytes, "bytes", false);
+        write_phase(out, "query", r.query, scanned, "rows", false);
+        write_phase(out, "decrypt", r.decrypt, scanned, "rows", true);
+        out << "      },\n      \"bytes\": {\"table\": " << r.table_bytes
+            << ", \"disk\": " << r.disk_bytes
+            << ", \"query\": " << r.query_bytes
+            << ", \"response\": " << r.response_bytes << "},\n"
+            << "      \"peak_rss_kb\": " << r.peak_rss_kb
+            << ", \"matches\": " << r.matches
+            << ", \"mismatches\": " << r.mismatches << "\n    }"
+            << (i + 1 < runs.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options opt = parse_args(argc, argv);
+        if (!BatchEncoder::supports(opt.N, opt.t)) {
+            throw std::invalid_argument("t does not support batching for this N");
+        }
+        
+        std::vector<Run> runs;
+        bool ok = true;
+        for (size_t rows : opt.rows) {
+            for (int threads : opt.threads) {
+                runs.push_back(run_point(opt, rows, std::max(1, threads)));
+                print_run(runs.back(), opt.queries);
+                ok = ok && runs.back().mismatches == 0;
+            }
+        }
+        
+        if (!opt.json_path.empty()) {
+            write_json(opt, runs, opt.json_path);
+            std::printf("Wrote %zu runs to %s\n", runs.size(), opt.json_path.c_str());
+        }
+        return ok ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "fhe_workload: %s\n", e.what());
+        return 1;
+    }
+}